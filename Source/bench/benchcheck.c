@@ -0,0 +1,241 @@
+/*
+ * Codex - benchmark regression check
+ *
+ * Compares benchmark results against a stored baseline and fails when a
+ * metric got slower by more than its noise allows.  Both benchdriver and
+ * microbench output are understood: every result is one line of JSON with
+ * a name (or mode), a median and its median absolute deviation (MAD).
+ *
+ * A metric regresses when
+ *
+ *     current > baseline + max(tolerance * baseline, k * (MAD_baseline + MAD_current))
+ *
+ * so quiet metrics are held to the relative tolerance and noisy ones get
+ * room in proportion to how much they scattered between repeated runs.
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_METRICS 256
+#define MAX_NAME 64
+#define MAX_JSON_LINE 1024
+#define DEFAULT_TOLERANCE 15.0     /* Percent slowdown always allowed */
+#define DEFAULT_MAD_FACTOR 3.0     /* Extra room per unit of combined MAD */
+#define PERCENT_SCALE 100.0
+
+typedef struct {
+    char name[MAX_NAME];
+    char unit[MAX_NAME];
+    double median;
+    double mad;
+} Metric;
+
+typedef struct {
+    Metric metrics[MAX_METRICS];
+    int count;
+} MetricSet;
+
+static double tolerance = DEFAULT_TOLERANCE;
+static double mad_factor = DEFAULT_MAD_FACTOR;
+
+/* Copies the string value of "key" on this line, if any */
+static int json_string(const char *line, const char *key, char *value, size_t size) {
+    const char *p = strstr(line, key);
+    size_t n = 0;
+
+    if (!p) return 0;
+    p = strchr(p + strlen(key), '"');
+    if (!p) return 0;
+    p++;
+    while (*p && *p != '"' && n < size - 1) value[n++] = *p++;
+    value[n] = '\0';
+    return 1;
+}
+
+static int json_number(const char *line, const char *key, double *value) {
+    const char *p = strstr(line, key);
+    char *end;
+
+    if (!p) return 0;
+    p = strchr(p + strlen(key), ':');
+    if (!p) return 0;
+    *value = strtod(p + 1, &end);
+    return end != p + 1;
+}
+
+/* Reads benchdriver ("mode", cpu_s) or microbench ("name", median) results */
+static int load_metrics(const char *filename, MetricSet *set) {
+    char line[MAX_JSON_LINE];
+    FILE *file = fopen(filename, "r");
+
+    if (!file) {
+        fprintf(stderr, "benchcheck: cannot open '%s'\n", filename);
+        return 0;
+    }
+    set->count = 0;
+    while (fgets(line, sizeof(line), file) && set->count < MAX_METRICS) {
+        Metric *metric = &set->metrics[set->count];
+        char mode[MAX_NAME];
+
+        if (json_string(line, "\"mode\"", mode, sizeof(mode)) &&
+            json_number(line, "\"cpu_s\"", &metric->median) &&
+            json_number(line, "\"cpu_mad_s\"", &metric->mad)) {
+            sprintf(metric->name, "throughput/%.40s", mode);
+            strcpy(metric->unit, "s");
+            set->count++;
+        } else if (json_string(line, "\"name\"", metric->name, sizeof(metric->name)) &&
+                   json_number(line, "\"median\"", &metric->median) &&
+                   json_number(line, "\"mad\"", &metric->mad)) {
+            if (!json_string(line, "\"unit\"", metric->unit, sizeof(metric->unit))) metric->unit[0] = '\0';
+            set->count++;
+        }
+    }
+    fclose(file);
+    if (set->count == 0) {
+        fprintf(stderr, "benchcheck: no results in '%s'\n", filename);
+        return 0;
+    }
+    return 1;
+}
+
+static const Metric *find_metric(const MetricSet *set, const char *name) {
+    int i;
+
+    for (i = 0; i < set->count; i++) {
+        if (strcmp(set->metrics[i].name, name) == 0) return &set->metrics[i];
+    }
+    return NULL;
+}
+
+/* Slowdown this metric may show before it counts as a regression */
+static double allowed_slowdown(const Metric *base, const Metric *now) {
+    double allowed = base->median * tolerance / PERCENT_SCALE;
+    double noise = mad_factor * (base->mad + now->mad);
+
+    return noise > allowed ? noise : allowed;
+}
+
+/* Prints one comparison table; returns the number of regressions */
+static int compare(const char *baseline_name, const char *current_name) {
+    static MetricSet baseline;
+    static MetricSet current;
+    int regressions = 0;
+    int i;
+
+    if (!load_metrics(baseline_name, &baseline) || !load_metrics(current_name, &current)) return -1;
+
+    printf("\n%s vs %s\n", current_name, baseline_name);
+    printf("%-36s %12s %12s %8s %8s  %s\n", "Metric", "Baseline", "Current", "Change", "Allowed", "Status");
+    for (i = 0; i < baseline.count; i++) {
+        const Metric *base = &baseline.metrics[i];
+        const Metric *now = find_metric(&current, base->name);
+        double allowed;
+        double change;
+
+        if (!now) {
+            printf("%-36s %12.3f %12s %8s %8s  missing\n", base->name, base->median, "-", "-", "-");
+            continue;
+        }
+        allowed = allowed_slowdown(base, now);
+        change = base->median > 0 ? PERCENT_SCALE * (now->median - base->median) / base->median : 0.0;
+
+        printf("%-36s %12.3f %12.3f %+7.1f%% %+7.1f%%  ", base->name, base->median, now->median, change,
+               base->median > 0 ? PERCENT_SCALE * allowed / base->median : 0.0);
+        if (now->median > base->median + allowed) {
+            printf("REGRESSED\n");
+            regressions++;
+        } else if (now->median < base->median - allowed) {
+            printf("faster\n");
+        } else {
+            printf("ok\n");
+        }
+    }
+    for (i = 0; i < current.count; i++) {
+        if (!find_metric(&baseline, current.metrics[i].name)) {
+            printf("%-36s %12s %12.3f %8s %8s  new, not in baseline\n", current.metrics[i].name, "-",
+                   current.metrics[i].median, "-", "-");
+        }
+    }
+
+    /* Repeat the failures at the end so they are easy to find in a log */
+    for (i = 0; i < baseline.count; i++) {
+        const Metric *base = &baseline.metrics[i];
+        const Metric *now = find_metric(&current, base->name);
+        if (!now) continue;
+        if (now->median > base->median + allowed_slowdown(base, now)) {
+            printf("Regression: %s is %.1f%% slower (%.3f -> %.3f %s)\n", base->name,
+                   PERCENT_SCALE * (now->median - base->median) / base->median,
+                   base->median, now->median, base->unit);
+        }
+    }
+    return regressions;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: benchcheck [-tolerance PCT] [-k FACTOR] BASELINE CURRENT [BASELINE CURRENT]...\n\n");
+    fprintf(stderr, "  -tolerance PCT  Slowdown always allowed (default %.0f%%)\n", DEFAULT_TOLERANCE);
+    fprintf(stderr, "  -k FACTOR       Extra room per unit of baseline + current MAD (default %.1f)\n", DEFAULT_MAD_FACTOR);
+}
+
+int main(int argc, char **argv) {
+    int regressions = 0;
+    int pairs = 0;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i += 2) {
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (strcmp(argv[i], "-tolerance") == 0) tolerance = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "-k") == 0) mad_factor = atof(argv[i + 1]);
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (i >= argc || (argc - i) % 2 != 0) {
+        usage();
+        return 1;
+    }
+    for (; i < argc; i += 2) {
+        int result = compare(argv[i], argv[i + 1]);
+        if (result < 0) return 1;
+        regressions += result;
+        pairs++;
+    }
+
+    if (regressions > 0) {
+        printf("\nbench-check FAILED: %d regressed metric%s\n", regressions, regressions == 1 ? "" : "s");
+        return 1;
+    }
+    printf("\nbench-check passed (%d comparison%s)\n", pairs, pairs == 1 ? "" : "s");
+    return 0;
+}
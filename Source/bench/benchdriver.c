@@ -0,0 +1,366 @@
+/*
+ * Codex - throughput benchmark driver
+ *
+ * Runs a host build of Codex over a set of input files once per validation
+ * mode, repeats every run (cycling through the modes so machine drift is
+ * shared between them), and writes the median wall and CPU time (with
+ * their median absolute deviation) together with MB/s, lines/s and
+ * diagnostics/s as JSON.  This is a POSIX program
+ * (fork/exec, clock_gettime, getrusage) and is built by VMakefile only.
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#define DEFAULT_CODEX "./codex"
+#define DEFAULT_RUNS 5
+#define MAX_MODES 32
+#define MAX_MODE_ARGS 16
+#define MAX_FILES 256
+#define MAX_OUTPUT_LINE 2048
+#define BYTES_PER_MB 1048576.0
+#define NANOSECONDS_PER_SECOND 1e9
+#define MICROSECONDS_PER_SECOND 1e6
+#define CODEX_RETURN_ERROR 20
+
+/* A named set of Codex switches, e.g. "ALL" = "C89 C99 AMIGA ..." */
+typedef struct {
+    char name[32];
+    char switches[256];
+} Mode;
+
+/* Outcome of one Codex run */
+typedef struct {
+    double wall;
+    double cpu;
+    long diagnostics;
+    int capped;
+    int status;
+} RunResult;
+
+static Mode default_modes[] = {
+    { "C89", "C89" },
+    { "C99", "C99" },
+    { "AMIGA", "AMIGA" },
+    { "NDK", "NDK" },
+    { "SASC", "SASC" },
+    { "VBCC", "VBCC" },
+    { "DICE", "DICE" },
+    { "MEMSAFE", "MEMSAFE" },
+    { "ALL", "C89 C99 AMIGA NDK SASC VBCC DICE MEMSAFE" }
+};
+
+static Mode modes[MAX_MODES];
+static int mode_count = 0;
+
+static double now_seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+static double children_cpu_seconds(void) {
+    struct rusage usage;
+
+    getrusage(RUSAGE_CHILDREN, &usage);
+    return (double)usage.ru_utime.tv_sec + (double)usage.ru_stime.tv_sec +
+           ((double)usage.ru_utime.tv_usec + (double)usage.ru_stime.tv_usec) / MICROSECONDS_PER_SECOND;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static double median(double *values, int count) {
+    qsort(values, (size_t)count, sizeof(double), compare_doubles);
+    if (count % 2) return values[count / 2];
+    return (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+/* Median absolute deviation from the given median; reorders values */
+static double median_deviation(double *values, int count, double center) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        values[i] = values[i] > center ? values[i] - center : center - values[i];
+    }
+    return median(values, count);
+}
+
+/* Counts bytes and lines of the input files */
+static int measure_corpus(char **files, int file_count, long *bytes, long *lines) {
+    int i;
+
+    *bytes = 0;
+    *lines = 0;
+    for (i = 0; i < file_count; i++) {
+        FILE *file = fopen(files[i], "rb");
+        int c;
+
+        if (!file) {
+            fprintf(stderr, "benchdriver: cannot open '%s'\n", files[i]);
+            return 0;
+        }
+        while ((c = fgetc(file)) != EOF) {
+            (*bytes)++;
+            if (c == '\n') (*lines)++;
+        }
+        fclose(file);
+    }
+    return 1;
+}
+
+/* Counts "file:line:col: [TYPE]" lines in Codex's report */
+static void count_diagnostics(FILE *report, RunResult *result) {
+    char line[MAX_OUTPUT_LINE];
+
+    result->diagnostics = 0;
+    result->capped = 0;
+    rewind(report);
+    while (fgets(line, sizeof(line), report)) {
+        char *bracket = strstr(line, ": [");
+        if (bracket && bracket > line && bracket[-1] >= '0' && bracket[-1] <= '9') {
+            result->diagnostics++;
+        }
+        if (strstr(line, "Maximum error count reached")) result->capped = 1;
+    }
+}
+
+/* Runs Codex once with the mode's switches, stdout going to a scratch file */
+static int run_codex(const char *codex, const Mode *mode, char **files, int file_count, RunResult *result) {
+    char switches[sizeof(mode->switches)];
+    char *argv[MAX_FILES + MAX_MODE_ARGS + 2];
+    int argc = 0;
+    FILE *report;
+    double cpu_before;
+    double start;
+    pid_t pid;
+    int status;
+    char *token;
+    int i;
+
+    report = tmpfile();
+    if (!report) return 0;
+
+    argv[argc++] = (char *)codex;
+    for (i = 0; i < file_count; i++) argv[argc++] = files[i];
+    strcpy(switches, mode->switches);
+    for (token = strtok(switches, " "); token && argc < MAX_FILES + MAX_MODE_ARGS; token = strtok(NULL, " ")) {
+        argv[argc++] = token;
+    }
+    argv[argc++] = "QUIET";
+    argv[argc] = NULL;
+
+    fflush(stdout);
+    cpu_before = children_cpu_seconds();
+    start = now_seconds();
+    pid = fork();
+    if (pid < 0) {
+        fclose(report);
+        return 0;
+    }
+    if (pid == 0) {
+        dup2(fileno(report), STDOUT_FILENO);
+        execv(codex, argv);
+        _exit(127);
+    }
+    if (waitpid(pid, &status, 0) < 0) {
+        fclose(report);
+        return 0;
+    }
+    result->wall = now_seconds() - start;
+    result->cpu = children_cpu_seconds() - cpu_before;
+    result->status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+    count_diagnostics(report, result);
+    fclose(report);
+    return result->status >= 0 && result->status < CODEX_RETURN_ERROR;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: benchdriver [-codex PATH] [-runs N] [-mode NAME=SWITCHES]... [-o FILE] FILES...\n\n");
+    fprintf(stderr, "  -codex PATH          Codex host binary (default %s)\n", DEFAULT_CODEX);
+    fprintf(stderr, "  -runs N              Runs per mode, the median is reported (default %d)\n", DEFAULT_RUNS);
+    fprintf(stderr, "  -mode NAME=SWITCHES  Benchmark this mode instead of the defaults, e.g. -mode \"AM=AMIGA MEMSAFE\"\n");
+    fprintf(stderr, "  -o FILE              Write the JSON there instead of stdout\n");
+}
+
+static int add_mode(const char *spec) {
+    const char *equals = strchr(spec, '=');
+    Mode *mode;
+
+    if (!equals || mode_count >= MAX_MODES) return 0;
+    if ((size_t)(equals - spec) >= sizeof(mode->name) || strlen(equals + 1) >= sizeof(mode->switches)) return 0;
+    mode = &modes[mode_count++];
+    memcpy(mode->name, spec, (size_t)(equals - spec));
+    mode->name[equals - spec] = '\0';
+    strcpy(mode->switches, equals + 1);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    const char *codex = DEFAULT_CODEX;
+    const char *output_name = NULL;
+    char *files[MAX_FILES];
+    int file_count = 0;
+    int runs = DEFAULT_RUNS;
+    double *walls;
+    double *cpus;
+    RunResult *results;
+    int *ok;
+    long bytes;
+    long lines;
+    FILE *out = stdout;
+    int failed = 0;
+    int printed = 0;
+    int i;
+    int m;
+
+    for (i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            if (file_count >= MAX_FILES) {
+                fprintf(stderr, "benchdriver: too many files\n");
+                return 1;
+            }
+            files[file_count++] = argv[i];
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (strcmp(argv[i], "-codex") == 0) codex = argv[++i];
+        else if (strcmp(argv[i], "-runs") == 0) runs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-o") == 0) output_name = argv[++i];
+        else if (strcmp(argv[i], "-mode") == 0) {
+            if (!add_mode(argv[++i])) {
+                fprintf(stderr, "benchdriver: bad mode '%s'\n", argv[i]);
+                return 1;
+            }
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (file_count == 0 || runs < 1) {
+        usage();
+        return 1;
+    }
+    if (mode_count == 0) {
+        mode_count = (int)(sizeof(default_modes) / sizeof(default_modes[0]));
+        memcpy(modes, default_modes, sizeof(default_modes));
+    }
+    if (!measure_corpus(files, file_count, &bytes, &lines)) return 1;
+
+    walls = malloc((size_t)(runs * mode_count) * sizeof(double));
+    cpus = malloc((size_t)(runs * mode_count) * sizeof(double));
+    results = calloc((size_t)mode_count, sizeof(RunResult));
+    ok = calloc((size_t)mode_count, sizeof(int));
+    if (!walls || !cpus || !results || !ok) {
+        fprintf(stderr, "benchdriver: out of memory\n");
+        return 1;
+    }
+    if (output_name) {
+        out = fopen(output_name, "w");
+        if (!out) {
+            fprintf(stderr, "benchdriver: cannot create '%s'\n", output_name);
+            return 1;
+        }
+    }
+
+    fprintf(out, "{\n  \"tool\": \"Codex benchdriver\",\n  \"codex\": \"%s\",\n  \"runs\": %d,\n", codex, runs);
+    fprintf(out, "  \"corpus\": { \"files\": %d, \"bytes\": %ld, \"lines\": %ld },\n", file_count, bytes, lines);
+    fprintf(out, "  \"results\": [");
+    /* Runs go round-robin over the modes, so a machine that slows down
+       part-way through costs every mode alike instead of the last few */
+    for (m = 0; m < mode_count; m++) ok[m] = 1;
+    for (i = 0; i < runs; i++) {
+        for (m = 0; m < mode_count; m++) {
+            if (!ok[m]) continue;
+            if (!run_codex(codex, &modes[m], files, file_count, &results[m])) {
+                fprintf(stderr, "benchdriver: %s failed in mode %s (status %d)\n", codex, modes[m].name, results[m].status);
+                failed = 1;
+                ok[m] = 0;
+                continue;
+            }
+            walls[m * runs + i] = results[m].wall;
+            cpus[m * runs + i] = results[m].cpu;
+        }
+    }
+    for (m = 0; m < mode_count; m++) {
+        double *mode_walls = walls + m * runs;
+        double *mode_cpus = cpus + m * runs;
+        double wall;
+        double cpu;
+        double wall_mad;
+        double cpu_mad;
+
+        if (!ok[m]) continue;
+        wall = median(mode_walls, runs);
+        cpu = median(mode_cpus, runs);
+        wall_mad = median_deviation(mode_walls, runs, wall);
+        cpu_mad = median_deviation(mode_cpus, runs, cpu);
+        fprintf(out, "%s\n    { \"mode\": \"%s\", \"switches\": \"%s\", \"wall_s\": %.6f, \"wall_mad_s\": %.6f,"
+                     " \"cpu_s\": %.6f, \"cpu_mad_s\": %.6f,",
+                printed++ ? "," : "", modes[m].name, modes[m].switches, wall, wall_mad, cpu, cpu_mad);
+        fprintf(out, " \"mb_per_s\": %.3f, \"lines_per_s\": %.0f, \"diagnostics\": %ld, \"diagnostics_per_s\": %.0f, \"capped\": %s }",
+                wall > 0 ? (double)bytes / BYTES_PER_MB / wall : 0.0,
+                wall > 0 ? (double)lines / wall : 0.0,
+                results[m].diagnostics,
+                wall > 0 ? (double)results[m].diagnostics / wall : 0.0,
+                results[m].capped ? "true" : "false");
+        fprintf(stderr, "%-8s %8.3f MB/s %10.0f lines/s %6ld diagnostics%s\n", modes[m].name,
+                wall > 0 ? (double)bytes / BYTES_PER_MB / wall : 0.0,
+                wall > 0 ? (double)lines / wall : 0.0,
+                results[m].diagnostics, results[m].capped ? " (capped)" : "");
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    if (out != stdout && fclose(out) != 0) {
+        fprintf(stderr, "benchdriver: error writing '%s'\n", output_name);
+        failed = 1;
+    }
+    free(walls);
+    free(cpus);
+    free(results);
+    free(ok);
+    return failed;
+}
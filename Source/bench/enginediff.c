@@ -0,0 +1,380 @@
+/*
+ * Codex - differential check of the LEGACY and FAST lookup engines
+ *
+ * Includes codex.c and lints every file in every mode with both engines,
+ * comparing the diagnostics one by one.  A diagnostic only one engine
+ * reports is printed as
+ *
+ *     MODE file:line:column: [TYPE] message (ENGINE only)
+ *
+ * and fails the check unless the allowlist has the same line without the
+ * "(ENGINE only)" part; a '*' in place of MODE matches every mode.  Then
+ * both engines are timed over all files, alternating runs, and the median
+ * time and speed-up are reported per mode.
+ *
+ * Host build only (VMakefile: make -f VMakefile engine-diff).
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "../codex.c"
+#undef main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define DEFAULT_RUNS 5
+#define MAX_ALLOWED 256
+#define MAX_REPORT_LINE 640
+#define NANOSECONDS_PER_SECOND 1e9
+#define NANOSECONDS_PER_MILLISECOND 1e6
+
+/* A mode name and the switches it stands for */
+typedef struct {
+    const char *name;
+    const char *switches;
+} DiffMode;
+
+static const DiffMode modes[] = {
+    { "C89", "C89" },
+    { "C99", "C99" },
+    { "AMIGA", "AMIGA" },
+    { "NDK", "NDK" },
+    { "SASC", "SASC" },
+    { "VBCC", "VBCC" },
+    { "DICE", "DICE" },
+    { "MEMSAFE", "MEMSAFE" },
+    { "ALL", "C89 C99 AMIGA NDK SASC VBCC DICE MEMSAFE" }
+};
+
+static const char *engine_names[] = { "LEGACY", "FAST" };
+
+static char *allowed[MAX_ALLOWED];
+static int allowed_count = 0;
+static int allowed_used[MAX_ALLOWED];
+static LintError *results[2];  /* Diagnostics of the last file, per engine */
+static int result_counts[2];
+static int saved_stdout = -1;
+static int runs = DEFAULT_RUNS;
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * NANOSECONDS_PER_SECOND + (double)ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Mirrors the mode implications in main(), in the same order */
+static void set_mode(const char *mode) {
+    int c89 = strstr(mode, "C89") != NULL;
+    int c99 = strstr(mode, "C99") != NULL;
+
+    validate_amiga_standards = strstr(mode, "AMIGA") != NULL;
+    validate_ndk_standards = strstr(mode, "NDK") != NULL;
+    validate_c89_standards = 1;
+    validate_c99_standards = c99;
+    validate_sasc_standards = strstr(mode, "SASC") != NULL;
+    validate_vbcc_standards = strstr(mode, "VBCC") != NULL;
+    validate_dice_standards = strstr(mode, "DICE") != NULL;
+    validate_memsafe_standards = strstr(mode, "MEMSAFE") != NULL;
+
+    if (c99 && !c89 && !validate_sasc_standards && !validate_dice_standards && !validate_memsafe_standards) {
+        validate_c89_standards = 0;
+    }
+    if (validate_sasc_standards) {
+        validate_c89_standards = 1;
+        validate_c99_standards = 0;
+    }
+    if (validate_vbcc_standards) {
+        validate_c99_standards = 1;
+        validate_c89_standards = 0;
+    }
+    if (validate_amiga_standards) validate_ndk_standards = 1;
+    if (validate_dice_standards) {
+        validate_c89_standards = 1;
+        validate_ndk_standards = 1;
+    }
+    if (validate_memsafe_standards) validate_c89_standards = 1;
+    if (!validate_c89_standards && !validate_c99_standards && !validate_sasc_standards &&
+        !validate_vbcc_standards && !validate_dice_standards) {
+        validate_c89_standards = 1;
+    }
+    enforce_amiga_pascalcase = validate_amiga_standards;
+}
+
+/* process_file() announces every file; keep that out of the report */
+static void silence_stdout(int silent) {
+    fflush(stdout);
+    if (silent) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        saved_stdout = dup(STDOUT_FILENO);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDOUT_FILENO);
+            close(null_fd);
+        }
+    } else if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+        saved_stdout = -1;
+    }
+}
+
+static void use_engine(int fast) {
+    fast_engine = fast;
+}
+
+/* Lints one file with one engine and keeps its diagnostics */
+static int lint_file(const char *filename, int fast) {
+    int count;
+
+    use_engine(fast);
+    error_count = 0;
+    silence_stdout(1);
+    count = process_file(filename);
+    silence_stdout(0);
+    if (count != 0) return 0;
+    count = error_count < MAX_ERRORS ? error_count : MAX_ERRORS;
+    memcpy(results[fast], errors, (size_t)count * sizeof(LintError));
+    result_counts[fast] = count;
+    return 1;
+}
+
+static int same_diagnostic(const LintError *a, const LintError *b) {
+    return a->line_number == b->line_number && a->column == b->column && a->type == b->type &&
+           strcmp(a->filename, b->filename) == 0 && strcmp(a->message, b->message) == 0;
+}
+
+static int is_allowed(const char *mode, const char *text) {
+    int i;
+
+    for (i = 0; i < allowed_count; i++) {
+        const char *entry = allowed[i];
+        size_t mode_length = strlen(mode);
+
+        if (entry[0] == '*' && entry[1] == ' ') entry += 2;
+        else if (strncmp(entry, mode, mode_length) == 0 && entry[mode_length] == ' ') entry += mode_length + 1;
+        else continue;
+        if (strcmp(entry, text) == 0) {
+            allowed_used[i] = 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Reports the diagnostics only one engine produced; returns how many were not allowed */
+static int compare_engines(const char *mode) {
+    static const char *type_names[] = { "SYNTAX", "STYLE", "WARNING", "COMPILER", "COMMENT" };
+    static UBYTE matched[MAX_ERRORS];
+    int unexpected = 0;
+    int side;
+    int i;
+    int j;
+
+    memset(matched, 0, sizeof(matched));
+    for (side = 0; side < 2; side++) {
+        for (i = 0; i < result_counts[side]; i++) {
+            const LintError *error = &results[side][i];
+            char text[MAX_REPORT_LINE];
+            int found = 0;
+
+            for (j = 0; j < result_counts[!side] && !found; j++) {
+                if (side == 0 && matched[j]) continue;
+                if (same_diagnostic(error, &results[!side][j])) {
+                    if (side == 0) matched[j] = 1;
+                    found = 1;
+                }
+            }
+            if (found) continue;
+
+            sprintf(text, "%s:%d:%d: [%s] %s", error->filename, error->line_number, error->column,
+                    type_names[error->type], error->message);
+            if (is_allowed(mode, text)) {
+                printf("  allowed: %s %s (%s only)\n", mode, text, engine_names[side]);
+            } else {
+                printf("  DIFFERS: %s %s (%s only)\n", mode, text, engine_names[side]);
+                unexpected++;
+            }
+        }
+    }
+    return unexpected;
+}
+
+/* Median time of linting all files with one engine, runs alternating with the other */
+static void time_engines(int file_count, char **files, double *median_ns) {
+    double *times[2];
+    int fast;
+    int r;
+    int f;
+
+    times[0] = malloc((size_t)runs * sizeof(double));
+    times[1] = malloc((size_t)runs * sizeof(double));
+    if (!times[0] || !times[1]) {
+        fprintf(stderr, "enginediff: out of memory\n");
+        exit(1);
+    }
+    silence_stdout(1);
+    for (r = 0; r < runs; r++) {
+        for (fast = 0; fast < 2; fast++) {
+            double start;
+
+            use_engine(fast);
+            start = now_ns();
+            for (f = 0; f < file_count; f++) {
+                error_count = 0;
+                process_file(files[f]);
+            }
+            times[fast][r] = now_ns() - start;
+        }
+    }
+    silence_stdout(0);
+    for (fast = 0; fast < 2; fast++) {
+        qsort(times[fast], (size_t)runs, sizeof(double), compare_doubles);
+        median_ns[fast] = times[fast][runs / 2];
+        free(times[fast]);
+    }
+}
+
+static int load_allowlist(const char *filename) {
+    char line[MAX_REPORT_LINE];
+    FILE *file = fopen(filename, "r");
+
+    if (!file) {
+        fprintf(stderr, "enginediff: cannot open allowlist '%s'\n", filename);
+        return 0;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+        if (allowed_count >= MAX_ALLOWED) {
+            fprintf(stderr, "enginediff: too many allowlist entries\n");
+            fclose(file);
+            return 0;
+        }
+        allowed[allowed_count] = malloc(strlen(line) + 1);
+        if (!allowed[allowed_count]) {
+            fclose(file);
+            return 0;
+        }
+        strcpy(allowed[allowed_count++], line);
+    }
+    fclose(file);
+    return 1;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: enginediff [-allow FILE] [-runs N] FILES...\n\n");
+    fprintf(stderr, "  -allow FILE  Differences that are intended, one report line each\n");
+    fprintf(stderr, "  -runs N      Timed runs per engine and mode, the median is used (default %d)\n", DEFAULT_RUNS);
+}
+
+int main(int argc, char **argv) {
+    int mode_count = (int)(sizeof(modes) / sizeof(modes[0]));
+    char **files;
+    int file_count = 0;
+    int unexpected = 0;
+    int m;
+    int f;
+    int i;
+
+    files = malloc((size_t)argc * sizeof(char *));
+    if (!files) return 1;
+    for (i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            files[file_count++] = argv[i];
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (strcmp(argv[i], "-allow") == 0) {
+            if (!load_allowlist(argv[++i])) return 1;
+        } else if (strcmp(argv[i], "-runs") == 0) {
+            runs = atoi(argv[++i]);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (file_count == 0 || runs < 1) {
+        usage();
+        return 1;
+    }
+    results[0] = malloc(MAX_ERRORS * sizeof(LintError));
+    results[1] = malloc(MAX_ERRORS * sizeof(LintError));
+    if (!results[0] || !results[1] || !engine_open()) {
+        fprintf(stderr, "enginediff: out of memory\n");
+        return 1;
+    }
+    quiet_mode = 1;
+
+    printf("Comparing engines on %d file%s\n", file_count, file_count == 1 ? "" : "s");
+    for (m = 0; m < mode_count; m++) {
+        set_mode(modes[m].switches);
+        for (f = 0; f < file_count; f++) {
+            if (!lint_file(files[f], 0) || !lint_file(files[f], 1)) {
+                fprintf(stderr, "enginediff: cannot lint '%s'\n", files[f]);
+                return 1;
+            }
+            unexpected += compare_engines(modes[m].name);
+        }
+    }
+    for (i = 0; i < allowed_count; i++) {
+        if (!allowed_used[i]) printf("  stale allowlist entry: %s\n", allowed[i]);
+    }
+
+    printf("\n%-8s %12s %12s %9s\n", "Mode", "LEGACY ms", "FAST ms", "Speed-up");
+    for (m = 0; m < mode_count; m++) {
+        double median_ns[2];
+
+        set_mode(modes[m].switches);
+        time_engines(file_count, files, median_ns);
+        printf("%-8s %12.2f %12.2f %8.2fx\n", modes[m].name, median_ns[0] / NANOSECONDS_PER_MILLISECOND,
+               median_ns[1] / NANOSECONDS_PER_MILLISECOND, median_ns[1] > 0 ? median_ns[0] / median_ns[1] : 0.0);
+    }
+    engine_close();
+
+    if (unexpected > 0) {
+        printf("\nengine-diff FAILED: %d diagnostic%s differ%s between the engines\n", unexpected,
+               unexpected == 1 ? "" : "s", unexpected == 1 ? "s" : "");
+        return 1;
+    }
+    printf("\nengine-diff passed: both engines report the same diagnostics\n");
+    return 0;
+}
@@ -0,0 +1,471 @@
+/*
+ * Codex - synthetic corpus generator
+ *
+ * Writes a reproducible file of Amiga-style C for benchmarking Codex.  The
+ * same seed and options always produce the same bytes on every platform, as
+ * the generator carries its own random number generator.  Size, line length,
+ * comment and string density, block nesting and the rate of each pattern
+ * family that Codex reports on can all be tuned from the command line.
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_SEED 1UL
+#define DEFAULT_SIZE 1048576L      /* Bytes of output */
+#define DEFAULT_LINE_LENGTH 48     /* Mean length of a statement line */
+#define DEFAULT_COMMENT_RATE 15    /* Percent of statements preceded by a comment */
+#define DEFAULT_STRING_RATE 10     /* Percent of statements that print a string */
+#define DEFAULT_MAX_DEPTH 4        /* Deepest block nesting inside a function */
+#define MAX_GEN_LINE 1000          /* Stays below Codex's 1024 byte line buffer */
+#define LONG_LINE_MIN 300          /* Length range of the "longline" family */
+#define LONG_LINE_SPAN 400
+#define BLOCK_PERCENT 18           /* Chance a statement opens a nested block */
+#define MIN_BODY_STATEMENTS 6
+#define BODY_STATEMENT_SPAN 14
+#define MIN_BLOCK_STATEMENTS 1
+#define BLOCK_STATEMENT_SPAN 4
+#define CONSTANT_COUNT 8           /* #define LIMIT_n constants in each file header */
+#define CONSTANT_STEP 16
+#define TERM_HEADROOM 32           /* Room kept for one more operand and the ";" */
+#define MAGIC_NUMBER_RANGE 9990
+#define PERCENT 100
+#define PERMILLE 1000
+#define INDENT_WIDTH 4
+#define RNG_MASK 0xffffffffUL
+#define RNG_SHIFT_A 13
+#define RNG_SHIFT_B 17
+#define RNG_SHIFT_C 5
+
+/* Pattern families, each with a rate in statements (or functions) per mille */
+typedef enum {
+    FAMILY_C99,
+    FAMILY_MEMSAFE,
+    FAMILY_KEYWORDS,
+    FAMILY_MAGIC,
+    FAMILY_FORBID,
+    FAMILY_AMIGA,
+    FAMILY_STDLIB,
+    FAMILY_LONGLINE,
+    FAMILY_COUNT
+} Family;
+
+typedef struct {
+    const char *name;
+    int rate;
+    const char *description;
+} FamilySpec;
+
+static FamilySpec families[FAMILY_COUNT] = {
+    { "c99",      4,  "// comments, for (int ...), compound literals, C99 library calls" },
+    { "memsafe",  6,  "strcpy(), sprintf(), gets(), atoi() and friends" },
+    { "keywords", 30, "__saveds, __asm, __chip, __attribute__ on function definitions" },
+    { "magic",    12, "bare numeric literals in expressions" },
+    { "forbid",   3,  "Forbid()/Permit() sections" },
+    { "amiga",    60, "exec.library and dos.library calls" },
+    { "stdlib",   40, "common C library calls" },
+    { "longline", 2,  "lines of 300 to 700 characters" }
+};
+
+typedef struct {
+    unsigned long seed;
+    long size;
+    int line_length;
+    int comment_rate;
+    int string_rate;
+    int max_depth;
+} Config;
+
+static const char *words[] = {
+    "node", "list", "port", "message", "signal", "buffer", "window", "screen",
+    "library", "device", "request", "handler", "task", "lock", "file", "memory",
+    "pool", "chunk", "entry", "header", "table", "index", "count", "offset"
+};
+
+static const char *variables[] = { "total", "count", "index", "length", "offset", "flags" };
+
+static const char *c99_lines[] = {
+    "// Quick note left behind by a C99 habit",
+    "total += (int[]){1, 2, 3}[index];",
+    "length = snprintf(buffer, sizeof(buffer), \"%ld\", (LONG)total);",
+    "total = (LONG)round((double)count);"
+};
+
+static const char *memsafe_lines[] = {
+    "strcpy(buffer, name);",
+    "sprintf(buffer, \"%ld items\", (LONG)count);",
+    "strcat(buffer, name);",
+    "count = atoi(name);",
+    "gets(buffer);"
+};
+
+static const char *keyword_prefixes[] = {
+    "__saveds ", "__asm ", "__stdargs ", "__far ", "__interrupt "
+};
+
+static const char *amiga_lines[] = {
+    "node = AllocVec(sizeof(struct Node), MEMF_CLEAR);",
+    "FreeVec(node);",
+    "lock = Lock(name, ACCESS_READ);",
+    "UnLock(lock);",
+    "file = Open(name, MODE_OLDFILE);",
+    "Close(file);",
+    "length = Read(file, buffer, sizeof(buffer));",
+    "AddTail(list, node);",
+    "Remove(node);",
+    "Delay(TICKS_PER_SECOND);"
+};
+
+static const char *stdlib_lines[] = {
+    "memcpy(buffer, name, sizeof(buffer));",
+    "length = strlen(name);",
+    "memset(buffer, 0, sizeof(buffer));",
+    "printf(\"%s\\n\", name);",
+    "index = strcmp(name, buffer);"
+};
+
+static unsigned long rng_state;
+static FILE *output;
+static long bytes_written = 0;
+static long lines_written = 0;
+static long functions_written = 0;
+
+#define ARRAY_COUNT(array) ((int)(sizeof(array) / sizeof((array)[0])))
+
+/* xorshift32, so every platform produces the same corpus for a seed */
+static unsigned long rng_next(void) {
+    rng_state ^= (rng_state << RNG_SHIFT_A) & RNG_MASK;
+    rng_state ^= rng_state >> RNG_SHIFT_B;
+    rng_state ^= (rng_state << RNG_SHIFT_C) & RNG_MASK;
+    return rng_state;
+}
+
+static int rng_range(int n) {
+    return (int)(rng_next() % (unsigned long)n);
+}
+
+static int rng_chance(int rate, int scale) {
+    return rng_range(scale) < rate;
+}
+
+static const char *pick(const char **table, int count) {
+    return table[rng_range(count)];
+}
+
+static void emit_line(int depth, const char *text) {
+    int i;
+
+    for (i = 0; i < depth * INDENT_WIDTH; i++) fputc(' ', output);
+    fputs(text, output);
+    fputc('\n', output);
+    bytes_written += (long)(depth * INDENT_WIDTH + strlen(text) + 1);
+    lines_written++;
+}
+
+/* Statement of roughly the requested length built from named operands only */
+static void build_expression(char *line, int target) {
+    const char *target_var = pick(variables, ARRAY_COUNT(variables));
+    size_t length;
+
+    sprintf(line, "%s = %s", target_var, pick(variables, ARRAY_COUNT(variables)));
+    length = strlen(line);
+    while ((int)length < target - 1 && length + TERM_HEADROOM < MAX_GEN_LINE) {
+        sprintf(line + length, " %c %s", "+-*"[rng_range(3)], pick(variables, ARRAY_COUNT(variables)));
+        length = strlen(line);
+        if (rng_chance(1, 4) && length + TERM_HEADROOM < MAX_GEN_LINE) {
+            sprintf(line + length, " + LIMIT_%d", rng_range(CONSTANT_COUNT));
+            length = strlen(line);
+        }
+    }
+    strcpy(line + length, ";");
+}
+
+static void build_comment(char *line) {
+    size_t length;
+    int n = 2 + rng_range(6);
+
+    strcpy(line, "/*");
+    while (n-- > 0) {
+        length = strlen(line);
+        sprintf(line + length, " %s", pick(words, ARRAY_COUNT(words)));
+    }
+    strcat(line, " */");
+}
+
+/* Printf() with string literal text, sometimes holding comment-like sequences */
+static void build_string_statement(char *line) {
+    size_t length;
+    int n = 1 + rng_range(5);
+
+    strcpy(line, "Printf(\"");
+    while (n-- > 0) {
+        length = strlen(line);
+        sprintf(line + length, "%s ", pick(words, ARRAY_COUNT(words)));
+    }
+    switch (rng_range(8)) {
+        case 0: strcat(line, "// "); break;
+        case 1: strcat(line, "/* not a comment */ "); break;
+        case 2: strcat(line, "\\\"quoted\\\" "); break;
+        default: break;
+    }
+    strcat(line, "%ld\\n\", (LONG)count);");
+}
+
+static void build_long_line(char *line) {
+    int target = LONG_LINE_MIN + rng_range(LONG_LINE_SPAN);
+
+    build_expression(line, target);
+}
+
+static void gen_statement(const Config *config, int depth);
+
+static void gen_block(const Config *config, int depth, const char *opener, int extra_statement) {
+    int n = MIN_BLOCK_STATEMENTS + rng_range(BLOCK_STATEMENT_SPAN);
+
+    emit_line(depth, opener);
+    while (n-- > 0) gen_statement(config, depth + 1);
+    if (extra_statement) emit_line(depth + 1, "index++;");
+    emit_line(depth, "}");
+}
+
+static void gen_statement(const Config *config, int depth) {
+    char line[MAX_GEN_LINE + 1];
+    int target = config->line_length / 2 + rng_range(config->line_length + 1);
+
+    if (rng_chance(config->comment_rate, PERCENT)) {
+        build_comment(line);
+        emit_line(depth, line);
+    }
+
+    if (rng_chance(families[FAMILY_C99].rate, PERMILLE)) {
+        if (rng_chance(1, 3) && depth < config->max_depth) {
+            gen_block(config, depth, "for (int k = 0; k < count; k++) {", 0);
+        } else {
+            emit_line(depth, pick(c99_lines, ARRAY_COUNT(c99_lines)));
+        }
+        return;
+    }
+    if (rng_chance(families[FAMILY_MEMSAFE].rate, PERMILLE)) {
+        emit_line(depth, pick(memsafe_lines, ARRAY_COUNT(memsafe_lines)));
+        return;
+    }
+    if (rng_chance(families[FAMILY_MAGIC].rate, PERMILLE)) {
+        sprintf(line, "%s += count * %d;", pick(variables, ARRAY_COUNT(variables)),
+                10 + rng_range(MAGIC_NUMBER_RANGE));
+        emit_line(depth, line);
+        return;
+    }
+    if (rng_chance(families[FAMILY_FORBID].rate, PERMILLE)) {
+        emit_line(depth, "Forbid();");
+        emit_line(depth, "AddTail(list, node);");
+        emit_line(depth, "Permit();");
+        return;
+    }
+    if (rng_chance(families[FAMILY_AMIGA].rate, PERMILLE)) {
+        emit_line(depth, pick(amiga_lines, ARRAY_COUNT(amiga_lines)));
+        return;
+    }
+    if (rng_chance(families[FAMILY_STDLIB].rate, PERMILLE)) {
+        emit_line(depth, pick(stdlib_lines, ARRAY_COUNT(stdlib_lines)));
+        return;
+    }
+    if (rng_chance(families[FAMILY_LONGLINE].rate, PERMILLE)) {
+        build_long_line(line);
+        emit_line(depth, line);
+        return;
+    }
+
+    if (depth < config->max_depth && rng_chance(BLOCK_PERCENT, PERCENT)) {
+        if (rng_chance(1, 2)) {
+            sprintf(line, "if (count > LIMIT_%d) {", rng_range(CONSTANT_COUNT));
+            gen_block(config, depth, line, 0);
+        } else {
+            gen_block(config, depth, "while (index < count) {", 1);
+        }
+        return;
+    }
+
+    if (rng_chance(config->string_rate, PERCENT)) {
+        build_string_statement(line);
+    } else {
+        build_expression(line, target);
+    }
+    emit_line(depth, line);
+}
+
+static void gen_function(const Config *config) {
+    char line[MAX_GEN_LINE + 1];
+    const char *prefix = "";
+    int n = MIN_BODY_STATEMENTS + rng_range(BODY_STATEMENT_SPAN);
+
+    if (rng_chance(families[FAMILY_KEYWORDS].rate, PERMILLE)) {
+        prefix = pick(keyword_prefixes, ARRAY_COUNT(keyword_prefixes));
+    }
+
+    emit_line(0, "");
+    sprintf(line, "/* %s the %s of a %s */", "Updates", pick(words, ARRAY_COUNT(words)),
+            pick(words, ARRAY_COUNT(words)));
+    emit_line(0, line);
+    sprintf(line, "static LONG %sUpdate%ld(struct List *list, STRPTR name, LONG count)", prefix,
+            functions_written);
+    emit_line(0, line);
+    emit_line(0, "{");
+    emit_line(1, "struct Node *node = NULL;");
+    emit_line(1, "BPTR lock = 0;");
+    emit_line(1, "BPTR file = 0;");
+    emit_line(1, "char buffer[BUFFER_SIZE];");
+    emit_line(1, "LONG total = 0, index = 0, length = 0, offset = 0, flags = 0;");
+    emit_line(0, "");
+    while (n-- > 0) gen_statement(config, 1);
+    emit_line(1, "return total;");
+    emit_line(0, "}");
+    functions_written++;
+}
+
+static void gen_header(void) {
+    char line[MAX_GEN_LINE + 1];
+    int i;
+
+    emit_line(0, "/* Generated by gencorpus - do not edit */");
+    emit_line(0, "#include <exec/types.h>");
+    emit_line(0, "#include <exec/memory.h>");
+    emit_line(0, "#include <dos/dos.h>");
+    emit_line(0, "#include <proto/exec.h>");
+    emit_line(0, "#include <proto/dos.h>");
+    emit_line(0, "#include <string.h>");
+    emit_line(0, "#include <stdio.h>");
+    if (rng_chance(families[FAMILY_C99].rate * PERCENT, PERMILLE)) {
+        emit_line(0, "#include <stdint.h>");
+    }
+    emit_line(0, "");
+    emit_line(0, "#define BUFFER_SIZE 256");
+    for (i = 0; i < CONSTANT_COUNT; i++) {
+        sprintf(line, "#define LIMIT_%d %d", i, (i + 1) * CONSTANT_STEP);
+        emit_line(0, line);
+    }
+}
+
+static void usage(void) {
+    int i;
+
+    fprintf(stderr, "Usage: gencorpus [options] OUTFILE\n\n");
+    fprintf(stderr, "  -seed N        Random seed (default %lu)\n", DEFAULT_SEED);
+    fprintf(stderr, "  -size BYTES    Approximate output size (default %ld)\n", DEFAULT_SIZE);
+    fprintf(stderr, "  -linelen N     Mean statement line length (default %d)\n", DEFAULT_LINE_LENGTH);
+    fprintf(stderr, "  -comments PCT  Statements preceded by a comment (default %d)\n", DEFAULT_COMMENT_RATE);
+    fprintf(stderr, "  -strings PCT   Statements printing a string literal (default %d)\n", DEFAULT_STRING_RATE);
+    fprintf(stderr, "  -depth N       Maximum block nesting (default %d)\n", DEFAULT_MAX_DEPTH);
+    fprintf(stderr, "  -rate F=N      Rate of pattern family F per mille (per function for keywords)\n\n");
+    fprintf(stderr, "Pattern families:\n");
+    for (i = 0; i < FAMILY_COUNT; i++) {
+        fprintf(stderr, "  %-9s %3d  %s\n", families[i].name, families[i].rate, families[i].description);
+    }
+}
+
+static int set_family_rate(const char *spec) {
+    const char *equals = strchr(spec, '=');
+    int i;
+
+    if (!equals) return 0;
+    for (i = 0; i < FAMILY_COUNT; i++) {
+        if (strlen(families[i].name) == (size_t)(equals - spec) &&
+            strncmp(families[i].name, spec, (size_t)(equals - spec)) == 0) {
+            families[i].rate = atoi(equals + 1);
+            return families[i].rate >= 0 && families[i].rate <= PERMILLE;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Config config;
+    const char *filename = NULL;
+    int i;
+
+    config.seed = DEFAULT_SEED;
+    config.size = DEFAULT_SIZE;
+    config.line_length = DEFAULT_LINE_LENGTH;
+    config.comment_rate = DEFAULT_COMMENT_RATE;
+    config.string_rate = DEFAULT_STRING_RATE;
+    config.max_depth = DEFAULT_MAX_DEPTH;
+
+    for (i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (arg[0] != '-') {
+            filename = arg;
+            continue;
+        }
+        if (!value) {
+            usage();
+            return 1;
+        }
+        if (strcmp(arg, "-seed") == 0) config.seed = strtoul(value, NULL, 10);
+        else if (strcmp(arg, "-size") == 0) config.size = atol(value);
+        else if (strcmp(arg, "-linelen") == 0) config.line_length = atoi(value);
+        else if (strcmp(arg, "-comments") == 0) config.comment_rate = atoi(value);
+        else if (strcmp(arg, "-strings") == 0) config.string_rate = atoi(value);
+        else if (strcmp(arg, "-depth") == 0) config.max_depth = atoi(value);
+        else if (strcmp(arg, "-rate") == 0) {
+            if (!set_family_rate(value)) {
+                fprintf(stderr, "gencorpus: bad family rate '%s'\n", value);
+                return 1;
+            }
+        } else {
+            usage();
+            return 1;
+        }
+        i++;
+    }
+
+    if (!filename || config.size <= 0 || config.line_length <= 0 ||
+        config.line_length > MAX_GEN_LINE / 2 || config.max_depth < 0) {
+        usage();
+        return 1;
+    }
+
+    output = fopen(filename, "w");
+    if (!output) {
+        fprintf(stderr, "gencorpus: cannot create '%s'\n", filename);
+        return 1;
+    }
+
+    rng_state = (config.seed & RNG_MASK) ? (config.seed & RNG_MASK) : DEFAULT_SEED;
+    gen_header();
+    while (bytes_written < config.size) gen_function(&config);
+
+    if (fclose(output) != 0) {
+        fprintf(stderr, "gencorpus: error writing '%s'\n", filename);
+        return 1;
+    }
+    fprintf(stderr, "gencorpus: %s: %ld bytes, %ld lines, %ld functions (seed %lu)\n",
+            filename, bytes_written, lines_written, functions_written, config.seed);
+    return 0;
+}
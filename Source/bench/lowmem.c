@@ -0,0 +1,280 @@
+/*
+ * Codex - LOWMEM/S peak memory check
+ *
+ * Includes codex.c and runs its main() with LOWMEM/S and every validation
+ * mode over the given files, output going to /dev/null.  The check fails
+ * if the peak heap Codex charged to its subsystems is over the budget, or
+ * if the issue ring lost an issue on the way out.  The peak must not
+ * depend on how large the files are or how many issues they have, so a
+ * corpus with thousands of issues is as good a test as a small one.
+ *
+ * Each file is first linted on its own twice, with and without LOWMEM/S,
+ * each run in a child process so that it starts from fresh globals.  The
+ * two must print the same issues, each with the same excerpt.  LOWMEM/S
+ * has no issue limit, so for a file that reaches it without LOWMEM/S, every
+ * issue printed without LOWMEM/S must be printed with it.
+ *
+ * Host build only (VMakefile: make -f VMakefile lowmem).
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "../codex.c"
+#undef main
+
+#define DEFAULT_BUDGET 16384
+#define MAX_FILES 256
+#define COMPARE_LINE_LENGTH 512
+#define COMPARE_RECORD_LENGTH 768  /* An issue line and its excerpt */
+#define COMPARE_RECORDS 4096       /* Issues one file may print under LOWMEM/S, which has no limit */
+#define NORMAL_OUTPUT "/tmp/codex_lowmem_normal.txt"
+#define LOWMEM_OUTPUT "/tmp/codex_lowmem_streamed.txt"
+
+/* LOWMEM with every mode on, so that every rule can report */
+static char *lowmem_switches[] = { "C89", "C99", "AMIGA", "NDK", "SASC", "VBCC", "DICE", "MEMSAFE", "LOWMEM", "QUIET" };
+#define SWITCH_COUNT ((int)(sizeof(lowmem_switches) / sizeof(lowmem_switches[0])))
+
+/* Runs Codex's main() with its output thrown away; returns its exit code, -1 on failure */
+static int run_quietly(int argc, char **argv) {
+    int saved_output;
+    int null_output;
+    int result;
+
+    fflush(stdout);
+    saved_output = dup(STDOUT_FILENO);
+    null_output = open("/dev/null", O_WRONLY);
+    if (saved_output < 0 || null_output < 0) return -1;
+    dup2(null_output, STDOUT_FILENO);
+    close(null_output);
+
+    host_set_args(argc, argv);
+    result = codex_host_main(argc, argv);
+
+    fflush(stdout);
+    dup2(saved_output, STDOUT_FILENO);
+    close(saved_output);
+    return result;
+}
+
+/* Lints one file in a child process with its output in the given file; returns 0 on failure */
+static int run_to_file(const char *file, int lowmem, const char *output) {
+    char *child_argv[SWITCH_COUNT + 2];
+    int child_argc = 0;
+    int status;
+    int fd;
+    pid_t pid;
+    int i;
+
+    child_argv[child_argc++] = "codex";
+    child_argv[child_argc++] = (char *)file;
+    for (i = 0; i < SWITCH_COUNT; i++) {
+        if (!lowmem && strcmp(lowmem_switches[i], "LOWMEM") == 0) continue;
+        child_argv[child_argc++] = lowmem_switches[i];
+    }
+    child_argv[child_argc] = NULL;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid < 0) return 0;
+    if (pid == 0) {
+        fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) _exit(CODEX_RETURN_FAIL);
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+        host_set_args(child_argc, child_argv);
+        status = codex_host_main(child_argc, child_argv);
+        fflush(stdout);
+        _exit(status);
+    }
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) return 0;
+    return WEXITSTATUS(status) < CODEX_RETURN_ERROR;
+}
+
+/* One issue as printed: its line and the excerpt under it, if any */
+typedef struct {
+    char text[COMPARE_RECORD_LENGTH];
+} IssueRecord;
+
+static int compare_records(const void *a, const void *b) {
+    return strcmp(((const IssueRecord *)a)->text, ((const IssueRecord *)b)->text);
+}
+
+/* Reads the issues a run printed, sorted; returns how many, or -1 if they do
+   not fit.  capped is set if the run reached the issue limit */
+static int read_issues(FILE *input, IssueRecord *records, int *capped) {
+    char line[COMPARE_LINE_LENGTH];
+    int count = 0;
+
+    *capped = 0;
+    while (fgets(line, sizeof(line), input)) {
+        if (strncmp(line, "Warning: Maximum error count", 28) == 0) {
+            *capped = 1;
+            continue;
+        }
+        if (strncmp(line, "Analyzing: ", 11) == 0) continue;
+        if (strncmp(line, "    | ", 6) == 0 && count > 0) {
+            IssueRecord *record = &records[count - 1];
+            strncat(record->text, line, sizeof(record->text) - strlen(record->text) - 1);
+            continue;
+        }
+        if (count >= COMPARE_RECORDS) return -1;
+        strncpy(records[count].text, line, sizeof(records[count].text) - 1);
+        records[count].text[sizeof(records[count].text) - 1] = '\0';
+        count++;
+    }
+    qsort(records, (size_t)count, sizeof(IssueRecord), compare_records);
+    return count;
+}
+
+/* Lints the file with and without LOWMEM/S; returns 0 and says why if they
+   print different issues.  An issue only known when its loop or function
+   ends can be printed after later lines once the ring has been emptied in
+   between, so the order is not compared.  capped is counted if the file
+   reached the issue limit without LOWMEM/S and only those issues were
+   looked for */
+static int compare_file(const char *file, int *compared, int *capped) {
+    static IssueRecord normal_issues[COMPARE_RECORDS];
+    static IssueRecord lowmem_issues[COMPARE_RECORDS];
+    FILE *normal;
+    FILE *lowmem;
+    int normal_count = -1;
+    int lowmem_count = -1;
+    int normal_capped = 0;
+    int lowmem_capped = 0;
+    int same = 1;
+    int i;
+    int j;
+
+    if (!run_to_file(file, 0, NORMAL_OUTPUT) || !run_to_file(file, 1, LOWMEM_OUTPUT)) {
+        printf("\nlowmem FAILED: could not lint %s\n", file);
+        return 0;
+    }
+    normal = fopen(NORMAL_OUTPUT, "r");
+    lowmem = fopen(LOWMEM_OUTPUT, "r");
+    if (!normal || !lowmem) {
+        printf("\nlowmem FAILED: could not read the output for %s\n", file);
+        same = 0;
+    } else {
+        normal_count = read_issues(normal, normal_issues, &normal_capped);
+        lowmem_count = read_issues(lowmem, lowmem_issues, &lowmem_capped);
+        if (normal_count < 0 || lowmem_count < 0 || lowmem_capped) {
+            printf("\nlowmem FAILED: %s prints more than %d issues, or LOWMEM reached the issue limit\n",
+                   file, COMPARE_RECORDS);
+            same = 0;
+        }
+    }
+    if (same) {
+        /* Both lists are sorted: walk them together, skipping the issues
+           only LOWMEM/S printed when the normal run was capped */
+        for (i = 0, j = 0; i < normal_count && j < lowmem_count; j++) {
+            int order = strcmp(normal_issues[i].text, lowmem_issues[j].text);
+            if (order == 0) {
+                i++;
+            } else if (order < 0 || !normal_capped) {
+                break;
+            }
+        }
+        if (i < normal_count || (!normal_capped && j < lowmem_count)) {
+            printf("\nlowmem FAILED: %s prints %d issues without LOWMEM and %d with it; the first that differ:\n"
+                   "  normal: %s  lowmem: %s", file, normal_count, lowmem_count,
+                   i < normal_count ? normal_issues[i].text : "(none)\n",
+                   j < lowmem_count ? lowmem_issues[j].text : "(none)\n");
+            same = 0;
+        } else {
+            (*compared)++;
+            if (normal_capped) (*capped)++;
+        }
+    }
+    if (normal) fclose(normal);
+    if (lowmem) fclose(lowmem);
+    remove(NORMAL_OUTPUT);
+    remove(LOWMEM_OUTPUT);
+    return same;
+}
+
+int main(int argc, char **argv) {
+    char *codex_argv[MAX_FILES + SWITCH_COUNT + 1];
+    int codex_argc = 0;
+    ULONG budget = DEFAULT_BUDGET;
+    ULONG reported;
+    int compared = 0;
+    int capped = 0;
+    int status;
+    int i;
+
+    codex_argv[codex_argc++] = "codex";
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-budget") == 0 && i + 1 < argc) {
+            budget = (ULONG)atol(argv[++i]);
+        } else if (codex_argc <= MAX_FILES) {
+            codex_argv[codex_argc++] = argv[i];
+        }
+    }
+    if (codex_argc == 1) {
+        fprintf(stderr, "Usage: lowmem [-budget BYTES] FILES...\n");
+        return 1;
+    }
+    for (i = 0; i < SWITCH_COUNT; i++) codex_argv[codex_argc++] = lowmem_switches[i];
+    codex_argv[codex_argc] = NULL;
+
+    /* Before the run below, so that each child starts from Codex's initial globals */
+    for (i = 1; i < codex_argc - SWITCH_COUNT; i++) {
+        if (!compare_file(codex_argv[i], &compared, &capped)) return 1;
+    }
+    status = run_quietly(codex_argc, codex_argv);
+    if (status < 0 || status >= CODEX_RETURN_ERROR) {
+        printf("\nlowmem FAILED: Codex returned %d\n", status);
+        return 1;
+    }
+    reported = errors_streamed + (ULONG)error_count;
+    if (reported != diagnostics_found) {
+        printf("\nlowmem FAILED: %lu issues found but %lu printed\n",
+               (unsigned long)diagnostics_found, (unsigned long)reported);
+        return 1;
+    }
+    if (mem_heap_peak > budget) {
+        printf("\nlowmem FAILED: peak heap %lu bytes is over the %lu byte budget (%d lines, %lu issues)\n",
+               (unsigned long)mem_heap_peak, (unsigned long)budget, total_lines, (unsigned long)reported);
+        return 1;
+    }
+    printf("\nlowmem passed: peak heap %lu bytes of %lu for %d lines and %lu issues;"
+           " %d of %d files print the same issues as without LOWMEM",
+           (unsigned long)mem_heap_peak, (unsigned long)budget, total_lines, (unsigned long)reported,
+           compared, codex_argc - SWITCH_COUNT - 1);
+    if (capped > 0) printf(" (%d up to the %d-issue limit)", capped, MAX_ERRORS);
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Codex - steady-state allocation check
+ *
+ * Includes codex.c with malloc(), calloc() and realloc() routed through
+ * counters, so that direct C library allocations are seen alongside the
+ * AllocVec() blocks Codex charges to its subsystems.  Every file is linted
+ * once in every mode to let lazy set-up happen, then linted again; the
+ * second pass must not allocate at all.
+ *
+ * Host build only (VMakefile: make -f VMakefile memcheck).
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static unsigned long libc_allocations = 0;
+
+/* Not static, so they may go unused while codex.c makes no direct allocations */
+void *counted_malloc(size_t size);
+void *counted_calloc(size_t count, size_t size);
+void *counted_realloc(void *memory, size_t size);
+
+void *counted_malloc(size_t size) {
+    libc_allocations++;
+    return malloc(size);
+}
+
+void *counted_calloc(size_t count, size_t size) {
+    libc_allocations++;
+    return calloc(count, size);
+}
+
+void *counted_realloc(void *memory, size_t size) {
+    libc_allocations++;
+    return realloc(memory, size);
+}
+
+/* <stdlib.h> is already in, so codex.c's own include of it is a no-op */
+#define malloc(size) counted_malloc(size)
+#define calloc(count, size) counted_calloc(count, size)
+#define realloc(memory, size) counted_realloc(memory, size)
+
+#include "../codex.c"
+#undef main
+#undef malloc
+#undef calloc
+#undef realloc
+
+/* Each mode as main() resolves it: C89, C99, AMIGA, NDK, SASC, VBCC, DICE, MEMSAFE, ALL */
+static const int mode_flags[][8] = {
+    { 0, 0, 1, 0, 0, 0, 0, 0 },
+    { 0, 0, 0, 1, 0, 0, 0, 0 },
+    { 1, 1, 1, 0, 0, 0, 0, 0 },
+    { 0, 1, 1, 0, 0, 0, 0, 0 },
+    { 0, 1, 1, 0, 1, 0, 0, 0 },
+    { 0, 1, 0, 1, 0, 1, 0, 0 },
+    { 0, 1, 1, 0, 0, 0, 1, 0 },
+    { 0, 0, 1, 0, 0, 0, 0, 1 },
+    { 1, 1, 1, 1, 1, 1, 1, 1 }
+};
+
+static void set_mode(const int *flags) {
+    validate_amiga_standards = flags[0];
+    validate_ndk_standards = flags[1];
+    validate_c89_standards = flags[2];
+    validate_c99_standards = flags[3];
+    validate_sasc_standards = flags[4];
+    validate_vbcc_standards = flags[5];
+    validate_dice_standards = flags[6];
+    validate_memsafe_standards = flags[7];
+    enforce_amiga_pascalcase = flags[0];
+}
+
+static unsigned long heap_allocations(void) {
+    return libc_allocations + mem_blocks_allocated;
+}
+
+/* Lints every file in every mode; returns 0 if a file cannot be read */
+static int lint_all(int file_count, char **files) {
+    int m;
+    int f;
+
+    for (m = 0; m < (int)(sizeof(mode_flags) / sizeof(mode_flags[0])); m++) {
+        set_mode(mode_flags[m]);
+        for (f = 0; f < file_count; f++) {
+            error_count = 0;
+            if (process_file(files[f]) != 0) return 0;
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    unsigned long before;
+    unsigned long steady;
+    int lines;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: memcheck FILES...\n");
+        return 1;
+    }
+    quiet_mode = 1;
+
+    if (!lint_all(argc - 1, argv + 1)) return 1;
+    before = heap_allocations();
+    total_lines = 0;
+    if (!lint_all(argc - 1, argv + 1)) return 1;
+    steady = heap_allocations() - before;
+    lines = total_lines;
+
+    if (steady != 0) {
+        printf("\nmemcheck FAILED: %lu heap allocations while linting %d lines in steady state\n", steady, lines);
+        return 1;
+    }
+    printf("\nmemcheck passed: %d lines linted in steady state without heap allocations\n", lines);
+    return 0;
+}
@@ -0,0 +1,689 @@
+/*
+ * Codex - microbenchmarks for the innermost helpers
+ *
+ * Includes codex.c directly so its static lookup helpers, the magic number
+ * check and process_line() can be called on fixed token and line sets.
+ * Every benchmark is warmed up, then timed over many samples; the median,
+ * percentiles and median absolute deviation of the time per call are
+ * reported.  Benchmarks are sampled round-robin so that a machine slowing
+ * down mid-run affects all of them alike.  Each rule of process_line() is also timed on its own so a
+ * slowdown can be pinned to it.  For the exact-match tables a first-character index, binary
+ * search and hashing are measured next to Codex's linear scan, and all
+ * strategies are checked to agree before anything is timed.
+ *
+ * Host build only (VMakefile: make -f VMakefile microbench).
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "../codex.c"
+#undef main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_SAMPLES 31
+#define DEFAULT_WARMUP_MS 20
+#define MIN_SAMPLE_NS 2000000.0    /* Each sample runs at least this long */
+#define MAX_LINES 4096
+#define MAX_TOKENS 32768
+#define MAX_BENCH_LINE 1024
+#define FIRST_CHAR_SLOTS 257
+#define HASH_LOAD_FACTOR 4         /* Hash slots per table entry */
+#define FNV_OFFSET_BASIS 2166136261UL
+#define FNV_PRIME 16777619UL
+#define HASH_MASK_32 0xffffffffUL
+#define NANOSECONDS_PER_SECOND 1e9
+#define NANOSECONDS_PER_MILLISECOND 1e6
+#define PERCENTILE_LOW 10
+#define PERCENTILE_HIGH 90
+#define PERCENTILE_TAIL 99
+#define PERCENT_SCALE_F 100.0
+#define MAX_BENCHMARKS 64
+#define MAX_BENCH_NAME 64
+#define MAX_LOOKUP_FAMILIES 4
+#define STRATEGY_COUNT 4
+#define ALL_MODES "C89 C99 AMIGA NDK SASC VBCC DICE MEMSAFE"
+
+/* Representative Amiga C, used when no -lines file is given */
+static const char *default_lines[] = {
+    "#include <exec/types.h>",
+    "#include <proto/dos.h>",
+    "#include <string.h>",
+    "/* Open the window and wait for the close gadget */",
+    "static LONG OpenMainWindow(struct Screen *screen, STRPTR title)",
+    "{",
+    "    struct Window *window = NULL;",
+    "    struct IntuiMessage *message;",
+    "    LONG result = RETURN_OK;",
+    "    char buffer[BUFFER_SIZE];",
+    "    if (!screen) return RETURN_FAIL;",
+    "    window = OpenWindowTags(NULL, WA_Title, title, WA_Width, 320, TAG_END);",
+    "    strncpy(buffer, title, sizeof(buffer) - 1);",
+    "    buffer[sizeof(buffer) - 1] = '\\0';",
+    "    while (running) {",
+    "        Wait(1L << window->UserPort->mp_SigBit);",
+    "        while ((message = (struct IntuiMessage *)GetMsg(window->UserPort))) {",
+    "            if (message->Class == IDCMP_CLOSEWINDOW) running = FALSE;",
+    "            ReplyMsg((struct Message *)message);",
+    "        }",
+    "    }",
+    "    sprintf(buffer, \"%ld items\", (LONG)count);",
+    "    strcpy(name, buffer);",
+    "    length = strlen(name) + 4;",
+    "    memcpy(node->ln_Name, name, length);",
+    "    node = AllocVec(sizeof(struct Node), MEMF_CLEAR);",
+    "    Printf(\"Processed %ld of %ld // not a comment\\n\", done, total);",
+    "    for (i = 0; i < MAX_ENTRIES; i++) total += table[i] * 3;",
+    "    result = snprintf(buffer, sizeof(buffer), \"%s\", name);",
+    "    ULONG __saveds __asm LibInit(register __a6 struct Library *base)",
+    "    CloseWindow(window);",
+    "    FreeVec(node);",
+    "    return result;",
+    "}"
+};
+
+/* A sorted copy of a pattern table with the three alternative indexes */
+typedef struct {
+    const char **patterns;
+    int count;
+    const char **sorted;
+    int *order;               /* Original index of each sorted entry */
+    int first[FIRST_CHAR_SLOTS]; /* sorted[first[c]..first[c+1]) start with c */
+    int *slots;               /* Open addressing, -1 = empty, else original index */
+    unsigned long mask;
+} LookupIndex;
+
+typedef struct {
+    char name[MAX_BENCH_NAME];
+    long ops_per_pass;
+    void (*pass)(void *context);
+    void *context;
+    long repeats;  /* Passes per timed sample */
+    double *times; /* ns per operation of each sample */
+} Benchmark;
+
+/* One rule of process_line(), benchmarked on its own */
+typedef struct {
+    const char *name;
+    void (*check)(const char *line, int line_num, const char *filename, const char *original_line);
+} RuleBenchmark;
+
+typedef struct {
+    const LookupIndex *index;
+    int (*lookup)(const LookupIndex *index, const char *word);
+} LookupContext;
+
+static const char *lines[MAX_LINES];
+static int line_count = 0;
+static char *tokens[MAX_TOKENS];
+static int token_count = 0;
+static volatile long bench_sink = 0;
+
+static RuleBenchmark rule_benchmarks[] = {
+    { "rule/c89", check_c89_standards },
+    { "rule/c99", check_c99_standards },
+    { "rule/amiga", check_amiga_standards },
+    { "rule/ndk", check_ndk_standards },
+    { "rule/sasc", check_sasc_standards },
+    { "rule/vbcc", check_vbcc_standards },
+    { "rule/dice", check_dice_standards },
+    { "rule/memsafe", check_memsafe_standards },
+    { "rule/forbid-permit", check_forbid_permit_pairs },
+    { "rule/loops", check_loop_scopes }
+};
+
+static Benchmark benchmarks[MAX_BENCHMARKS];
+static int benchmark_count = 0;
+static LookupIndex lookup_indexes[MAX_LOOKUP_FAMILIES];
+static LookupContext lookup_contexts[MAX_LOOKUP_FAMILIES * STRATEGY_COUNT];
+static int lookup_family_count = 0;
+
+static int samples = DEFAULT_SAMPLES;
+static int codex_only = 0;
+static double warmup_ms = DEFAULT_WARMUP_MS;
+static const char *filter = NULL;
+static FILE *json = NULL;
+static int json_entries = 0;
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * NANOSECONDS_PER_SECOND + (double)ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static int compare_patterns(const void *a, const void *b) {
+    return strcmp(*(const char * const *)a, *(const char * const *)b);
+}
+
+/* Value at the given percentile of a sorted array (nearest rank) */
+static double percentile(const double *sorted, int count, int pct) {
+    int rank = (int)((pct * (count - 1) + PERCENT_SCALE - 1) / PERCENT_SCALE);
+    return sorted[rank];
+}
+
+static unsigned long hash_string(const char *s) {
+    unsigned long h = FNV_OFFSET_BASIS;
+
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h = (h * FNV_PRIME) & HASH_MASK_32;
+    }
+    return h;
+}
+
+static void build_index(LookupIndex *index, const char **patterns, int count) {
+    const char **entries;
+    unsigned long size = 1;
+    int c;
+    int i;
+    int j;
+
+    index->patterns = patterns;
+    index->count = count;
+    index->sorted = malloc((size_t)count * sizeof(char *));
+    index->order = malloc((size_t)count * sizeof(int));
+    entries = malloc((size_t)count * sizeof(char *));
+    while (size < (unsigned long)(count * HASH_LOAD_FACTOR)) size <<= 1;
+    index->slots = malloc((size_t)size * sizeof(int));
+    index->mask = size - 1;
+    if (!index->sorted || !index->order || !entries || !index->slots) {
+        fprintf(stderr, "microbench: out of memory\n");
+        exit(1);
+    }
+
+    /* Sort pointers into the table; duplicates keep the first original index */
+    for (i = 0; i < count; i++) entries[i] = patterns[i];
+    qsort(entries, (size_t)count, sizeof(char *), compare_patterns);
+    for (i = 0; i < count; i++) {
+        index->sorted[i] = entries[i];
+        for (j = 0; j < count && strcmp(patterns[j], entries[i]) != 0; j++) { }
+        index->order[i] = j;
+    }
+    free(entries);
+
+    c = 0;
+    for (i = 0; i < FIRST_CHAR_SLOTS; i++) {
+        while (c < count && (unsigned char)index->sorted[c][0] < i) c++;
+        index->first[i] = c;
+    }
+
+    for (i = 0; i <= (int)index->mask; i++) index->slots[i] = -1;
+    for (i = 0; i < count; i++) {
+        unsigned long slot = hash_string(patterns[i]) & index->mask;
+        int taken = 0;
+
+        while (index->slots[slot] >= 0) {
+            if (strcmp(patterns[index->slots[slot]], patterns[i]) == 0) taken = 1;
+            slot = (slot + 1) & index->mask;
+        }
+        if (!taken) index->slots[slot] = i;
+    }
+}
+
+/* Codex's own strategy: scan the table in order */
+static int lookup_linear(const LookupIndex *index, const char *word) {
+    int i;
+
+    for (i = 0; i < index->count; i++) {
+        if (strcmp(word, index->patterns[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static int lookup_first_char(const LookupIndex *index, const char *word) {
+    int c = (unsigned char)word[0];
+    int i;
+
+    for (i = index->first[c]; i < index->first[c + 1]; i++) {
+        if (strcmp(word, index->sorted[i]) == 0) return index->order[i];
+    }
+    return -1;
+}
+
+static int lookup_bsearch(const LookupIndex *index, const char *word) {
+    int low = 0;
+    int high = index->count - 1;
+
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        int cmp = strcmp(word, index->sorted[middle]);
+
+        if (cmp == 0) {
+            /* Step back to the first of any duplicates */
+            while (middle > 0 && strcmp(word, index->sorted[middle - 1]) == 0) middle--;
+            return index->order[middle];
+        }
+        if (cmp < 0) high = middle - 1;
+        else low = middle + 1;
+    }
+    return -1;
+}
+
+static int lookup_hash(const LookupIndex *index, const char *word) {
+    unsigned long slot = hash_string(word) & index->mask;
+
+    while (index->slots[slot] >= 0) {
+        if (strcmp(word, index->patterns[index->slots[slot]]) == 0) return index->slots[slot];
+        slot = (slot + 1) & index->mask;
+    }
+    return -1;
+}
+
+/* Splits the lines into words the way the token-based rules do */
+static void build_tokens(void) {
+    static char storage[MAX_LINES][MAX_BENCH_LINE];
+    int i;
+
+    for (i = 0; i < line_count && token_count < MAX_TOKENS; i++) {
+        char *token;
+
+        strncpy(storage[i], lines[i], MAX_BENCH_LINE - 1);
+        storage[i][MAX_BENCH_LINE - 1] = '\0';
+        for (token = strtok(storage[i], " \t\n\r*();,"); token && token_count < MAX_TOKENS;
+             token = strtok(NULL, " \t\n\r*();,")) {
+            tokens[token_count++] = token;
+        }
+    }
+}
+
+static int load_lines(const char *filename) {
+    static char storage[MAX_LINES][MAX_BENCH_LINE];
+    FILE *file = fopen(filename, "r");
+
+    if (!file) return 0;
+    line_count = 0;
+    while (line_count < MAX_LINES && fgets(storage[line_count], MAX_BENCH_LINE, file)) {
+        storage[line_count][strcspn(storage[line_count], "\n\r")] = '\0';
+        lines[line_count] = storage[line_count];
+        line_count++;
+    }
+    fclose(file);
+    return line_count > 0;
+}
+
+static void set_mode(const char *mode);
+
+/* Passes over the token and line sets ------------------------------------ */
+
+static void pass_lookup(void *context) {
+    const LookupContext *lookup = context;
+    long found = 0;
+    int i;
+
+    for (i = 0; i < token_count; i++) found += lookup->lookup(lookup->index, tokens[i]);
+    bench_sink += found;
+}
+
+static void pass_is_stdlib_function(void *context) {
+    long found = 0;
+    int i;
+
+    (void)context;
+    for (i = 0; i < token_count; i++) found += is_stdlib_function(tokens[i]);
+    bench_sink += found;
+}
+
+static void pass_is_memsafe_unsafe_function(void *context) {
+    long found = 0;
+    int i;
+
+    (void)context;
+    for (i = 0; i < token_count; i++) found += is_memsafe_unsafe_function(tokens[i]);
+    bench_sink += found;
+}
+
+static void pass_find_universal_replacement(void *context) {
+    char replacement[REPLACEMENT_BUFFER_SIZE];
+    long found = 0;
+    int i;
+
+    (void)context;
+    for (i = 0; i < token_count; i++) {
+        found += find_universal_replacement(tokens[i], replacement, sizeof(replacement));
+    }
+    bench_sink += found;
+}
+
+static void pass_is_c99_stdlib_function(void *context) {
+    long found = 0;
+    int i;
+
+    (void)context;
+    for (i = 0; i < line_count; i++) found += is_c99_stdlib_function(lines[i]);
+    bench_sink += found;
+}
+
+static void pass_check_for_magic_numbers(void *context) {
+    int i;
+
+    (void)context;
+    error_count = 0;
+    for (i = 0; i < line_count; i++) check_for_magic_numbers(lines[i], i + 1, "bench.c", lines[i]);
+    bench_sink += error_count;
+}
+
+static void pass_rule(void *context) {
+    const RuleBenchmark *rule = context;
+    int i;
+
+    set_mode(ALL_MODES);
+    error_count = 0;
+    memset(&parse_state, 0, sizeof(parse_state));
+    for (i = 0; i < line_count; i++) rule->check(lines[i], i + 1, "bench.c", lines[i]);
+    bench_sink += error_count;
+}
+
+static void pass_process_line(void *context) {
+    int i;
+
+    set_mode((const char *)context);
+    error_count = 0;
+    memset(&parse_state, 0, sizeof(parse_state));
+    for (i = 0; i < line_count; i++) process_line(lines[i], i + 1, "bench.c");
+    bench_sink += error_count;
+}
+
+/* Mirrors the mode implications in main(), in the same order */
+static void set_mode(const char *mode) {
+    int c89 = strstr(mode, "C89") != NULL;
+    int c99 = strstr(mode, "C99") != NULL;
+
+    validate_amiga_standards = strstr(mode, "AMIGA") != NULL;
+    validate_ndk_standards = strstr(mode, "NDK") != NULL;
+    validate_c89_standards = 1;
+    validate_c99_standards = c99;
+    validate_sasc_standards = strstr(mode, "SASC") != NULL;
+    validate_vbcc_standards = strstr(mode, "VBCC") != NULL;
+    validate_dice_standards = strstr(mode, "DICE") != NULL;
+    validate_memsafe_standards = strstr(mode, "MEMSAFE") != NULL;
+
+    if (c99 && !c89 && !validate_sasc_standards && !validate_dice_standards && !validate_memsafe_standards) {
+        validate_c89_standards = 0;
+    }
+    if (validate_sasc_standards) {
+        validate_c89_standards = 1;
+        validate_c99_standards = 0;
+    }
+    if (validate_vbcc_standards) {
+        validate_c99_standards = 1;
+        validate_c89_standards = 0;
+    }
+    if (validate_amiga_standards) validate_ndk_standards = 1;
+    if (validate_dice_standards) {
+        validate_c89_standards = 1;
+        validate_ndk_standards = 1;
+    }
+    if (validate_memsafe_standards) validate_c89_standards = 1;
+    if (!validate_c89_standards && !validate_c99_standards && !validate_sasc_standards &&
+        !validate_vbcc_standards && !validate_dice_standards) {
+        validate_c89_standards = 1;
+    }
+}
+
+/* Timing ------------------------------------------------------------------ */
+
+static void add_benchmark(const char *name, void (*pass)(void *context), void *context, long ops_per_pass) {
+    Benchmark *bench;
+
+    if (filter && !strstr(name, filter)) return;
+    if (benchmark_count >= MAX_BENCHMARKS) {
+        fprintf(stderr, "microbench: too many benchmarks\n");
+        exit(1);
+    }
+    bench = &benchmarks[benchmark_count++];
+    strncpy(bench->name, name, sizeof(bench->name) - 1);
+    bench->name[sizeof(bench->name) - 1] = '\0';
+    bench->pass = pass;
+    bench->context = context;
+    bench->ops_per_pass = ops_per_pass;
+    bench->repeats = 1;
+    bench->times = malloc((size_t)samples * sizeof(double));
+    if (!bench->times) {
+        fprintf(stderr, "microbench: out of memory\n");
+        exit(1);
+    }
+}
+
+/* Warms up caches and branch predictors, then sizes samples from one pass */
+static void calibrate(Benchmark *bench) {
+    double start = now_ns();
+    double elapsed;
+
+    do {
+        bench->pass(bench->context);
+        elapsed = now_ns() - start;
+    } while (elapsed < warmup_ms * NANOSECONDS_PER_MILLISECOND);
+    start = now_ns();
+    bench->pass(bench->context);
+    elapsed = now_ns() - start;
+    if (elapsed > 0 && elapsed < MIN_SAMPLE_NS) bench->repeats = (long)(MIN_SAMPLE_NS / elapsed) + 1;
+}
+
+static void report(Benchmark *bench) {
+    double *deviations = malloc((size_t)samples * sizeof(double));
+    double median_ns;
+    double mad_ns;
+    int i;
+
+    if (!deviations) {
+        fprintf(stderr, "microbench: out of memory\n");
+        exit(1);
+    }
+    qsort(bench->times, (size_t)samples, sizeof(double), compare_doubles);
+    median_ns = percentile(bench->times, samples, PERCENT_SCALE / 2);
+    for (i = 0; i < samples; i++) {
+        deviations[i] = bench->times[i] > median_ns ? bench->times[i] - median_ns : median_ns - bench->times[i];
+    }
+    qsort(deviations, (size_t)samples, sizeof(double), compare_doubles);
+    mad_ns = percentile(deviations, samples, PERCENT_SCALE / 2);
+    free(deviations);
+
+    printf("%-40s %10.2f %10.2f %10.2f %10.2f %8.2f %9ld\n", bench->name, median_ns,
+           percentile(bench->times, samples, PERCENTILE_LOW), percentile(bench->times, samples, PERCENTILE_HIGH),
+           percentile(bench->times, samples, PERCENTILE_TAIL),
+           median_ns > 0 ? PERCENT_SCALE_F * mad_ns / median_ns : 0.0, bench->ops_per_pass);
+    if (json) {
+        fprintf(json, "%s\n    { \"name\": \"%s\", \"unit\": \"ns/op\", \"median\": %.3f, \"mad\": %.3f,"
+                      " \"p10\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"samples\": %d, \"ops_per_sample\": %ld }",
+                json_entries++ ? "," : "", bench->name, median_ns, mad_ns,
+                percentile(bench->times, samples, PERCENTILE_LOW),
+                percentile(bench->times, samples, PERCENTILE_HIGH),
+                percentile(bench->times, samples, PERCENTILE_TAIL), samples, bench->repeats * bench->ops_per_pass);
+    }
+}
+
+/* Samples all benchmarks round-robin, so drift in machine speed while the
+   suite runs is spread over every benchmark instead of hitting a few */
+static void run_benchmarks(void) {
+    int b;
+    int i;
+    long r;
+
+    for (b = 0; b < benchmark_count; b++) calibrate(&benchmarks[b]);
+    for (i = 0; i < samples; i++) {
+        for (b = 0; b < benchmark_count; b++) {
+            Benchmark *bench = &benchmarks[b];
+            double start = now_ns();
+
+            for (r = 0; r < bench->repeats; r++) bench->pass(bench->context);
+            bench->times[i] = (now_ns() - start) / (double)(bench->repeats * bench->ops_per_pass);
+        }
+    }
+    for (b = 0; b < benchmark_count; b++) {
+        report(&benchmarks[b]);
+        free(benchmarks[b].times);
+    }
+}
+
+/* Registers Codex's lookup and, unless -codex-only, the four strategies over
+   the same table, after checking that they all agree */
+static void add_lookup_family(const char *family, const char **patterns, int count,
+                              void (*codex_pass)(void *context)) {
+    static const char *strategy_names[] = { "linear", "first-char", "bsearch", "hash" };
+    int (*strategies[])(const LookupIndex *, const char *) = {
+        lookup_linear, lookup_first_char, lookup_bsearch, lookup_hash
+    };
+    LookupIndex *index;
+    char name[MAX_BENCH_LINE];
+    int s;
+    int i;
+
+    sprintf(name, "%s/codex", family);
+    add_benchmark(name, codex_pass, NULL, token_count);
+    if (codex_only) return;
+
+    if (lookup_family_count >= MAX_LOOKUP_FAMILIES) {
+        fprintf(stderr, "microbench: too many lookup families\n");
+        exit(1);
+    }
+    index = &lookup_indexes[lookup_family_count++];
+    build_index(index, patterns, count);
+    for (i = 0; i < token_count; i++) {
+        int expected = lookup_linear(index, tokens[i]);
+        for (s = 1; s < STRATEGY_COUNT; s++) {
+            if (strategies[s](index, tokens[i]) != expected) {
+                fprintf(stderr, "microbench: %s lookup of '%s' disagrees (%s)\n",
+                        family, tokens[i], strategy_names[s]);
+                exit(1);
+            }
+        }
+    }
+    for (s = 0; s < STRATEGY_COUNT; s++) {
+        LookupContext *context = &lookup_contexts[(lookup_family_count - 1) * STRATEGY_COUNT + s];
+
+        context->index = index;
+        context->lookup = strategies[s];
+        sprintf(name, "%s/%s", family, strategy_names[s]);
+        add_benchmark(name, pass_lookup, context, token_count);
+    }
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: microbench [-samples N] [-warmup MS] [-lines FILE] [-filter TEXT] [-codex-only] [-json FILE]\n\n");
+    fprintf(stderr, "  -samples N    Timed samples per benchmark (default %d)\n", DEFAULT_SAMPLES);
+    fprintf(stderr, "  -warmup MS    Warm-up time per benchmark (default %d)\n", DEFAULT_WARMUP_MS);
+    fprintf(stderr, "  -lines FILE   Take up to %d lines from FILE instead of the built-in set\n", MAX_LINES);
+    fprintf(stderr, "  -filter TEXT  Only run benchmarks whose name contains TEXT\n");
+    fprintf(stderr, "  -codex-only   Skip the alternative lookup strategies\n");
+    fprintf(stderr, "  -json FILE    Also write the results as JSON\n");
+}
+
+int main(int argc, char **argv) {
+    static const char *process_modes[] = {
+        "C89", "C99", "AMIGA", "NDK", "SASC", "VBCC", "DICE", "MEMSAFE"
+    };
+    const char *json_name = NULL;
+    char name[MAX_BENCH_LINE];
+    int i;
+
+    for (i = 0; i < (int)(sizeof(default_lines) / sizeof(default_lines[0])); i++) {
+        lines[line_count++] = default_lines[i];
+    }
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-codex-only") == 0) {
+            codex_only = 1;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (strcmp(argv[i], "-samples") == 0) samples = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-warmup") == 0) warmup_ms = atof(argv[++i]);
+        else if (strcmp(argv[i], "-filter") == 0) filter = argv[++i];
+        else if (strcmp(argv[i], "-json") == 0) json_name = argv[++i];
+        else if (strcmp(argv[i], "-lines") == 0) {
+            if (!load_lines(argv[++i])) {
+                fprintf(stderr, "microbench: cannot read lines from '%s'\n", argv[i]);
+                return 1;
+            }
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (samples < 1) {
+        usage();
+        return 1;
+    }
+
+    build_tokens();
+    quiet_mode = 1;
+
+    add_lookup_family("is_stdlib_function", stdlib_functions,
+                      (int)(sizeof(stdlib_functions) / sizeof(stdlib_functions[0])), pass_is_stdlib_function);
+    add_lookup_family("is_memsafe_unsafe_function", memsafe_unsafe_functions,
+                      (int)(sizeof(memsafe_unsafe_functions) / sizeof(memsafe_unsafe_functions[0])),
+                      pass_is_memsafe_unsafe_function);
+    add_lookup_family("find_universal_replacement", non_universal_keywords,
+                      (int)(sizeof(non_universal_keywords) / sizeof(non_universal_keywords[0])),
+                      pass_find_universal_replacement);
+    add_benchmark("is_c99_stdlib_function/codex", pass_is_c99_stdlib_function, NULL, line_count);
+    add_benchmark("check_for_magic_numbers/codex", pass_check_for_magic_numbers, NULL, line_count);
+
+    /* Rules on their own, with every mode on so no rule takes an early exit */
+    for (i = 0; i < (int)(sizeof(rule_benchmarks) / sizeof(rule_benchmarks[0])); i++) {
+        add_benchmark(rule_benchmarks[i].name, pass_rule, &rule_benchmarks[i], line_count);
+    }
+    for (i = 0; i < (int)(sizeof(process_modes) / sizeof(process_modes[0])); i++) {
+        sprintf(name, "process_line/%s", process_modes[i]);
+        add_benchmark(name, pass_process_line, (void *)process_modes[i], line_count);
+    }
+    add_benchmark("process_line/ALL", pass_process_line, (void *)ALL_MODES, line_count);
+
+    if (json_name) {
+        json = fopen(json_name, "w");
+        if (!json) {
+            fprintf(stderr, "microbench: cannot create '%s'\n", json_name);
+            return 1;
+        }
+        fprintf(json, "{\n  \"tool\": \"Codex microbench\",\n  \"lines\": %d,\n  \"results\": [", line_count);
+    }
+    printf("%d lines, %d tokens, %d samples per benchmark\n\n", line_count, token_count, samples);
+    printf("%-40s %10s %10s %10s %10s %8s %9s\n", "Benchmark (ns/op)", "median", "p10", "p90", "p99", "MAD%", "ops/pass");
+    run_benchmarks();
+
+    if (json) {
+        fprintf(json, "\n  ]\n}\n");
+        if (fclose(json) != 0) {
+            fprintf(stderr, "microbench: error writing '%s'\n", json_name);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,322 @@
+/*
+ * Codex - mode cost matrix
+ *
+ * Includes codex.c and times, over a corpus held in memory, the lexer on
+ * its own, every validation mode on its own, and the mode combinations
+ * commonly run from the command line.  Each configuration is reported with
+ * its throughput and its marginal cost over lexing alone, as a table on
+ * stdout and optionally as JSON, to help decide which modes are cheap
+ * enough to run on every commit.
+ *
+ * Host build only (VMakefile: make -f VMakefile modecost).
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "../codex.c"
+#undef main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_RUNS 5
+#define NANOSECONDS_PER_SECOND 1e9
+#define NANOSECONDS_PER_MILLISECOND 1e6
+#define BYTES_PER_MB 1048576.0
+
+/* How a configuration sets the validate_* flags */
+typedef enum {
+    KIND_LEXER,       /* lex_line() only, no rules */
+    KIND_SINGLE,      /* Exactly one validate_* flag, no implied modes */
+    KIND_COMBINATION  /* Switches resolved by select_validation_modes(), as main() does */
+} ConfigKind;
+
+/* One row of the matrix */
+typedef struct {
+    const char *name;
+    ConfigKind kind;
+    ModeSwitches switches; /* amiga, ndk, c89, c99, sasc, vbcc, dice, memsafe */
+} CostConfig;
+
+static const char *kind_names[] = { "baseline", "single", "combination" };
+
+static const CostConfig configs[] = {
+    { "(lexer)",       KIND_LEXER,       { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { "(no modes)",    KIND_SINGLE,      { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { "c89",           KIND_SINGLE,      { 0, 0, 1, 0, 0, 0, 0, 0 } },
+    { "c99",           KIND_SINGLE,      { 0, 0, 0, 1, 0, 0, 0, 0 } },
+    { "amiga",         KIND_SINGLE,      { 1, 0, 0, 0, 0, 0, 0, 0 } },
+    { "ndk",           KIND_SINGLE,      { 0, 1, 0, 0, 0, 0, 0, 0 } },
+    { "sasc",          KIND_SINGLE,      { 0, 0, 0, 0, 1, 0, 0, 0 } },
+    { "vbcc",          KIND_SINGLE,      { 0, 0, 0, 0, 0, 1, 0, 0 } },
+    { "dice",          KIND_SINGLE,      { 0, 0, 0, 0, 0, 0, 1, 0 } },
+    { "memsafe",       KIND_SINGLE,      { 0, 0, 0, 0, 0, 0, 0, 1 } },
+    { "default",       KIND_COMBINATION, { 0, 0, 0, 0, 0, 0, 0, 0 } },
+    { "AMIGA",         KIND_COMBINATION, { 1, 0, 0, 0, 0, 0, 0, 0 } },
+    { "AMIGA MEMSAFE", KIND_COMBINATION, { 1, 0, 0, 0, 0, 0, 0, 1 } },
+    { "SASC",          KIND_COMBINATION, { 0, 0, 0, 0, 1, 0, 0, 0 } },
+    { "VBCC",          KIND_COMBINATION, { 0, 0, 0, 0, 0, 1, 0, 0 } },
+    { "DICE",          KIND_COMBINATION, { 0, 0, 0, 0, 0, 0, 1, 0 } },
+    { "C99",           KIND_COMBINATION, { 0, 0, 0, 1, 0, 0, 0, 0 } }
+};
+
+#define CONFIG_COUNT ((int)(sizeof(configs) / sizeof(configs[0])))
+
+/* One corpus file, split into lines in place */
+typedef struct {
+    const char *name;
+    char *text;
+    char **lines;
+    int line_count;
+} CorpusFile;
+
+static CorpusFile *corpus;
+static int corpus_count = 0;
+static long corpus_bytes = 0;
+static long corpus_lines = 0;
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * NANOSECONDS_PER_SECOND + (double)ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Reads a file and splits it into lines the way process_file() sees them */
+static int load_file(const char *filename, CorpusFile *file) {
+    FILE *in = fopen(filename, "rb");
+    long size;
+    char *p;
+    int n;
+
+    if (!in) return 0;
+    fseek(in, 0, SEEK_END);
+    size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    file->text = malloc((size_t)size + 1);
+    if (!file->text || fread(file->text, 1, (size_t)size, in) != (size_t)size) {
+        fclose(in);
+        return 0;
+    }
+    fclose(in);
+    file->text[size] = '\0';
+    file->name = filename;
+    corpus_bytes += size;
+
+    file->line_count = 0;
+    for (p = file->text; *p; p++) if (*p == '\n') file->line_count++;
+    if (size > 0 && file->text[size - 1] != '\n') file->line_count++;
+    file->lines = malloc(((size_t)file->line_count + 1) * sizeof(char *));
+    if (!file->lines) return 0;
+
+    for (n = 0, p = file->text; n < file->line_count; n++) {
+        char *end = strchr(p, '\n');
+
+        file->lines[n] = p;
+        if (end) *end = '\0';
+        p[strcspn(p, "\r")] = '\0';
+        /* process_file() only checks the first part of an overlong line */
+        if (strlen(p) >= MAX_LINE_LENGTH) p[MAX_LINE_LENGTH - 1] = '\0';
+        p = end ? end + 1 : p + strlen(p);
+    }
+    corpus_lines += file->line_count;
+    return 1;
+}
+
+static void set_config(const CostConfig *config) {
+    if (config->kind == KIND_COMBINATION) {
+        select_validation_modes(&config->switches);
+        return;
+    }
+    validate_amiga_standards = config->switches.amiga != 0;
+    validate_ndk_standards = config->switches.ndk != 0;
+    validate_c89_standards = config->switches.c89 != 0;
+    validate_c99_standards = config->switches.c99 != 0;
+    validate_sasc_standards = config->switches.sasc != 0;
+    validate_vbcc_standards = config->switches.vbcc != 0;
+    validate_dice_standards = config->switches.dice != 0;
+    validate_memsafe_standards = config->switches.memsafe != 0;
+}
+
+/* Lints the whole corpus once in one configuration; returns nanoseconds */
+static double run_config(const CostConfig *config) {
+    static char original_line[MAX_LINE_LENGTH];
+    static char clean_line[MAX_LINE_LENGTH];
+    double start;
+    int f;
+    int n;
+
+    set_config(config);
+    start = now_ns();
+    for (f = 0; f < corpus_count; f++) {
+        const CorpusFile *file = &corpus[f];
+
+        memset(&parse_state, 0, sizeof(parse_state));
+        if (config->kind == KIND_LEXER) {
+            for (n = 0; n < file->line_count; n++) {
+                error_count = 0;
+                lex_line(file->lines[n], n + 1, file->name, original_line, clean_line);
+            }
+        } else {
+            for (n = 0; n < file->line_count; n++) {
+                error_count = 0; /* Never reach MAX_ERRORS, past which issues cost nothing */
+                process_line(file->lines[n], n + 1, file->name);
+            }
+            finish_file(file->name, file->line_count);
+        }
+    }
+    return now_ns() - start;
+}
+
+static void write_json(FILE *out, int runs, const double *median_ns) {
+    double lexer_ns = median_ns[0];
+    int c;
+
+    fprintf(out, "{\n  \"files\": %d,\n  \"bytes\": %ld,\n  \"lines\": %ld,\n  \"runs\": %d,\n",
+            corpus_count, corpus_bytes, corpus_lines, runs);
+    fprintf(out, "  \"lexer_ms\": %.3f,\n  \"configs\": [", lexer_ns / NANOSECONDS_PER_MILLISECOND);
+    for (c = 0; c < CONFIG_COUNT; c++) {
+        double seconds = median_ns[c] / NANOSECONDS_PER_SECOND;
+        double marginal_ns = median_ns[c] - lexer_ns;
+
+        fprintf(out, "%s\n    { \"name\": \"%s\", \"kind\": \"%s\", \"median_ms\": %.3f,"
+                " \"mb_per_s\": %.3f, \"lines_per_s\": %.0f, \"marginal_ms\": %.3f,"
+                " \"marginal_ns_per_byte\": %.3f, \"marginal_x_lexer\": %.3f }",
+                c ? "," : "", configs[c].name, kind_names[configs[c].kind],
+                median_ns[c] / NANOSECONDS_PER_MILLISECOND,
+                seconds > 0.0 ? corpus_bytes / BYTES_PER_MB / seconds : 0.0,
+                seconds > 0.0 ? corpus_lines / seconds : 0.0,
+                marginal_ns / NANOSECONDS_PER_MILLISECOND,
+                corpus_bytes > 0 ? marginal_ns / corpus_bytes : 0.0,
+                lexer_ns > 0.0 ? marginal_ns / lexer_ns : 0.0);
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: modecost [-runs N] [-json FILE] FILES...\n\n");
+    fprintf(stderr, "  -runs N     Passes over the corpus per configuration, the median is used (default %d)\n", DEFAULT_RUNS);
+    fprintf(stderr, "  -json FILE  Also write the matrix as JSON\n");
+}
+
+int main(int argc, char **argv) {
+    const char *json_name = NULL;
+    int runs = DEFAULT_RUNS;
+    double *times;
+    double median_ns[CONFIG_COUNT];
+    double lexer_ns;
+    int r;
+    int c;
+    int i;
+
+    corpus = malloc((size_t)argc * sizeof(CorpusFile));
+    if (!corpus) return 1;
+    for (i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            if (!load_file(argv[i], &corpus[corpus_count])) {
+                fprintf(stderr, "modecost: cannot read '%s'\n", argv[i]);
+                return 1;
+            }
+            corpus_count++;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (strcmp(argv[i], "-runs") == 0) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-json") == 0) {
+            json_name = argv[++i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (corpus_count == 0 || runs < 1) {
+        usage();
+        return 1;
+    }
+
+    quiet_mode = 1;
+    if (!engine_open()) {
+        fprintf(stderr, "modecost: not enough memory for the FAST engine\n");
+        return 1;
+    }
+    times = malloc((size_t)(runs * CONFIG_COUNT) * sizeof(double));
+    if (!times) return 1;
+
+    /* One untimed pass warms the caches; then the configurations take turns,
+       so drift in machine speed is shared between them */
+    for (c = 0; c < CONFIG_COUNT; c++) run_config(&configs[c]);
+    for (r = 0; r < runs; r++) {
+        for (c = 0; c < CONFIG_COUNT; c++) times[c * runs + r] = run_config(&configs[c]);
+    }
+    for (c = 0; c < CONFIG_COUNT; c++) {
+        qsort(times + c * runs, (size_t)runs, sizeof(double), compare_doubles);
+        median_ns[c] = times[c * runs + runs / 2];
+    }
+    lexer_ns = median_ns[0];
+
+    printf("Mode cost over %d files, %ld lines, %ld bytes (median of %d runs)\n\n",
+           corpus_count, corpus_lines, corpus_bytes, runs);
+    printf("%-16s %-12s %10s %10s %12s %10s\n", "Config", "Kind", "Time (ms)", "MB/s", "+ns/byte", "x lexer");
+    for (c = 0; c < CONFIG_COUNT; c++) {
+        double seconds = median_ns[c] / NANOSECONDS_PER_SECOND;
+        double marginal_ns = median_ns[c] - lexer_ns;
+
+        printf("%-16s %-12s %10.3f %10.2f %12.2f %10.2f\n", configs[c].name, kind_names[configs[c].kind],
+               median_ns[c] / NANOSECONDS_PER_MILLISECOND,
+               seconds > 0.0 ? corpus_bytes / BYTES_PER_MB / seconds : 0.0,
+               corpus_bytes > 0 ? marginal_ns / corpus_bytes : 0.0,
+               lexer_ns > 0.0 ? marginal_ns / lexer_ns : 0.0);
+    }
+    printf("\n+ns/byte and x lexer are the cost on top of lexing alone; single modes run\n"
+           "without the modes they imply, combinations as the command line resolves them.\n");
+
+    if (json_name) {
+        FILE *out = fopen(json_name, "w");
+
+        if (!out) {
+            fprintf(stderr, "modecost: cannot write '%s'\n", json_name);
+            return 1;
+        }
+        write_json(out, runs, median_ns);
+        fclose(out);
+    }
+    engine_close();
+    return 0;
+}
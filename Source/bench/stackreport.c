@@ -0,0 +1,248 @@
+/*
+ * Codex - stack budget report
+ *
+ * Reads the call graph GCC writes with -fcallgraph-info=su, in which every
+ * function of codex.c carries its frame size, and finds the deepest stack
+ * a call from main() can reach through Codex's own functions.  Prints that
+ * chain frame by frame and the largest frames overall, and fails if the
+ * chain is over the budget or a function can reach itself, since then no
+ * bound exists.  Library calls (dos.library, the C library) are not in
+ * the graph; the budget leaves the rest of the $STACK cookie for them.
+ *
+ * Host build only (VMakefile: make -f VMakefile stack).
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_ROOT "codex_host_main"
+#define DEFAULT_BUDGET 2048
+#define MAX_FUNCTIONS 1024
+#define MAX_CALLS 8192
+#define MAX_NAME 128
+#define MAX_GRAPH_LINE 1024
+#define LARGEST_SHOWN 10
+
+/* A node of the call graph; frame is -1 for functions outside codex.c */
+typedef struct {
+    char title[MAX_NAME];
+    long frame;
+    long worst;  /* Frame plus the deepest callee chain, once known */
+    int next;    /* Callee on that chain, -1 if none */
+    int state;   /* 0 not visited, 1 on the current path, 2 done */
+} Function;
+
+typedef struct {
+    int caller;
+    int callee;
+} Call;
+
+static Function functions[MAX_FUNCTIONS];
+static int function_count = 0;
+static Call calls[MAX_CALLS];
+static int call_count = 0;
+static int recursion_found = 0;
+
+/* Copies the quoted value after key on the line; returns 0 if there is none */
+static int quoted_field(const char *line, const char *key, char *value, size_t size) {
+    const char *start = strstr(line, key);
+    const char *end;
+
+    if (!start) return 0;
+    start += strlen(key);
+    end = strchr(start, '"');
+    if (!end || (size_t)(end - start) >= size) return 0;
+    memcpy(value, start, (size_t)(end - start));
+    value[end - start] = '\0';
+    return 1;
+}
+
+static int find_function(const char *title) {
+    int i;
+
+    for (i = 0; i < function_count; i++) {
+        if (strcmp(functions[i].title, title) == 0) return i;
+    }
+    return -1;
+}
+
+/* Returns the index of the named function, adding it if it is new */
+static int add_function(const char *title) {
+    int i = find_function(title);
+
+    if (i >= 0 || function_count >= MAX_FUNCTIONS) return i;
+    i = function_count++;
+    strcpy(functions[i].title, title);
+    functions[i].frame = -1;
+    functions[i].worst = 0;
+    functions[i].next = -1;
+    functions[i].state = 0;
+    return i;
+}
+
+/* The function name without the "file.c:" prefix GCC gives static functions */
+static const char *short_name(const Function *function) {
+    const char *colon = strrchr(function->title, ':');
+
+    return colon ? colon + 1 : function->title;
+}
+
+/* Reads node and edge lines; the frame is the "N bytes" line of the label */
+static int read_graph(const char *filename) {
+    char line[MAX_GRAPH_LINE];
+    char title[MAX_NAME];
+    char label[MAX_GRAPH_LINE];
+    char callee[MAX_NAME];
+    FILE *graph = fopen(filename, "r");
+
+    if (!graph) {
+        fprintf(stderr, "stackreport: cannot read '%s'\n", filename);
+        return 0;
+    }
+    while (fgets(line, sizeof(line), graph)) {
+        if (strncmp(line, "node:", 5) == 0) {
+            const char *bytes;
+            int i;
+
+            if (!quoted_field(line, "title: \"", title, sizeof(title))) continue;
+            i = add_function(title);
+            if (i < 0) break;
+            if (!quoted_field(line, "label: \"", label, sizeof(label))) continue;
+            bytes = strstr(label, " bytes");
+            if (bytes) {
+                while (bytes > label && bytes[-1] >= '0' && bytes[-1] <= '9') bytes--;
+                functions[i].frame = atol(bytes);
+            }
+        } else if (strncmp(line, "edge:", 5) == 0) {
+            int caller;
+            int target;
+
+            if (!quoted_field(line, "sourcename: \"", title, sizeof(title))) continue;
+            if (!quoted_field(line, "targetname: \"", callee, sizeof(callee))) continue;
+            caller = add_function(title);
+            target = add_function(callee);
+            if (caller < 0 || target < 0 || call_count >= MAX_CALLS) break;
+            calls[call_count].caller = caller;
+            calls[call_count].callee = target;
+            call_count++;
+        }
+    }
+    fclose(graph);
+    if (function_count >= MAX_FUNCTIONS || call_count >= MAX_CALLS) {
+        fprintf(stderr, "stackreport: call graph too large\n");
+        return 0;
+    }
+    return 1;
+}
+
+/* Fills in worst and next for the function and everything it calls */
+static void measure(int f) {
+    Function *function = &functions[f];
+    int i;
+
+    function->state = 1;
+    for (i = 0; i < call_count; i++) {
+        int callee = calls[i].callee;
+
+        if (calls[i].caller != f) continue;
+        if (functions[callee].state == 1) {
+            printf("Recursion: %s calls %s, which is already on the path\n", short_name(function), short_name(&functions[callee]));
+            recursion_found = 1;
+            continue;
+        }
+        if (functions[callee].state == 0) measure(callee);
+        if (functions[callee].worst > function->worst) {
+            function->worst = functions[callee].worst;
+            function->next = callee;
+        }
+    }
+    if (function->frame > 0) function->worst += function->frame;
+    function->state = 2;
+}
+
+static int compare_frames(const void *a, const void *b) {
+    long x = functions[*(const int *)a].frame;
+    long y = functions[*(const int *)b].frame;
+
+    return (y > x) - (y < x);
+}
+
+int main(int argc, char **argv) {
+    const char *root_name = DEFAULT_ROOT;
+    const char *graph_name = NULL;
+    long budget = DEFAULT_BUDGET;
+    int order[MAX_FUNCTIONS];
+    int root;
+    int f;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-budget") == 0 && i + 1 < argc) budget = atol(argv[++i]);
+        else if (strcmp(argv[i], "-root") == 0 && i + 1 < argc) root_name = argv[++i];
+        else if (argv[i][0] != '-' && !graph_name) graph_name = argv[i];
+        else {
+            graph_name = NULL;
+            break;
+        }
+    }
+    if (!graph_name) {
+        fprintf(stderr, "Usage: stackreport [-budget BYTES] [-root FUNCTION] FILE.ci\n");
+        return 1;
+    }
+    if (!read_graph(graph_name)) return 1;
+    root = find_function(root_name);
+    if (root < 0) {
+        fprintf(stderr, "stackreport: no function '%s' in '%s'\n", root_name, graph_name);
+        return 1;
+    }
+    measure(root);
+
+    printf("Deepest stack from %s: %ld bytes\n", root_name, functions[root].worst);
+    for (f = root; f >= 0; f = functions[f].next) {
+        printf("%8ld  %s\n", functions[f].frame, short_name(&functions[f]));
+    }
+
+    for (i = 0; i < function_count; i++) order[i] = i;
+    qsort(order, (size_t)function_count, sizeof(int), compare_frames);
+    printf("\nLargest frames:\n");
+    for (i = 0; i < function_count && i < LARGEST_SHOWN && functions[order[i]].frame > 0; i++) {
+        printf("%8ld  %s\n", functions[order[i]].frame, short_name(&functions[order[i]]));
+    }
+
+    if (recursion_found) {
+        printf("\nstack FAILED: recursion leaves the stack depth unbounded\n");
+        return 1;
+    }
+    if (functions[root].worst > budget) {
+        printf("\nstack FAILED: %ld bytes is over the %ld byte budget\n", functions[root].worst, budget);
+        return 1;
+    }
+    printf("\nstack passed: %ld bytes is within the %ld byte budget\n", functions[root].worst, budget);
+    return 0;
+}
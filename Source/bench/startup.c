@@ -0,0 +1,253 @@
+/*
+ * Codex - startup latency benchmark
+ *
+ * Runs a host build of Codex on one small file many times and reports the
+ * median time from fork() to the parent seeing it exit, split into phases
+ * by the marks Codex writes to stderr when CODEX_STARTUP_MARKS is set:
+ * exec and dynamic loading up to main(), argument parsing, table set-up,
+ * the first file open, linting, the report, the final flush and process
+ * exit.  With -target the run fails if the median total is over budget.
+ * This is a POSIX program (fork/exec, pipe, clock_gettime) and is built by
+ * VMakefile only.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define DEFAULT_CODEX "./codex"
+#define DEFAULT_RUNS 200
+#define MARKS_ENV "CODEX_STARTUP_MARKS" /* HOST_STARTUP_MARKS_ENV in host/amiga_host.h */
+#define MARK_PREFIX "startup "
+#define MAX_MARK_OUTPUT 1024
+#define NANOSECONDS_PER_SECOND 1e9
+#define MILLISECONDS_PER_SECOND 1e3
+#define MICROSECONDS_PER_SECOND 1e6
+#define CODEX_RETURN_ERROR 20
+
+/* Marks in the order Codex writes them; the run's start and end are taken here */
+static const char *mark_names[] = { "main", "args", "tables", "open", "lint", "output", "flush" };
+#define MARK_COUNT ((int)(sizeof(mark_names) / sizeof(mark_names[0])))
+
+/* Phase i runs from boundary i to boundary i + 1, where boundary 0 is the
+   fork(), boundaries 1..MARK_COUNT are the marks and the last is the exit */
+static const char *phase_names[] = {
+    "exec and dynamic loading",
+    "argument parsing",
+    "table set-up",
+    "first file open",
+    "linting",
+    "report",
+    "clean-up and flush",
+    "process exit"
+};
+#define PHASE_COUNT (MARK_COUNT + 1)
+
+static double now_seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static double median(double *values, int count) {
+    qsort(values, (size_t)count, sizeof(double), compare_doubles);
+    if (count % 2) return values[count / 2];
+    return (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+/* Fills boundaries[1..MARK_COUNT] from Codex's stderr; returns 0 if a mark is missing */
+static int parse_marks(char *output, double *boundaries) {
+    char *line;
+    int found = 0;
+    int i;
+
+    for (line = strtok(output, "\n"); line; line = strtok(NULL, "\n")) {
+        char name[32];
+        double when;
+
+        if (strncmp(line, MARK_PREFIX, strlen(MARK_PREFIX)) != 0) continue;
+        if (sscanf(line + strlen(MARK_PREFIX), "%31s %lf", name, &when) != 2) continue;
+        for (i = 0; i < MARK_COUNT; i++) {
+            if (strcmp(name, mark_names[i]) == 0) {
+                boundaries[i + 1] = when;
+                found |= 1 << i;
+            }
+        }
+    }
+    return found == (1 << MARK_COUNT) - 1;
+}
+
+/* Runs Codex once on the file; fills the PHASE_COUNT + 1 boundaries and returns its exit status, -1 on failure */
+static int run_codex(const char *codex, const char *file, double *boundaries) {
+    char output[MAX_MARK_OUTPUT];
+    char *argv[4];
+    size_t used = 0;
+    ssize_t got;
+    int marks[2];
+    int status;
+    pid_t pid;
+
+    argv[0] = (char *)codex;
+    argv[1] = (char *)file;
+    argv[2] = "QUIET";
+    argv[3] = NULL;
+    if (pipe(marks) < 0) return -1;
+
+    fflush(stdout);
+    boundaries[0] = now_seconds();
+    pid = fork();
+    if (pid < 0) {
+        close(marks[0]);
+        close(marks[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        int null_output = open("/dev/null", O_WRONLY);
+
+        if (null_output >= 0) dup2(null_output, STDOUT_FILENO);
+        dup2(marks[1], STDERR_FILENO);
+        close(marks[0]);
+        execv(codex, argv);
+        _exit(127);
+    }
+    close(marks[1]);
+    while ((got = read(marks[0], output + used, sizeof(output) - 1 - used)) > 0) {
+        used += (size_t)got;
+        if (used == sizeof(output) - 1) break;
+    }
+    close(marks[0]);
+    if (waitpid(pid, &status, 0) < 0) return -1;
+    boundaries[PHASE_COUNT] = now_seconds();
+    output[used] = '\0';
+
+    if (!WIFEXITED(status)) return -1;
+    if (!parse_marks(output, boundaries)) return -1;
+    return WEXITSTATUS(status);
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: startup [-codex PATH] [-runs N] [-target MS] FILE\n\n");
+    fprintf(stderr, "  -codex PATH  Codex host binary (default %s)\n", DEFAULT_CODEX);
+    fprintf(stderr, "  -runs N      Runs, the median of each phase is reported (default %d)\n", DEFAULT_RUNS);
+    fprintf(stderr, "  -target MS   Fail if the median exec-to-exit time is over MS milliseconds\n");
+}
+
+int main(int argc, char **argv) {
+    const char *codex = DEFAULT_CODEX;
+    const char *file = NULL;
+    int runs = DEFAULT_RUNS;
+    double target = 0.0;
+    double boundaries[PHASE_COUNT + 1];
+    double *phases;
+    double *totals;
+    double total;
+    int status;
+    int i;
+    int p;
+
+    for (i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            if (file) {
+                usage();
+                return 1;
+            }
+            file = argv[i];
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (strcmp(argv[i], "-codex") == 0) codex = argv[++i];
+        else if (strcmp(argv[i], "-runs") == 0) runs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-target") == 0) target = atof(argv[++i]);
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (!file || runs < 1) {
+        usage();
+        return 1;
+    }
+
+    phases = malloc((size_t)(runs * PHASE_COUNT) * sizeof(double));
+    totals = malloc((size_t)runs * sizeof(double));
+    if (!phases || !totals) {
+        fprintf(stderr, "startup: out of memory\n");
+        return 1;
+    }
+    if (setenv(MARKS_ENV, "1", 1) != 0) {
+        fprintf(stderr, "startup: cannot set %s\n", MARKS_ENV);
+        return 1;
+    }
+
+    for (i = 0; i < runs; i++) {
+        status = run_codex(codex, file, boundaries);
+        if (status < 0 || status >= CODEX_RETURN_ERROR) {
+            fprintf(stderr, "startup: %s failed on %s (status %d)\n", codex, file, status);
+            return 1;
+        }
+        for (p = 0; p < PHASE_COUNT; p++) phases[p * runs + i] = boundaries[p + 1] - boundaries[p];
+        totals[i] = boundaries[PHASE_COUNT] - boundaries[0];
+    }
+
+    printf("Startup latency of %s on %s, median of %d runs\n\n", codex, file, runs);
+    printf("%-26s %10s\n", "Phase", "us");
+    for (p = 0; p < PHASE_COUNT; p++) {
+        printf("%-26s %10.1f\n", phase_names[p], median(phases + p * runs, runs) * MICROSECONDS_PER_SECOND);
+    }
+    total = median(totals, runs);
+    /* The phase medians come from different runs, so they need not add up to this */
+    printf("%-26s %10.1f\n", "exec to exit", total * MICROSECONDS_PER_SECOND);
+
+    free(phases);
+    free(totals);
+    if (target > 0.0) {
+        if (total * MILLISECONDS_PER_SECOND > target) {
+            printf("\nstartup FAILED: %.3f ms is over the %.3f ms target\n", total * MILLISECONDS_PER_SECOND, target);
+            return 1;
+        }
+        printf("\nstartup passed: %.3f ms is within the %.3f ms target\n", total * MILLISECONDS_PER_SECOND, target);
+    }
+    return 0;
+}
@@ -0,0 +1,385 @@
+/*
+ * Codex - pathological input stress suite
+ *
+ * Includes a profiling build of codex.c and runs process_file() in every
+ * mode, with the FAST engine the command line uses, over generated
+ * adversarial inputs: a line of a megabyte, braces nested far past
+ * MAX_BLOCK_DEPTH, lines packed with "for (" tokens, unterminated comments
+ * and strings, and long runs of digits.  Every case is generated at two
+ * sizes and timed with the profiler off, since its clock reads cost the
+ * same on every line however short; the rules are then timed with it on.
+ * The suite fails when
+ *
+ *   - a case costs more than MAX_COST_FACTOR times normal code per byte,
+ *   - a case, or any single rule within it, grows by more than
+ *     MAX_GROWTH_FACTOR times the growth of its input (superlinear cost),
+ *   - line numbering or brace depth comes out wrong.
+ *
+ * Host build only (VMakefile: make -f VMakefile stress).
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#ifndef CODEX_PROFILE
+#error "bench/stress.c needs the profiling build (-DCODEX_PROFILE)"
+#endif
+
+#include "../codex.c"
+#undef main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define DEFAULT_SIZE 1048576L      /* Bytes of the large input of each case */
+#define DEFAULT_RUNS 3
+#define DEFAULT_TEMP "bench/stress.tmp"
+#define SIZE_STEP 4                /* The small input is DEFAULT_SIZE / SIZE_STEP */
+#define MAX_COST_FACTOR 4.0        /* Allowed time per byte relative to normal code */
+#define MAX_GROWTH_FACTOR 1.75     /* Allowed growth beyond linear between the sizes */
+#define MIN_RULE_SHARE 0.05        /* Rules below this share of a case are too noisy to judge */
+#define LINE_WIDTH 1000            /* Bytes per line of the packed cases */
+#define NANOSECONDS_PER_SECOND 1e9
+#define NANOSECONDS_PER_MILLISECOND 1e6
+#define NANOSECONDS_PER_MICROSECOND 1e3
+
+/* An adversarial input, written to a file of about the given size */
+typedef struct {
+    const char *name;
+    void (*generate)(FILE *file, long bytes);
+    int open_braces;   /* Brace depth expected at the end of the file */
+} StressCase;
+
+/* Outcome of one case at one size */
+typedef struct {
+    long bytes;
+    long lines;        /* Newlines written */
+    double ns;         /* Median time of process_file(), profiler off */
+    double rule_ns[RULE_COUNT]; /* Fastest time of each rule, profiler on */
+    int lines_ok;
+    int braces_ok;
+} StressRun;
+
+static const char *normal_block[] = {
+    "#include <exec/types.h>\n",
+    "/* Open the window and wait for the close gadget */\n",
+    "static LONG OpenMainWindow(struct Screen *screen, STRPTR title)\n",
+    "{\n",
+    "    struct Window *window = NULL;\n",
+    "    LONG result = RETURN_OK;\n",
+    "    char buffer[BUFFER_SIZE];\n",
+    "    if (!screen) return RETURN_FAIL;\n",
+    "    window = OpenWindowTags(NULL, WA_Title, title, WA_Width, 320, TAG_END);\n",
+    "    strncpy(buffer, title, sizeof(buffer) - 1);\n",
+    "    while (running) {\n",
+    "        Wait(1L << window->UserPort->mp_SigBit);\n",
+    "    }\n",
+    "    for (i = 0; i < MAX_ENTRIES; i++) total += table[i] * 3;\n",
+    "    sprintf(buffer, \"%ld items\", (LONG)count);\n",
+    "    CloseWindow(window);\n",
+    "    return result;\n",
+    "}\n"
+};
+
+static long written;
+static long newlines;
+
+static void emit(FILE *file, const char *text) {
+    fputs(text, file);
+    written += (long)strlen(text);
+    for (; *text; text++) {
+        if (*text == '\n') newlines++;
+    }
+}
+
+/* Repeats a fragment until the line is LINE_WIDTH bytes long */
+static void emit_packed_line(FILE *file, const char *prefix, const char *fragment, const char *suffix) {
+    long width = (long)strlen(prefix) + (long)strlen(suffix);
+
+    emit(file, prefix);
+    while (width + (long)strlen(fragment) < LINE_WIDTH) {
+        emit(file, fragment);
+        width += (long)strlen(fragment);
+    }
+    emit(file, suffix);
+}
+
+/* Whole blocks only, so the braces balance */
+static void generate_normal(FILE *file, long bytes) {
+    int i;
+
+    while (written < bytes) {
+        for (i = 0; i < (int)(sizeof(normal_block) / sizeof(normal_block[0])); i++) emit(file, normal_block[i]);
+    }
+}
+
+/* One line of the whole size; only its first MAX_LINE_LENGTH bytes are checked */
+static void generate_long_line(FILE *file, long bytes) {
+    while (written < bytes) emit(file, "x = x + 1; ");
+    emit(file, "\n");
+    emit(file, "int after_long_line;\n");
+}
+
+/* Nesting thousands of levels past MAX_BLOCK_DEPTH, then closing all but
+   one; the depth must come back to one, not reach zero early */
+static void generate_deep_braces(FILE *file, long bytes) {
+    long depth = bytes / 4;
+    long i;
+
+    emit(file, "void Deep(void)\n");
+    for (i = 0; i < depth; i++) emit(file, "{\n");
+    for (i = 1; i < depth; i++) emit(file, "}\n");
+}
+
+static void generate_for_tokens(FILE *file, long bytes) {
+    while (written < bytes) emit_packed_line(file, "", "for (", "\n");
+}
+
+/* The comment never ends, so everything after it is comment text */
+static void generate_unterminated_comment(FILE *file, long bytes) {
+    emit(file, "/* this comment is never closed\n");
+    generate_normal(file, bytes);
+}
+
+static void generate_unterminated_strings(FILE *file, long bytes) {
+    while (written < bytes) emit_packed_line(file, "    s = \"", "unterminated string text ", "\n");
+}
+
+static void generate_digits(FILE *file, long bytes) {
+    while (written < bytes) emit_packed_line(file, "    x = ", "1234567890", ";\n");
+}
+
+static const StressCase cases[] = {
+    { "normal", generate_normal, 0 },
+    { "long-line", generate_long_line, 0 },
+    { "deep-braces", generate_deep_braces, 1 },
+    { "for-tokens", generate_for_tokens, 0 },
+    { "unterminated-comment", generate_unterminated_comment, 0 },
+    { "unterminated-string", generate_unterminated_strings, 0 },
+    { "digits", generate_digits, 0 }
+};
+
+static const char *temp_name = DEFAULT_TEMP;
+static int runs = DEFAULT_RUNS;
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * NANOSECONDS_PER_SECOND + (double)ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* All modes on, as "C89 C99 AMIGA NDK SASC VBCC DICE MEMSAFE" resolves in main() */
+static void set_all_modes(void) {
+    validate_amiga_standards = 1;
+    validate_ndk_standards = 1;
+    validate_c89_standards = 1;
+    validate_c99_standards = 1;
+    validate_sasc_standards = 1;
+    validate_vbcc_standards = 1;
+    validate_dice_standards = 1;
+    validate_memsafe_standards = 1;
+    enforce_amiga_pascalcase = 1;
+    enforce_compiler_compatibility = 1;
+}
+
+/* Generates one case at one size and times process_file() on it */
+static int run_case(const StressCase *stress, long bytes, StressRun *run) {
+    double *times = malloc((size_t)runs * sizeof(double));
+    FILE *file = fopen(temp_name, "w");
+    int saved_stdout;
+    int null_fd;
+    int i;
+    int r;
+
+    if (!times || !file) {
+        fprintf(stderr, "stress: cannot create '%s'\n", temp_name);
+        free(times);
+        if (file) fclose(file);
+        return 0;
+    }
+    written = 0;
+    newlines = 0;
+    stress->generate(file, bytes);
+    fclose(file);
+    run->bytes = written;
+    run->lines = newlines;
+    for (i = 0; i < RULE_COUNT; i++) run->rule_ns[i] = 0.0;
+
+    /* process_file() announces every file; keep that out of the report */
+    fflush(stdout);
+    saved_stdout = dup(STDOUT_FILENO);
+    null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) dup2(null_fd, STDOUT_FILENO);
+
+    profile_enabled = 0;
+    for (r = 0; r < runs; r++) {
+        double start;
+
+        error_count = 0;
+        total_lines = 0;
+        start = now_ns();
+        process_file(temp_name);
+        times[r] = now_ns() - start;
+    }
+    run->lines_ok = total_lines == run->lines;
+    run->braces_ok = parse_state.brace_depth == stress->open_braces && parse_state.brace_overflow == 0;
+
+    profile_enabled = 1;
+    for (r = 0; r < runs; r++) {
+        memset(profile_counters, 0, sizeof(profile_counters));
+        error_count = 0;
+        process_file(temp_name);
+        for (i = 0; i < RULE_COUNT; i++) {
+            double rule_ns = (double)eclock_to_us(profile_estimated_ticks(&profile_counters[i])) *
+                             NANOSECONDS_PER_MICROSECOND;
+
+            if (r == 0 || rule_ns < run->rule_ns[i]) run->rule_ns[i] = rule_ns;
+        }
+    }
+
+    fflush(stdout);
+    if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+    if (null_fd >= 0) close(null_fd);
+
+    qsort(times, (size_t)runs, sizeof(double), compare_doubles);
+    run->ns = times[runs / 2];
+    free(times);
+    remove(temp_name);
+    return 1;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: stress [-size BYTES] [-runs N] [-tmp FILE]\n\n");
+    fprintf(stderr, "  -size BYTES  Size of the large input of each case (default %ld)\n", DEFAULT_SIZE);
+    fprintf(stderr, "  -runs N      Runs per input, the median is used (default %d)\n", DEFAULT_RUNS);
+    fprintf(stderr, "  -tmp FILE    Scratch file for the generated inputs (default %s)\n", DEFAULT_TEMP);
+}
+
+int main(int argc, char **argv) {
+    int case_count = (int)(sizeof(cases) / sizeof(cases[0]));
+    long size = DEFAULT_SIZE;
+    double normal_ns_per_byte = 0.0;
+    int failures = 0;
+    int c;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (strcmp(argv[i], "-size") == 0) size = atol(argv[++i]);
+        else if (strcmp(argv[i], "-runs") == 0) runs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-tmp") == 0) temp_name = argv[++i];
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (size < SIZE_STEP * LINE_WIDTH || runs < 1) {
+        usage();
+        return 1;
+    }
+    if (!eclock_open()) {
+        fprintf(stderr, "stress: cannot open %s\n", TIMERNAME);
+        return 1;
+    }
+    if (!engine_open()) {
+        fprintf(stderr, "stress: not enough memory for the FAST engine\n");
+        eclock_close();
+        return 1;
+    }
+    quiet_mode = 1;
+    set_all_modes();
+
+    printf("%-22s %10s %10s %9s %8s %8s  %s\n", "Case", "bytes", "ms", "ns/byte", "vs norm", "growth", "Status");
+    for (c = 0; c < case_count; c++) {
+        StressRun small;
+        StressRun large;
+        double ns_per_byte;
+        double cost;
+        double growth;
+        double input_growth;
+        const char *status = "ok";
+
+        if (!run_case(&cases[c], size / SIZE_STEP, &small) || !run_case(&cases[c], size, &large)) {
+            engine_close();
+            eclock_close();
+            return 1;
+        }
+        ns_per_byte = large.ns / (double)large.bytes;
+        if (c == 0) normal_ns_per_byte = ns_per_byte;
+        cost = ns_per_byte / normal_ns_per_byte;
+        input_growth = (double)large.bytes / (double)small.bytes;
+        growth = small.ns > 0 ? large.ns / small.ns : 0.0;
+
+        if (!small.lines_ok || !large.lines_ok) status = "LINE COUNT WRONG";
+        else if (!small.braces_ok || !large.braces_ok) status = "BRACE DEPTH WRONG";
+        else if (cost > MAX_COST_FACTOR) status = "TOO SLOW";
+        else if (growth > input_growth * MAX_GROWTH_FACTOR) status = "SUPERLINEAR";
+        if (strcmp(status, "ok") != 0) failures++;
+
+        printf("%-22s %10ld %10.2f %9.2f %7.2fx %7.2fx  %s\n", cases[c].name, large.bytes,
+               large.ns / NANOSECONDS_PER_MILLISECOND, ns_per_byte,
+               cost, growth, status);
+
+        /* Name the rules whose own cost grows faster than the input */
+        for (i = 0; i < RULE_COUNT; i++) {
+            double rule_growth;
+
+            if (large.rule_ns[i] < MIN_RULE_SHARE * large.ns || small.rule_ns[i] <= 0) continue;
+            rule_growth = large.rule_ns[i] / small.rule_ns[i];
+            if (rule_growth > input_growth * MAX_GROWTH_FACTOR) {
+                printf("    rule %s grows %.2fx for %.2fx more input\n", rule_names[i], rule_growth, input_growth);
+                failures++;
+            }
+        }
+    }
+    engine_close();
+    eclock_close();
+
+    if (failures > 0) {
+        printf("\nstress FAILED: %d problem%s\n", failures, failures == 1 ? "" : "s");
+        return 1;
+    }
+    printf("\nstress passed: every case within %.1fx of normal code and linear in size\n", MAX_COST_FACTOR);
+    return 0;
+}
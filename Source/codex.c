@@ -38,6 +38,9 @@
 #include <proto/exec.h>
 #include <proto/utility.h>
 #include <clib/alib_protos.h>
+#include <exec/memory.h>
+#include <devices/timer.h>
+#include <proto/timer.h>
 
 #include <string.h>
 #include <stdlib.h>
@@ -51,7 +54,11 @@ LONG oslibversion  = 47L;
 #define MAX_LINE_LENGTH 1024
 #define MAX_FILENAME_LENGTH 256
 #define MAX_ERRORS 1000
+#define ERRORS_INITIAL_CAPACITY 16 /* Issues room is made for first, doubled up to MAX_ERRORS */
+#define LOWMEM_ERROR_RING 8 /* Issues held under LOWMEM/S before they are printed */
 #define MAX_BLOCK_DEPTH 32 /* Max nesting depth for { } */
+#define MAX_KEYWORD_LENGTH 32 /* Longer words are never keywords */
+#define FOR_INIT_DELIMITERS " \t\n\r*();," /* Separate words in a for loop initializer */
 
 /* String parsing constants */
 #define COMMENT_START_LENGTH 2
@@ -67,9 +74,56 @@ LONG oslibversion  = 47L;
 /* Line excerpt constants */
 #define LINE_EXCERPT_LIMIT 120
 
+/* Lookup engine constants */
+#define FIRST_CHAR_SLOTS 257       /* One bucket per character, plus the end */
+
 /* Buffer size constants */
 #define REPLACEMENT_BUFFER_SIZE 64
+#define MESSAGE_BUFFER_SIZE 256
 #define LARGE_MESSAGE_BUFFER_SIZE 512
+#define NUMBER_TEXT_LENGTH 12 /* Digits of a LONG, its sign and the end */
+#define DECIMAL_BASE 10
+
+/* Profiling constants (CODEX_PROFILE builds only) */
+#define PROFILE_SAMPLE_INTERVAL 1 /* Time every Nth call of a rule; raise on slow machines */
+#define PERCENT_SCALE 100
+#define MICROSECONDS_PER_MILLISECOND 1000
+#define MICROSECONDS_PER_SECOND 1000000UL
+#define TRACE_MAX_EVENTS 8192      /* Trace buffer capacity, 16 bytes per event */
+#define TRACE_DEFAULT_SAMPLE 64    /* Trace every Nth line in detail by default */
+#define PATSTATS_MAX_PENDING 8     /* Matches remembered per rule invocation for attribution */
+#define COUNTER_SCALE 1000         /* Kcycles, Kinstr and misses per 1000 instructions */
+#define COUNTER_HUNDREDTHS 100     /* Ratios are printed with two decimals */
+
+/* Loop scope constants, for the rules about calls made on every pass of a loop */
+#define MAX_LOOP_DEPTH 8           /* Loops nested deeper are not tracked */
+#define LOOP_VARIABLES 4           /* Names each loop is known to change */
+#define LOOP_VARIABLE_LENGTH 32    /* Longer names are cut short */
+#define LOOP_COUNTER_NAMES 4       /* Names each loop is known to compare, step or set */
+#define LOOP_PENDING_CALLS 8       /* Setup calls waiting for their loops to end; more are reported at once */
+#define LOOP_ARGUMENTS_LENGTH 64   /* Argument text kept for a waiting call; longer lists are taken to change */
+#define UNBUFFERED_IO_LIMIT 16     /* Read() or Write() of this many bytes or fewer is a handful */
+#define IO_LENGTH_ARGUMENT 2       /* Read(file, buffer, length) counts arguments from 0 */
+
+/* Chip RAM constants, for the rule about MEMF_CHIP memory only the CPU uses */
+#define MAX_CHIP_ALLOCATIONS 8     /* MEMF_CHIP allocations followed in one function */
+#define MAX_FUNCTION_LOCALS 32     /* Locals known in one function; chip RAM put in later ones is not reported */
+#define ALLOCATION_FROM_POOL (-1)  /* AllocPooled() takes its requirements from the pool */
+
+/* STACKCHECK/S constants; frames are estimated for a 68k with stacked arguments */
+#define STACK_HASH_SIZE 256        /* Buckets for the project's functions, types and #defines */
+#define STACK_NAME_LENGTH 64       /* Longer names are cut short */
+#define STACK_SLOT_SIZE 4          /* A pointer, a LONG or a stacked argument */
+#define STACK_ALIGN 2              /* Words and longs sit on even addresses */
+#define STACK_CALL_OVERHEAD 20     /* Return address, frame pointer and three saved registers */
+#define STACK_DEFAULT_CLI 4096     /* What the CLI gives a program without a $STACK cookie */
+#define STACK_CHAINS_SHOWN 5       /* Heaviest call chains in the report */
+#define STACK_COOKIE "$STACK:"
+
+/* METRICS/K constants */
+#define METRICS_NAME_MAX 256       /* Longest METRICS file name, with room for the suffix */
+#define METRICS_TEMP_SUFFIX ".tmp" /* Written first, then renamed; the textfile collector skips it */
+#define METRICS_RATIO_SCALE 10000  /* Ratios are written with four decimals */
 
 /* Amiga return codes - use different names to avoid conflicts */
 #define CODEX_RETURN_OK 0
@@ -85,7 +139,8 @@ typedef enum {
     ERROR_STYLE,
     ERROR_WARNING,
     ERROR_COMPILER,
-    ERROR_COMMENT
+    ERROR_COMMENT,
+    ERROR_TYPE_COUNT
 } ErrorType;
 
 /* Error structure */
@@ -98,30 +153,339 @@ typedef struct {
     char line_excerpt[128];
 } LintError;
 
+/* Where a tracked loop is in the source */
+typedef enum {
+    LOOP_HEADER,    /* Inside the ( ) after for or while */
+    LOOP_PENDING,   /* Header read, body not started */
+    LOOP_STATEMENT, /* Body is a single statement */
+    LOOP_BLOCK,     /* Body is a { } block */
+    LOOP_TAIL       /* Body of a do loop read, its while ( ) to come */
+} LoopPhase;
+
+/* A do loop's while ( ) is its header, read after the body */
+typedef enum {
+    LOOP_FOR,
+    LOOP_WHILE,
+    LOOP_DO
+} LoopKind;
+
+/* How a loop polls, for the busy-wait rule */
+typedef enum {
+    POLL_NONE,
+    POLL_BODY,      /* In the body, or in a loop inside it */
+    POLL_CONDITION, /* The condition waits for the poll to succeed */
+    POLL_DRAIN      /* The condition runs until GetMsg() has emptied the port */
+} PollKind;
+
+/* One for, while or do loop around the current position */
+typedef struct {
+    int line;             /* Line of the loop keyword */
+    int brace_depth;      /* Braces open where the body starts */
+    UBYTE kind;           /* LoopKind */
+    UBYTE phase;          /* LoopPhase */
+    UBYTE header_parens;  /* Parentheses open in the header */
+    UBYTE header_part;    /* Clauses of a for header already read */
+    UBYTE variable_count;
+    UBYTE variables_lost; /* The loop changes more names than it can hold */
+    UBYTE compares;       /* The condition compares with < or > */
+    UBYTE compared_count;
+    UBYTE stepped_count;
+    UBYTE set_count;
+    UBYTE counters_lost;  /* More names compared, stepped or set than are kept */
+    UBYTE blocks;         /* Makes a call that waits, such as Wait() or Delay() */
+    UBYTE poll;           /* PollKind of the first poll */
+    int poll_line;
+    int poll_column;
+    char variables[LOOP_VARIABLES][LOOP_VARIABLE_LENGTH]; /* Names that change from pass to pass */
+    char compared[LOOP_COUNTER_NAMES][LOOP_VARIABLE_LENGTH]; /* Named in the condition */
+    char stepped[LOOP_COUNTER_NAMES][LOOP_VARIABLE_LENGTH];  /* Changed with ++, --, += or -= */
+    char set[LOOP_COUNTER_NAMES][LOOP_VARIABLE_LENGTH];      /* Given a value with = or another op= */
+    char poll_name[LOOP_VARIABLE_LENGTH]; /* What the first poll calls or reads */
+    char poll_excerpt[LINE_EXCERPT_LIMIT + 2]; /* Its line, one more than is shown */
+} LoopScope;
+
+/* A setup call in a loop, reported when the loop ends and all it changes is known */
+typedef struct {
+    int line;
+    int column;
+    int loop;     /* Entry in ParseState.loops */
+    UBYTE varies; /* The arguments were too long to keep */
+    char name[LOOP_VARIABLE_LENGTH];
+    char arguments[LOOP_ARGUMENTS_LENGTH];     /* From after the '(' to its ')' */
+    char excerpt[LINE_EXCERPT_LIMIT + 2];      /* One more than is shown, to tell a cut line */
+} LoopCall;
+
+/* A MEMF_CHIP allocation held in a local of the current function */
+typedef struct {
+    int line;
+    int column;
+    UBYTE used;   /* Handed on, or given to a call that may need chip RAM */
+    UBYTE pool;   /* For AllocPooled(): 1 + the entry of its pool, or 0 */
+    UBYTE report; /* AllocPooled() memory is reported through its pool */
+    char name[LOOP_VARIABLE_LENGTH];     /* The local holding it */
+    char function[LOOP_VARIABLE_LENGTH]; /* The call that made it */
+    char excerpt[LINE_EXCERPT_LIMIT + 2]; /* Its line, one more than is shown */
+} ChipAllocation;
+
 /* State tracking structure */
 typedef struct {
     int in_multiline_comment;
+    char skim_quote;    /* In an overlong line's unchecked rest: '"' or '\'' inside a literal, '/' in a "//" comment */
+    char skim_previous; /* ... and a '\\', '/' or '*' that may pair with the next character */
     int brace_depth;
+    int brace_overflow; /* Open braces nested deeper than MAX_BLOCK_DEPTH */
     UBYTE statement_seen[MAX_BLOCK_DEPTH]; /* Flag for each brace depth */
     int forbid_active; /* Track if we're inside a Forbid() block */
     int forbid_line; /* Line number where Forbid() was called */
     int permit_line; /* Line number where Permit() was called */
     int forbid_count; /* Count of Forbid() calls */
     int permit_count; /* Count of Permit() calls */
+    LoopScope loops[MAX_LOOP_DEPTH]; /* Loops around the current position, innermost last */
+    int loop_count;
+    int loop_braces; /* Braces open, counted on every line for the loop scopes */
+    int loop_in_directive; /* Continuation of a preprocessor line */
+    const char *loop_filename; /* For issues found when a loop ends */
+    LoopCall loop_calls[LOOP_PENDING_CALLS]; /* Oldest first */
+    int loop_call_count;
+    ChipAllocation chip[MAX_CHIP_ALLOCATIONS]; /* Chip RAM taken in the current function */
+    int chip_count;
+    char locals[MAX_FUNCTION_LOCALS][LOOP_VARIABLE_LENGTH]; /* Declared in the current function */
+    int local_count;
 } ParseState;
 
+/* Scratch space for the line being checked, kept off the stack so that the
+   whole lint path fits the $STACK cookie.  lex_line() fills original and
+   clean; the check_* functions take turns with words (cut up by strtok())
+   and message, so no check may call another */
+typedef struct {
+    char original[MAX_LINE_LENGTH];
+    char clean[MAX_LINE_LENGTH];
+    char words[MAX_LINE_LENGTH];
+    char message[LARGE_MESSAGE_BUFFER_SIZE];
+} LineContext;
+
+/* Validation mode switches as given on the command line, in template order */
+typedef struct {
+    LONG amiga;
+    LONG ndk;
+    LONG c89;
+    LONG c99;
+    LONG sasc;
+    LONG vbcc;
+    LONG dice;
+    LONG memsafe;
+} ModeSwitches;
+
+/* Rules and stages invoked for every line, used to attribute cost */
+typedef enum {
+    RULE_LEXER,
+    RULE_CODEX_COMMENT,
+    RULE_C89,
+    RULE_C99,
+    RULE_AMIGA,
+    RULE_NDK,
+    RULE_SASC,
+    RULE_VBCC,
+    RULE_DICE,
+    RULE_MEMSAFE,
+    RULE_MAGIC_NUMBERS,
+    RULE_FORBID_PERMIT,
+    RULE_C89_DECLARATIONS,
+    RULE_LINE_LENGTH,
+    RULE_BLOCK_STATE,
+    RULE_STACK,
+    RULE_LOOPS,
+    RULE_COUNT
+} RuleId;
+
+/* Owners of heap blocks, for MEMSTATS/S */
+typedef enum {
+    MEM_INPUT,
+    MEM_TOKENS,
+    MEM_DIAGNOSTICS,
+    MEM_STATE,
+    MEM_CACHES,
+    MEM_INSTRUMENTATION,
+    MEM_SUBSYSTEM_COUNT
+} MemSubsystem;
+
+/* Heap use of one subsystem */
+typedef struct {
+    ULONG allocations;
+    ULONG frees;
+    ULONG bytes;       /* Currently allocated */
+    ULONG peak_bytes;
+    ULONG total_bytes; /* Allocated over the whole run */
+} MemCounter;
+
+/* Precedes every block from mem_alloc(); 8 bytes keeps the caller's block aligned */
+typedef struct {
+    ULONG size;
+    ULONG subsystem;
+} MemBlockHeader;
+
+/* Scratch memory that is handed out by bumping a pointer and given back all
+   at once; the chunks come from an exec memory pool and are kept on reset.
+   Each new chunk is twice the size of the last, so a file that needs more
+   than the ones before it costs a few allocations and later files none */
+#define ARENA_CHUNK_SIZE 4096 /* The first chunk */
+#define ARENA_PUDDLE_SIZE 16384 /* Pool puddles hold a few chunks; bigger requests get their own */
+#define ARENA_ALIGN 8
+#define ARENA_ROUND(size) (((size) + ARENA_ALIGN - 1) & ~(ULONG)(ARENA_ALIGN - 1))
+#define ARENA_HEADER_SIZE ARENA_ROUND(sizeof(ArenaChunk))
+
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    ULONG size; /* Usable bytes after the header */
+} ArenaChunk;
+
+typedef struct {
+    APTR pool;            /* Created on the first allocation */
+    ArenaChunk *chunks;   /* Oldest first */
+    ArenaChunk *last;
+    ArenaChunk *current;  /* Chunk being handed out, NULL if none has room */
+    ULONG used;           /* Bytes handed out from current */
+    MemSubsystem subsystem;
+} Arena;
+
+/* STACKCHECK/S: what a name in the linted project stands for */
+typedef enum {
+    SYMBOL_FUNCTION,
+    SYMBOL_TYPE,   /* typedef name */
+    SYMBOL_TAG,    /* struct or union tag */
+    SYMBOL_DEFINE  /* #define with a constant value */
+} SymbolKind;
+
+#define SYMBOL_DEFINED 1       /* Function body, type or value seen */
+#define SYMBOL_CALLED 2        /* Called by some function */
+#define SYMBOL_SIZE_UNKNOWN 4  /* Frame or type holds something of unknown size */
+#define SYMBOL_DEPTH_UNKNOWN 8 /* Worst case reaches a frame of unknown size */
+
+/* Where stack_search() is with a function */
+typedef enum {
+    SEARCH_NEW,
+    SEARCH_ACTIVE, /* On the path being searched */
+    SEARCH_DONE
+} SearchState;
+
+/* A call from one function to another, once per pair */
+typedef struct StackCall {
+    struct StackSymbol *callee;
+    struct StackCall *next;
+    const char *filename;
+    int line;
+} StackCall;
+
+/* A function, type or #define of the project; the name follows the record */
+typedef struct StackSymbol {
+    struct StackSymbol *next; /* In its hash bucket */
+    const char *name;
+    UBYTE kind;
+    UBYTE flags;
+    UBYTE state;
+    LONG value;               /* Frame, type size or #define value in bytes */
+    LONG depth;               /* Worst case from here, once searched */
+    const char *filename;
+    int line;
+    StackCall *calls;         /* Latest first */
+    StackCall *next_call;     /* Next call stack_search() looks at */
+    struct StackSymbol *heaviest; /* Callee on the worst path */
+} StackSymbol;
+
+/* What the outermost open brace of a file belongs to */
+typedef enum {
+    BLOCK_NONE,
+    BLOCK_FUNCTION,
+    BLOCK_RECORD, /* struct or union body */
+    BLOCK_ENUM,
+    BLOCK_OTHER   /* Initializer */
+} BlockKind;
+
+/* A statement at file scope, as far as it has been read */
+typedef struct {
+    char name[STACK_NAME_LENGTH];     /* Last word before the first '(' */
+    char tag[STACK_NAME_LENGTH];      /* Word after struct or union */
+    char last_word[STACK_NAME_LENGTH];
+    int name_line;
+    int paren_depth;
+    int params_done;   /* The first parameter list has closed */
+    int param_commas;
+    int param_seen;    /* The parameter list is more than "void" */
+    int assigned;      /* '=' seen, so '{' opens an initializer */
+    int aggregate;     /* struct or union seen */
+    int enumeration;   /* enum seen */
+    int tag_next;
+    int typedef_seen;
+    int record_closed; /* The struct or union body has been read */
+} StackStatement;
+
+/* Reading one file for the call graph */
+typedef struct {
+    const char *filename;  /* Interned on first use */
+    int depth;             /* Braces open */
+    BlockKind block;       /* What the outermost open brace belongs to */
+    int in_directive;      /* Continuation line of a preprocessor directive */
+    StackSymbol *function; /* Body being read */
+    LONG frame;
+    int frame_unknown;
+    LONG record_size;      /* struct or union being read */
+    int record_unknown;
+    LONG enum_next;        /* Value of the next enum constant, -1 if unknown */
+    StackStatement statement;
+    char word[STACK_NAME_LENGTH];   /* Word being looked at */
+    char lookup[STACK_NAME_LENGTH]; /* #define looked up by stack_evaluate() */
+} StackScan;
+
+/* Size of a type name */
+typedef struct {
+    const char *name;
+    UWORD size;
+} TypeSize;
+
 /* Global state */
-static LintError errors[MAX_ERRORS];
+static LintError *errors = NULL; /* Grown on demand by errors_reserve(), never shrunk */
+static int error_capacity = 0;
+static int errors_out_of_memory = 0; /* Set once an issue could not be stored */
 static int error_count = 0;
+static ULONG errors_streamed = 0; /* Issues already printed under LOWMEM/S */
 static int total_lines = 0;
 static int total_files = 0;
 static ParseState parse_state;
+static Arena file_arena = { NULL, NULL, NULL, NULL, 0, MEM_STATE }; /* Reset after every file */
+static LineContext line_context;
+
+/* Call graph for STACKCHECK/S, kept for the whole run */
+static int stackcheck_enabled = 0;
+static Arena stack_arena = { NULL, NULL, NULL, NULL, 0, MEM_STATE };
+static StackSymbol **stack_buckets = NULL; /* Set by stack_open() */
+static StackScan stack_scan;
+static StackSymbol *stack_root = NULL;     /* main(), or the deepest entry point */
+static int stack_from_main = 0;
+static int stack_out_of_memory = 0;
+static LONG stack_limit = 0;               /* From the first $STACK cookie */
+static const char *stack_cookie_file = NULL;
+static int stack_cookie_line = 0;
+static int stack_functions = 0;
+static int stack_recursive_calls = 0;
+
+/* Memory accounting; counted always, system free memory only with MEMSTATS/S */
+static const char *mem_subsystem_names[MEM_SUBSYSTEM_COUNT] = {
+    "input", "tokens", "diagnostics", "state", "caches", "instrumentation"
+};
+static MemCounter mem_counters[MEM_SUBSYSTEM_COUNT];
+static ULONG mem_heap_bytes = 0;
+static ULONG mem_heap_peak = 0;
+static ULONG mem_blocks_allocated = 0; /* By every subsystem; the steady-state checks watch it */
+static int memstats_enabled = 0;
+static ULONG mem_free_at_start = 0;
+static ULONG mem_free_lowest = 0;
 
 /* Configuration flags */
 static int enforce_amiga_pascalcase = 1;
 static int enforce_compiler_compatibility = 1;
 static int line_length_limit = 256;
 static int quiet_mode = 0;
+static int lowmem_mode = 0; /* LOWMEM/S: print issues as files finish and keep no buffers between files */
 
 /* Validation mode flags */
 static int validate_amiga_standards = 0;
@@ -133,6 +497,149 @@ static int validate_vbcc_standards = 0;
 static int validate_dice_standards = 0;
 static int validate_memsafe_standards = 0;
 
+static const char *rule_names[RULE_COUNT] = {
+    "(lexer)", "$CODEX comment", "c89", "c99", "amiga", "ndk", "sasc", "vbcc",
+    "dice", "memsafe", "magic numbers", "forbid/permit", "c89 declarations",
+    "line length", "(block state)", "stack depth", "loop calls"
+};
+
+static const char *error_type_names[ERROR_TYPE_COUNT] = {
+    "SYNTAX", "STYLE", "WARNING", "COMPILER", "COMMENT"
+};
+
+/* Rule whose diagnostics are being added, for METRICS/K */
+static RuleId current_rule = RULE_LEXER;
+static ULONG rule_diagnostics[RULE_COUNT][ERROR_TYPE_COUNT];
+static ULONG total_bytes = 0;
+
+/* E-clock of timer.device, opened for PROFILE/S, TRACE/K, COUNTERS/S or METRICS/K */
+static struct timerequest eclock_request;
+static ULONG eclock_freq = 0;
+struct Device *TimerBase = NULL;
+
+#ifdef CODEX_PROFILE
+/* Hardware events sampled by COUNTERS/S, in the host's counter order */
+typedef enum {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_BRANCHES,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_L1D_MISSES,
+    COUNTER_LLC_MISSES,
+    COUNTER_COUNT
+} CounterId;
+
+/* Per-rule counters for PROFILE/S */
+typedef struct {
+    ULONG calls;       /* Number of invocations */
+    ULONG hits;        /* Invocations that added at least one issue */
+    ULONG bytes;       /* Bytes of line text handed to the rule */
+    ULONG timed_calls; /* Invocations that were actually timed */
+    ULONG ticks;       /* E-clock ticks spent in the timed invocations */
+    double events[COUNTER_COUNT]; /* Hardware events in the timed invocations (COUNTERS/S) */
+} ProfileCounter;
+
+/* Start of the rule currently being measured (rules never nest) */
+typedef struct {
+    RuleId rule;
+    int timed;
+    ULONG issues;
+    ULONG start;
+    double events[COUNTER_COUNT];
+} ProfileMark;
+#endif
+
+/* Pipeline stages that COUNTERS/S and METRICS/K report on */
+typedef enum {
+    STAGE_READ,   /* Opening the file and reading lines */
+    STAGE_LINT,   /* process_line() */
+    STAGE_FINISH, /* End of file checks */
+    STAGE_OUTPUT, /* Summary and issue listing */
+    STAGE_COUNT
+} StageId;
+
+/* Time and hardware events charged to one stage */
+typedef struct {
+    ULONG ticks;
+#ifdef CODEX_PROFILE
+    double events[COUNTER_COUNT];
+#endif
+} StageCounter;
+
+static const char *stage_names[STAGE_COUNT] = { "read", "lint", "finish", "output" };
+static int stage_timing_enabled = 0;
+static StageCounter stage_counters[STAGE_COUNT];
+static ULONG stage_start_ticks = 0;
+
+/* Where one file's lines start in the running totals, for VERBOSE/S */
+typedef struct {
+    ULONG ticks[STAGE_COUNT];
+    ULONG bytes;
+    ULONG diagnostics;
+} FileTelemetry;
+
+static int verbose_enabled = 0;
+static int files_queued = 0;        /* Files named on the command line */
+static ULONG diagnostics_found = 0; /* Issues added, including any past MAX_ERRORS */
+static ULONG run_start_ticks = 0;
+static ULONG run_ticks = 0;         /* Whole run, set once the report is out */
+
+#ifdef CODEX_PROFILE
+static double stage_start_events[COUNTER_COUNT];
+
+/* Trace event categories for TRACE/K */
+typedef enum {
+    TRACE_FILE,
+    TRACE_STAGE,
+    TRACE_RULE
+} TraceCategory;
+
+/* One complete ("X") event of the Chrome trace-event format */
+typedef struct {
+    const char *name;
+    ULONG category;
+    ULONG start;    /* E-clock ticks since trace_origin */
+    ULONG duration; /* E-clock ticks */
+} TraceEvent;
+
+static int profile_enabled = 0;
+static ProfileCounter profile_counters[RULE_COUNT];
+static ProfileMark profile_mark;
+
+static int trace_enabled = 0;
+static int trace_line_sampled = 0;  /* Current line gets stage and rule spans */
+static ULONG trace_sample_interval = TRACE_DEFAULT_SAMPLE;
+static TraceEvent *trace_events = NULL;
+static ULONG trace_event_count = 0;
+static ULONG trace_dropped = 0;
+static ULONG trace_origin = 0;
+
+static int counters_enabled = 0;
+static int counter_available[COUNTER_COUNT];
+
+static int instrument_line = 0;     /* Profiling or tracing the current line */
+
+/* Wrap a rule or stage; the line length is only evaluated when profiling */
+#define PROFILE_BEGIN(rule) do { current_rule = (rule); if (instrument_line) profile_begin(rule); } while (0)
+#define PROFILE_END(bytes) do { if (instrument_line) profile_end((ULONG)(bytes)); } while (0)
+#define RUN_RULE(rule, bytes, call) do { PROFILE_BEGIN(rule); call; PROFILE_END(bytes); } while (0)
+#else
+#define PROFILE_BEGIN(rule) do { current_rule = (rule); } while (0)
+#define PROFILE_END(bytes) do { } while (0)
+#define RUN_RULE(rule, bytes, call) do { current_rule = (rule); call; } while (0)
+#endif
+
+/* Charge everything since the previous stage boundary to a stage */
+#define STAGE_START() do { if (stage_timing_enabled) stage_begin(); } while (0)
+#define STAGE_END(stage) do { if (stage_timing_enabled) stage_end(stage); } while (0)
+
+/* Startup phase boundaries for bench/startup.c; nothing on AmigaOS */
+#ifdef CODEX_HOST_BUILD
+#define STARTUP_MARK(phase) host_startup_mark(phase)
+#else
+#define STARTUP_MARK(phase) do { } while (0)
+#endif
+
 /* Compiler-specific keywords that need universal syntax - kept for future use */
 /* static const char *compiler_specific_keywords[] = {
     "__saveds", "__save_ds", "__asm", "__reg", "__stdargs", "__far", "__interrupt", "__amigainterrupt", "__chip", "__fast"
@@ -291,6 +798,75 @@ static const char *amiga_functions[] = {
     "DoIO", "OpenDevice", "CloseDevice", "ReadArgs", "Open", "Close", "Read", "Write" /* ... and others */
 };
 
+/* Exec, dos, intuition and graphics calls that set up or tear down a resource;
+   each is a costly round trip through the system, too slow for every pass of a loop */
+static const char *loop_setup_functions[] = {
+    /* exec.library */
+    "OpenLibrary", "OldOpenLibrary", "CloseLibrary", "OpenDevice", "CloseDevice", "OpenResource",
+    "CreateMsgPort", "DeleteMsgPort", "CreateIORequest", "DeleteIORequest", "CreatePool", "DeletePool",
+    /* dos.library */
+    "Lock", "UnLock", "DupLock", "Open", "OpenFromLock", "Close", "LoadSeg", "UnLoadSeg",
+    "AllocDosObject", "FreeDosObject",
+    /* intuition.library */
+    "OpenWindow", "OpenWindowTagList", "OpenWindowTags", "CloseWindow", "OpenScreen",
+    "OpenScreenTagList", "OpenScreenTags", "CloseScreen", "LockPubScreen", "UnlockPubScreen",
+    /* graphics.library and diskfont.library */
+    "OpenFont", "OpenDiskFont", "CloseFont"
+};
+
+/* Calls that ask whether something has happened without waiting for it */
+static const char *polling_functions[] = {
+    "GetMsg", "CheckIO", "SetSignal", "CheckSignal"
+};
+
+/* Calls that put the task to sleep until something happens */
+static const char *blocking_functions[] = {
+    "Wait", "WaitPort", "WaitIO", "DoIO", "Delay", "TimeDelay", "WaitTOF", "WaitBOVP",
+    "WaitForChar", "WaitSelect"
+};
+
+/* Globals of hardware/custom.h and hardware/cia.h; reading them in a loop polls the chips */
+static const char *hardware_registers[] = {
+    "custom", "ciaa", "ciab"
+};
+
+/* Fields of exec/ports.h and exec/lists.h; a while condition that waits for
+   them to show a node polls the list, as in !port->mp_MsgList.lh_Head->ln_Succ */
+static const char *message_list_fields[] = {
+    "mp_MsgList", "lh_Head", "lh_TailPred", "ln_Succ"
+};
+
+/* exec.library calls that allocate memory, with the argument (from 0) that
+   holds the requirements, such as MEMF_CHIP */
+static const char *memory_allocators[] = {
+    "AllocMem", "AllocVec", "AllocPooled", "CreatePool"
+};
+
+static const int memory_requirement_arguments[] = {
+    1, 1, ALLOCATION_FROM_POOL, 0
+};
+
+/* Calls that hand memory to the custom chips, which only reach chip RAM.  Audio
+   samples, copper lists and the CIA and custom chip registers take it through
+   a store, into an IOAudio request or a register, which counts already */
+static const char *chip_memory_functions[] = {
+    /* graphics.library: the blitter, sprites and the raster area fills draw through */
+    "BltBitMap", "BltBitMapRastPort", "BltMaskBitMapRastPort", "BltTemplate", "BltPattern", "BltClear",
+    "ChangeSprite", "InitTmpRas",
+    /* intuition.library: the mouse pointer is a sprite */
+    "SetPointer"
+};
+
+/* Unbuffered dos.library I/O: every call is a packet round trip to the handler */
+static const char *unbuffered_io_functions[] = {
+    "Read", "Write"
+};
+
+/* Buffered dos.library calls to use instead, in unbuffered_io_functions[] order */
+static const char *buffered_io_replacements[] = {
+    "FGetC() or FRead()", "FPutC() or FWrite()"
+};
+
 /* Memory-unsafe C standard library functions */
 static const char *memsafe_unsafe_functions[] = {
     /* Buffer overflow prone functions */
@@ -340,14 +916,172 @@ static const char *vbcc_keywords[] = {
     "__restrict__"       /* GCC-specific */
 };
 
+/* Sizes of C and Exec types as a 68k compiler lays them out, for STACKCHECK/S */
+static const TypeSize type_sizes[] = {
+    { "char", 1 }, { "short", 2 }, { "int", 4 }, { "long", 4 }, { "float", 4 }, { "double", 8 },
+    { "signed", 4 }, { "unsigned", 4 }, { "void", 0 }, { "size_t", 4 },
+    { "BYTE", 1 }, { "UBYTE", 1 }, { "TEXT", 1 }, { "BYTEBITS", 1 },
+    { "WORD", 2 }, { "UWORD", 2 }, { "SHORT", 2 }, { "USHORT", 2 }, { "BOOL", 2 },
+    { "COUNT", 2 }, { "UCOUNT", 2 }, { "WORDBITS", 2 }, { "RPTR", 2 },
+    { "LONG", 4 }, { "ULONG", 4 }, { "LONGBITS", 4 }, { "APTR", 4 }, { "CONST_APTR", 4 },
+    { "STRPTR", 4 }, { "CONST_STRPTR", 4 }, { "BPTR", 4 }, { "BSTR", 4 }, { "Tag", 4 },
+    { "IPTR", 4 }, { "FLOAT", 4 }, { "DOUBLE", 8 }
+};
+
+/* Sizes of NDK structures often put on the stack, for tags no linted file defines */
+static const TypeSize ndk_struct_sizes[] = {
+    { "Node", 14 }, { "MinNode", 8 }, { "List", 14 }, { "MinList", 12 },
+    { "Message", 20 }, { "MsgPort", 34 }, { "IORequest", 32 }, { "IOStdReq", 48 },
+    { "timeval", 8 }, { "timerequest", 40 }, { "EClockVal", 8 }, { "DateStamp", 12 },
+    { "FileInfoBlock", 260 }, { "InfoData", 36 }, { "TagItem", 8 },
+    { "SignalSemaphore", 46 }, { "RastPort", 100 }, { "TextAttr", 8 }
+};
+
+/* Pattern tables, in pattern_tables[] order */
+typedef enum {
+    PATTERNS_NDK_RESERVED,
+    PATTERNS_C99_KEYWORDS,
+    PATTERNS_C99_FEATURES,
+    PATTERNS_C99_DESIGNATED_INIT,
+    PATTERNS_C99_COMPOUND_LITERAL,
+    PATTERNS_C99_VARIADIC_MACRO,
+    PATTERNS_C99_FLEXIBLE_ARRAY,
+    PATTERNS_C99_STDLIB,
+    PATTERNS_C89_HEADERS,
+    PATTERNS_C99_HEADERS,
+    PATTERNS_STDLIB,
+    PATTERNS_AMIGA_FUNCTIONS,
+    PATTERNS_MEMSAFE_UNSAFE,
+    PATTERNS_SASC_KEYWORDS,
+    PATTERNS_VBCC_KEYWORDS,
+    PATTERNS_NON_UNIVERSAL,
+    PATTERNS_LOOP_SETUP,
+    PATTERNS_UNBUFFERED_IO,
+    PATTERNS_POLLING,
+    PATTERNS_BLOCKING,
+    PATTERNS_HARDWARE_REGISTERS,
+    PATTERNS_MESSAGE_LISTS,
+    PATTERNS_MEMORY_ALLOCATORS,
+    PATTERNS_CHIP_MEMORY,
+    PATTERN_TABLE_COUNT
+} PatternTableId;
+
+/* One pattern table and where its counters start */
+typedef struct {
+    const char *name;
+    const char **patterns;
+    int count;
+    int substring;  /* Looked up with strstr() rather than strcmp() */
+    int referenced; /* Consulted by a rule at all */
+    ULONG base;     /* Index of the first counter in pattern_counters */
+} PatternTable;
+
+/* Engines that run the table lookups, chosen with ENGINE/K */
+typedef enum {
+    ENGINE_LEGACY, /* Linear scan of every table entry */
+    ENGINE_FAST    /* First-character index over each table */
+} EngineId;
+
+/* FAST engine index over one table; a bucket keeps the table's order, so the
+   first hit is the same entry the linear scan would find */
+typedef struct {
+    UWORD *order;                  /* Entry numbers grouped by first character */
+    UWORD *lengths;                /* strlen() of each entry */
+    UWORD first[FIRST_CHAR_SLOTS]; /* order[first[c]..first[c+1]) start with c */
+    char starts[FIRST_CHAR_SLOTS]; /* Each first character once, for strpbrk() */
+} PatternIndex;
+
+#define PATTERN_TABLE(table, substring, referenced) \
+    { #table, table, sizeof(table) / sizeof(table[0]), substring, referenced, 0 }
+
+/* The compound literal and variadic macro checks use inline strstr() chains */
+static PatternTable pattern_tables[PATTERN_TABLE_COUNT] = {
+    PATTERN_TABLE(ndk_reserved_words, 0, 1),
+    PATTERN_TABLE(c99_keywords, 1, 1),
+    PATTERN_TABLE(c99_features, 1, 1),
+    PATTERN_TABLE(c99_designated_init_patterns, 1, 1),
+    PATTERN_TABLE(c99_compound_literal_patterns, 1, 0),
+    PATTERN_TABLE(c99_variadic_macro_patterns, 1, 0),
+    PATTERN_TABLE(c99_flexible_array_patterns, 1, 1),
+    PATTERN_TABLE(c99_stdlib_functions, 1, 1),
+    PATTERN_TABLE(c89_header_files, 1, 1),
+    PATTERN_TABLE(c99_header_files, 1, 1),
+    PATTERN_TABLE(stdlib_functions, 0, 1),
+    PATTERN_TABLE(amiga_functions, 0, 1),
+    PATTERN_TABLE(memsafe_unsafe_functions, 0, 1),
+    PATTERN_TABLE(sasc_keywords, 0, 1),
+    PATTERN_TABLE(vbcc_keywords, 0, 1),
+    PATTERN_TABLE(non_universal_keywords, 0, 1),
+    PATTERN_TABLE(loop_setup_functions, 0, 1),
+    PATTERN_TABLE(unbuffered_io_functions, 0, 1),
+    PATTERN_TABLE(polling_functions, 0, 1),
+    PATTERN_TABLE(blocking_functions, 0, 1),
+    PATTERN_TABLE(hardware_registers, 0, 1),
+    PATTERN_TABLE(message_list_fields, 0, 1),
+    PATTERN_TABLE(memory_allocators, 0, 1),
+    PATTERN_TABLE(chip_memory_functions, 0, 1)
+};
+
+static int fast_engine = 0; /* Set once pattern_indexes has been built */
+static PatternIndex *pattern_indexes = NULL;
+static ULONG index_probes = 0;      /* First-character buckets looked at */
+static ULONG index_bucket_scans = 0; /* Probes that had entries to compare */
+
+#ifdef CODEX_PROFILE
+/* Counters for one pattern */
+typedef struct {
+    ULONG tested;    /* Times the pattern was compared against the input */
+    ULONG matched;   /* Times the comparison succeeded */
+    ULONG diagnosed; /* Matches that were followed by an issue from the same rule */
+} PatternCounter;
+
+static int patstats_enabled = 0;
+static PatternCounter *pattern_counters = NULL;
+static ULONG pattern_pending[PATSTATS_MAX_PENDING]; /* Matches not yet followed by an issue */
+static int pattern_pending_count = 0;
+
+/* Count one comparison or match; cheap enough to leave in every lookup loop */
+#define PATTERN_TESTED(table, index) \
+    do { if (pattern_counters) pattern_counters[pattern_tables[table].base + (index)].tested++; } while (0)
+#define PATTERN_MATCHED(table, index) \
+    do { if (pattern_counters) pattern_matched(pattern_tables[table].base + (index)); } while (0)
+#else
+#define PATTERN_TESTED(table, index) do { } while (0)
+#define PATTERN_MATCHED(table, index) do { } while (0)
+#endif
+
 /* Function Prototypes - All functions must be declared before use */
 static void add_error_with_excerpt(const char *filename, int line, int col, ErrorType type, const char *msg, const char *line_text);
 static void add_error(const char *filename, int line, int col, ErrorType type, const char *msg);
-static void add_codex_comment(const char *filename, int line, const char *comment);
+static void add_codex_comment(const char *filename, int line, const char *comment, size_t length);
+static void append_number(char *message, LONG value);
+static int errors_reserve(void);
+static void errors_stream(void);
+static ULONG issue_total(void);
+static void errors_close(void);
+static int lex_line(const char *line, int line_num, const char *filename, char *original_line, char *clean_line);
 static void process_line(const char *line, int line_num, const char *filename);
+static void errors_sort(void);
 static void print_errors(void);
+static void print_error_list(void);
 static void print_usage(void);
 static int process_file(const char *filename);
+static void finish_file(const char *filename, int line_count);
+static void select_validation_modes(const ModeSwitches *requested);
+static APTR mem_alloc(ULONG size, ULONG flags, MemSubsystem subsystem);
+static void mem_free(APTR memory);
+static void mem_charge(MemSubsystem subsystem, ULONG size);
+static void mem_discharge(MemSubsystem subsystem, ULONG size);
+static void mem_sample(void);
+static APTR arena_alloc(Arena *arena, ULONG size);
+static void arena_reset(Arena *arena);
+static void arena_close(Arena *arena);
+static void print_memory_stats(void);
+static int engine_by_name(const char *name, EngineId *engine);
+static int engine_open(void);
+static void engine_close(void);
+static int pattern_lookup(PatternTableId table, const char *word);
+static int pattern_search(PatternTableId table, const char *text);
 /* static void trim_leading_whitespace(char *str); */
 static char* find_first_non_whitespace(char *str);
 static int is_declaration_keyword(const char *word);
@@ -381,6 +1115,123 @@ static int is_amiga_function(const char *word);
 static int find_memsafe_replacement(const char *function, char *replacement, size_t max_len);
 static int find_universal_replacement(const char *keyword, char *replacement, size_t max_len);
 static int is_stdlib_function(const char *word);
+static void check_c89_declarations(char *trimmed_line, const char *clean_line, int line_num, const char *filename, const char *original_line);
+static void check_line_length(int line_num, const char *filename, const char *original_line);
+static void update_block_state(const char *clean_line);
+static void skim_text(char *text);
+static void skip_line_rest(BPTR file_handle, char *buffer, const char *line, int line_num, const char *filename, int in_comment);
+static int is_statement_keyword(const char *word);
+static void copy_line(char *buffer, const char *line);
+static int line_has_word(const char *line);
+static int line_has_identifier(const char *line, const char *word);
+
+/* Loop scope prototypes */
+static void check_loop_scopes(const char *line, int line_num, const char *filename, const char *original_line);
+static LoopScope *loop_innermost(void);
+static void loop_statement_starts(void);
+static void loop_push(LoopKind kind, LoopPhase phase, int line_num);
+static void loop_pop(void);
+static void loop_finish(void);
+static void loop_poll(LoopScope *loop, const char *name, const char *suffix, int negated, int column, int line_num, const char *original_line);
+static int loop_negated(const char *line, const char *start, const char *arguments);
+static int loop_list_waits(const char *line, const char *start, const char *end);
+static void loop_copy_excerpt(char *excerpt, const char *original_line);
+static void loop_end_statements(void);
+static void loop_punctuation(char c);
+static void loop_add_variable(LoopScope *loop, const char *name);
+static void loop_add_name(LoopScope *loop, char names[][LOOP_VARIABLE_LENGTH], UBYTE *count, const char *name);
+static int loop_has_name(char names[][LOOP_VARIABLE_LENGTH], int count, const char *name);
+static int loop_counts(LoopScope *loop);
+static int loop_uses_variable(const LoopScope *loop, const char *arguments);
+static const char *loop_word(const char *start, const char *line, int line_num, const char *filename, const char *original_line);
+static void loop_call(const char *name, const char *arguments, int column, int line_num, const char *filename, const char *original_line);
+static void loop_hold_call(const LoopScope *loop, const char *name, const char *arguments, int column, int line_num, const char *original_line);
+static void loop_report_calls(int first_loop);
+static void loop_report_call(const char *name, int loop_line, int repeats, int line_num, int column, const char *excerpt);
+static int is_loop_setup_function(const char *word);
+static int find_unbuffered_io(const char *word);
+static int loop_table_lookup(PatternTableId table, const char *word);
+static int loop_argument(const char *arguments, int index, const char **start, size_t *length);
+static int loop_constant_size(const char *text, size_t length, LONG *size);
+
+/* Chip RAM prototypes */
+static void chip_word(const char *word, const char *start, const char *next, const char *line, int column, int line_num, const char *original_line);
+static void chip_allocation(int allocator, const char *arguments, const char *line, const char *start, int column, int line_num, const char *original_line);
+static void chip_use(ChipAllocation *allocation, const char *line, const char *start, const char *next);
+static int chip_enclosing_call(const char *line, const char *start, char *name);
+static const char *chip_skip_back(const char *line, const char *p);
+static int chip_requested(const char *text, size_t length);
+static int chip_is_local(const char *name);
+static ChipAllocation *chip_find(const char *name, size_t length);
+static void chip_function_end(void);
+
+/* STACKCHECK/S prototypes */
+static int stack_open(void);
+static void stack_close(void);
+static void stack_file_begin(void);
+static const char *stack_filename(const char *filename);
+static StackSymbol *stack_symbol(const char *name, SymbolKind kind, int create);
+static void stack_define_size(const char *name, SymbolKind kind, LONG size, int unknown);
+static const char *stack_word(const char *p, char *buffer);
+static int stack_evaluate(const char *text, size_t length, LONG *value);
+static int stack_type_size(const char *word, LONG *size);
+static LONG stack_record_size(const char *tag, int *unknown);
+static int stack_declaration(const char *text, LONG *size, int *unknown, char *name);
+static void stack_read_cookie(const char *cookie, int line_num, const char *filename);
+static void stack_read_define(const char *text);
+static void stack_scan_line(const char *clean_line, const char *original_line, int line_num, const char *filename);
+static void stack_file_word(int line_num, int before_paren);
+static void stack_file_punctuation(char c);
+static const char *stack_enum_constant(const char *after);
+static void stack_open_brace(const char *filename);
+static void stack_close_brace(void);
+static void stack_end_statement(void);
+static void stack_add_call(int line_num, const char *filename);
+static void stack_search(StackSymbol *root, StackSymbol **path);
+static void stack_analyse(void);
+static int stack_chain_candidate(StackSymbol *symbol, StackSymbol *best, StackSymbol **shown, int count);
+static StackSymbol *stack_next_chain(StackSymbol **shown, int count);
+static void print_stack_chain(StackSymbol *head, StackSymbol *first);
+static void print_stack_report(void);
+
+static int eclock_open(void);
+static void eclock_close(void);
+static ULONG eclock_now(void);
+static ULONG eclock_to_us(ULONG ticks);
+static void stage_begin(void);
+static void stage_end(StageId stage);
+static void metrics_write_header(BPTR file, const char *name, const char *type, const char *help);
+static void metrics_write_ratio(BPTR file, ULONG part, ULONG whole);
+static void metrics_write_seconds(BPTR file, ULONG ticks);
+static ULONG run_idle_ticks(void);
+static void telemetry_mark(FileTelemetry *mark);
+static void print_file_telemetry(const char *filename, int lines, const FileTelemetry *start);
+static void print_run_telemetry(void);
+static int metrics_write(const char *filename);
+
+#ifdef CODEX_PROFILE
+/* Profiling and tracing prototypes */
+static void profile_begin(RuleId rule);
+static void profile_end(ULONG bytes);
+static void print_profile(void);
+static int counters_open(const char **reason);
+static void counters_read(double events[COUNTER_COUNT]);
+static void counters_close(void);
+static void print_counter_ratio(double numerator, double denominator, double scale, int available);
+static void print_counter_header(const char *first_column, int with_events);
+static void print_counter_row(const char *name, ULONG ticks, const double *events, int with_events);
+static void print_counters(void);
+static int trace_open(void);
+static void trace_add(const char *name, TraceCategory category, ULONG start, ULONG end);
+static int trace_write(const char *filename);
+static void trace_close(void);
+static int patstats_open(void);
+static void pattern_matched(ULONG counter);
+static void pattern_credit_diagnosis(void);
+static int pattern_shadowed_by(const PatternTable *table, int index, int *duplicate);
+static void print_pattern_stats(void);
+static void patstats_close(void);
+#endif
 
 /* String function prototypes for Amiga compatibility - removed, using standard library */
 
@@ -390,21 +1241,35 @@ int main(int argc, char **argv) {
     struct RDArgs *rda;
     STRPTR *current_file;
     int modes_shown = 0;
-    static CONST_STRPTR template = "FILES/M/A,AMIGA/S,NDK/S,C89/S,C99/S,SASC/S,VBCC/S,DICE/S,MEMSAFE/S,QUIET/S,HELP/S";
+    EngineId engine = ENGINE_FAST;
+#ifdef CODEX_PROFILE
+    ULONG output_start;
+#endif
+    static CONST_STRPTR template = "FILES/M/A,AMIGA/S,NDK/S,C89/S,C99/S,SASC/S,VBCC/S,DICE/S,MEMSAFE/S,QUIET/S,HELP/S,MEMSTATS/S,ENGINE/K,METRICS/K,VERBOSE/S,LOWMEM/S,STACKCHECK/S"
+#ifdef CODEX_PROFILE
+                                   ",PROFILE/S,TRACE/K,TRACESAMPLE/K/N,PATSTATS/S,COUNTERS/S"
+#endif
+                                   ;
     
     /* Using a struct for cleaner argument handling */
     struct {
         STRPTR *files;
-        LONG amiga_standards;
-        LONG ndk_standards;
-        LONG c89_standards;
-        LONG c99_standards;
-        LONG sasc_standards;
-        LONG vbcc_standards;
-        LONG dice_standards;
-        LONG memsafe_standards;
+        ModeSwitches modes;
         LONG quiet;
         LONG help;
+        LONG memstats;
+        STRPTR engine;
+        STRPTR metrics;
+        LONG verbose;
+        LONG lowmem;
+        LONG stackcheck;
+#ifdef CODEX_PROFILE
+        LONG profile;
+        STRPTR trace;
+        LONG *trace_sample;
+        LONG patstats;
+        LONG counters;
+#endif
     } args = {0};
 
     rda = ReadArgs(template, (LONG *)&args, NULL);
@@ -422,83 +1287,87 @@ int main(int argc, char **argv) {
 
     /* Set configuration flags based on arguments */
     if (args.quiet) quiet_mode = 1;
-
-    /* Set validation mode flags based on arguments */
-    if (args.amiga_standards) validate_amiga_standards = 1;
-    if (args.ndk_standards) validate_ndk_standards = 1;
-    if (args.c89_standards) validate_c89_standards = 1;
-    if (args.c99_standards) validate_c99_standards = 1;
-    if (args.sasc_standards) validate_sasc_standards = 1;
-    if (args.vbcc_standards) validate_vbcc_standards = 1;
-    if (args.dice_standards) validate_dice_standards = 1;
-    if (args.memsafe_standards) validate_memsafe_standards = 1;
-
-    /* If the user explicitly asked for C99, disable the default C89 checks unless
-       the user also explicitly requested C89 or selected a mode that implies C89. */
-    if (args.c99_standards &&
-        !args.c89_standards &&
-        !args.sasc_standards &&
-        !args.dice_standards &&
-        !args.memsafe_standards) {
-        validate_c89_standards = 0;
+    if (args.memstats) {
+        memstats_enabled = 1;
+        mem_free_at_start = AvailMem(MEMF_ANY);
+        mem_free_lowest = mem_free_at_start;
     }
-
-    /* Implement mode dependencies with warnings for conflicts */
-    if (validate_sasc_standards) {
-        if (validate_c99_standards) {
-            if (!quiet_mode) Printf("Warning: SAS/C mode overrides C99 mode (SAS/C is C89-only)\n");
-        }
-        validate_c89_standards = 1;  /* SASC implies C89 */
-        validate_c99_standards = 0;  /* SASC does NOT imply C99 */
-        enforce_compiler_compatibility = 1;  /* SASC enables compiler compatibility checking */
+    if (args.engine && !engine_by_name(args.engine, &engine)) {
+        Printf("Error: Unknown ENGINE '%s', use LEGACY or FAST\n", args.engine);
+        FreeArgs(rda);
+        return CODEX_RETURN_FAIL;
     }
-    if (validate_vbcc_standards) {
-        if (validate_c89_standards) {
-            if (!quiet_mode) Printf("Warning: VBCC mode overrides C89 mode (VBCC supports C99)\n");
-        }
-        validate_c99_standards = 1;  /* VBCC implies C99 */
-        validate_c89_standards = 0;  /* VBCC does NOT imply C89 */
-        enforce_compiler_compatibility = 1;  /* VBCC enables compiler compatibility checking */
+    if (args.lowmem) {
+        lowmem_mode = 1;
+        /* The FAST index costs memory for the whole run; an explicit ENGINE still wins */
+        if (!args.engine) engine = ENGINE_LEGACY;
     }
-    if (validate_amiga_standards) {
-        if (!validate_ndk_standards) {
-            if (!quiet_mode) Printf("Info: Amiga mode enables NDK validation\n");
+    if (args.stackcheck) {
+        if (stack_open()) {
+            stackcheck_enabled = 1;
+        } else {
+            Printf("Warning: Not enough memory for the call graph, STACKCHECK disabled\n");
         }
-        validate_ndk_standards = 1;  /* AMIGA implies NDK */
-        enforce_amiga_pascalcase = 1;  /* AMIGA enables PascalCase enforcement */
-        enforce_compiler_compatibility = 1;  /* AMIGA enables compiler compatibility checking */
     }
-    if (validate_dice_standards) {
-        if (!validate_c89_standards) {
-            if (!quiet_mode) Printf("Info: DICE mode enables C89 validation\n");
+
+#ifdef CODEX_PROFILE
+    if (args.profile || args.trace || args.counters) {
+        if (!eclock_open()) {
+            Printf("Warning: Cannot open %s, profiling and tracing disabled\n", TIMERNAME);
+        } else {
+            if (args.profile) profile_enabled = 1;
+            if (args.counters) {
+                const char *reason = NULL;
+
+                counters_enabled = 1;
+                stage_timing_enabled = 1;
+                if (!counters_open(&reason) && !quiet_mode) {
+                    Printf("Info: Hardware counters unavailable (%s), showing time only\n", reason);
+                }
+            }
+            if (args.trace) {
+                if (args.trace_sample) trace_sample_interval = (ULONG)*args.trace_sample;
+                if (trace_open()) {
+                    trace_enabled = 1;
+                } else {
+                    Printf("Warning: Not enough memory for the trace buffer, tracing disabled\n");
+                }
+            }
         }
-        if (!validate_ndk_standards) {
-            if (!quiet_mode) Printf("Info: DICE mode enables NDK validation\n");
+    }
+    if (args.patstats) {
+        if (patstats_open()) {
+            patstats_enabled = 1;
+        } else {
+            Printf("Warning: Not enough memory for pattern statistics, PATSTATS disabled\n");
         }
-        validate_c89_standards = 1;  /* DICE implies C89 for now */
-        validate_ndk_standards = 1;  /* DICE implies NDK */
-        enforce_compiler_compatibility = 1;  /* DICE enables compiler compatibility checking */
     }
-    if (validate_ndk_standards) {
-        enforce_compiler_compatibility = 1;  /* NDK enables compiler compatibility checking */
+    /* PATSTATS counts every entry a lookup compares, which only means something for the linear scan */
+    if (patstats_enabled && engine == ENGINE_FAST) {
+        if (args.engine && !quiet_mode) Printf("Info: PATSTATS counts the legacy engine, using ENGINE LEGACY\n");
+        engine = ENGINE_LEGACY;
     }
-    if (validate_memsafe_standards) {
-        if (!validate_c89_standards) {
-            if (!quiet_mode) Printf("Info: MEMSAFE mode enables C89 validation\n");
+#endif
+    if (args.metrics || args.verbose) {
+        if (TimerBase || eclock_open()) {
+            stage_timing_enabled = 1;
+        } else {
+            Printf("Warning: Cannot open %s, stage times are left out\n", TIMERNAME);
         }
-        validate_c89_standards = 1;  /* MEMSAFE implies C89 */
     }
-    
-    /* Ensure at least one standard is enabled - but don't override explicit mode choices */
-    if (!validate_c89_standards && !validate_c99_standards) {
-        /* Only default to C89 if no compiler mode was specified that would imply a standard */
-        if (!validate_sasc_standards && !validate_vbcc_standards && !validate_dice_standards) {
-            validate_c89_standards = 1;  /* Default to C89 if no specific mode specified */
-        }
+    if (args.verbose) verbose_enabled = 1;
+    if (stage_timing_enabled) run_start_ticks = eclock_now();
+    STARTUP_MARK("args");
+    if (engine == ENGINE_FAST && !engine_open()) {
+        Printf("Warning: Not enough memory for the FAST engine, using ENGINE LEGACY\n");
     }
 
+    select_validation_modes(&args.modes);
+    STARTUP_MARK("tables");
+
     /* Correctly process multiple files from FILES/M */
     if (args.files) {
+        for (current_file = args.files; *current_file; current_file++) files_queued++;
         current_file = args.files;
         while (*current_file) {
             if (process_file(*current_file) != 0) {
@@ -506,11 +1375,21 @@ int main(int argc, char **argv) {
             }
             current_file++;
         }
+        if (stackcheck_enabled) {
+            stack_analyse();
+            if (lowmem_mode) errors_stream(); /* Printed after the last file's issues */
+        }
     } else {
         if (!quiet_mode) Printf("No input files specified.\n");
         print_usage();
     }
 
+    STARTUP_MARK("lint");
+#ifdef CODEX_PROFILE
+    output_start = trace_enabled ? eclock_now() : 0;
+#endif
+    STAGE_START();
+
     if (!quiet_mode) {
         Printf("\nCodex analysis complete.\n");
         
@@ -527,27 +1406,69 @@ int main(int argc, char **argv) {
         if (modes_shown == 0) { Printf("None (basic style checking only)"); }
         Printf("\n");
         
-        if (error_count > 0) {
-            Printf("Found %ld issues in %ld files (%ld lines processed).\n", error_count, total_files, total_lines);
-            print_errors();
+        if (error_count > 0 || errors_streamed > 0) {
+            Printf("Found %ld issues in %ld files (%ld lines processed).\n", (LONG)(error_count + errors_streamed), (LONG)total_files, (LONG)total_lines);
+            if (!lowmem_mode) print_errors(); /* Already printed file by file */
             exit_code = CODEX_RETURN_WARN;
         } else {
-            Printf("No issues found in %ld files (%ld lines processed).\n", total_files, total_lines);
+            Printf("No issues found in %ld files (%ld lines processed).\n", (LONG)total_files, (LONG)total_lines);
         }
+        if (stackcheck_enabled) print_stack_report();
+        if (lowmem_mode) Printf("Peak heap: %ld bytes.\n", (LONG)mem_heap_peak);
     } else {
         /* In quiet mode, only show errors, no summary */
-        if (error_count > 0) {
-            print_errors();
-            exit_code = CODEX_RETURN_WARN;
+        if (error_count > 0) print_errors();
+        if (error_count > 0 || errors_streamed > 0) exit_code = CODEX_RETURN_WARN;
+    }
+
+    STAGE_END(STAGE_OUTPUT);
+    STARTUP_MARK("output");
+    if (stage_timing_enabled) run_ticks = eclock_now() - run_start_ticks;
+    if (verbose_enabled && !quiet_mode) print_run_telemetry();
+
+#ifdef CODEX_PROFILE
+    if (trace_enabled) {
+        trace_add("output", TRACE_STAGE, output_start, eclock_now());
+        if (!trace_write(args.trace)) {
+            Printf("Error: Cannot write trace file '%s'\n", args.trace);
+            exit_code = CODEX_RETURN_ERROR;
         }
+        trace_close();
+    }
+    if (profile_enabled) print_profile();
+    if (counters_enabled) {
+        print_counters();
+        counters_close();
+    }
+    if (patstats_enabled) {
+        print_pattern_stats();
+        patstats_close();
+    }
+#endif
+    if (args.metrics && !metrics_write(args.metrics)) {
+        Printf("Error: Cannot write metrics file '%s'\n", args.metrics);
+        exit_code = CODEX_RETURN_ERROR;
     }
+    if (TimerBase) eclock_close();
+    engine_close();
+    errors_close();
+    arena_close(&file_arena);
+    stack_close();
+    if (memstats_enabled) print_memory_stats();
 
     FreeArgs(rda);
+    Flush(Output());
+    STARTUP_MARK("flush");
     return exit_code;
 }
 
 /* Adds an error with line excerpt to the global error list */
 static void add_error_with_excerpt(const char *filename, int line, int col, ErrorType type, const char *msg, const char *line_text) {
+#ifdef CODEX_PROFILE
+    if (pattern_pending_count > 0) pattern_credit_diagnosis();
+#endif
+    rule_diagnostics[current_rule][type]++;
+    diagnostics_found++;
     if (error_count >= MAX_ERRORS) {
         if (error_count == MAX_ERRORS) { /* Print only once */
              Printf("Warning: Maximum error count reached. Further errors will be ignored.\n");
@@ -555,6 +1476,7 @@ static void add_error_with_excerpt(const char *filename, int line, int col, Erro
         }
         return;
     }
+    if (!errors_reserve()) return;
 
     strncpy(errors[error_count].filename, filename, MAX_FILENAME_LENGTH - 1);
     errors[error_count].filename[MAX_FILENAME_LENGTH - 1] = '\0';
@@ -568,8 +1490,8 @@ static void add_error_with_excerpt(const char *filename, int line, int col, Erro
     if (line_text && *line_text) {
         strncpy(errors[error_count].line_excerpt, line_text, LINE_EXCERPT_LIMIT);
         errors[error_count].line_excerpt[LINE_EXCERPT_LIMIT] = '\0';
-        /* Add truncation indicator if line was too long */
-        if (strlen(line_text) > LINE_EXCERPT_LIMIT) {
+        /* Add truncation indicator if line was too long (without measuring all of it) */
+        if (strlen(errors[error_count].line_excerpt) == LINE_EXCERPT_LIMIT && line_text[LINE_EXCERPT_LIMIT]) {
             strncpy(errors[error_count].line_excerpt + TRUNCATION_START, "...", TRUNCATION_LENGTH);
             errors[error_count].line_excerpt[LINE_EXCERPT_LIMIT] = '\0';
         }
@@ -585,10 +1507,10 @@ static void add_error(const char *filename, int line, int col, ErrorType type, c
     add_error_with_excerpt(filename, line, col, type, msg, NULL);
 }
 
-/* Adds a $CODEX: comment as a special error message for testing */
-static void add_codex_comment(const char *filename, int line, const char *comment) {
-    char message[256];
-    
+/* Adds a $CODEX: comment, given as a span of the line, as a special error message for testing */
+static void add_codex_comment(const char *filename, int line, const char *comment, size_t length) {
+    rule_diagnostics[current_rule][ERROR_COMMENT]++;
+    diagnostics_found++;
     if (error_count >= MAX_ERRORS) {
         if (error_count == MAX_ERRORS) { /* Print only once */
              Printf("Warning: Maximum error count reached. Further errors will be ignored.\n");
@@ -596,6 +1518,7 @@ static void add_codex_comment(const char *filename, int line, const char *commen
         }
         return;
     }
+    if (!errors_reserve()) return;
 
     strncpy(errors[error_count].filename, filename, MAX_FILENAME_LENGTH - 1);
     errors[error_count].filename[MAX_FILENAME_LENGTH - 1] = '\0';
@@ -603,18 +1526,84 @@ static void add_codex_comment(const char *filename, int line, const char *commen
     errors[error_count].column = 1;
     errors[error_count].type = ERROR_COMMENT; /* Use comment type for $CODEX: comments */
     
-    /* Format the comment message */
-    strncpy(message, comment, sizeof(message) - 1);
-    message[sizeof(message) - 1] = '\0';
-    strncpy(errors[error_count].message, message, sizeof(errors[error_count].message) - 1);
-    errors[error_count].message[sizeof(errors[error_count].message) - 1] = '\0';
+    if (length >= sizeof(errors[error_count].message)) length = sizeof(errors[error_count].message) - 1;
+    memcpy(errors[error_count].message, comment, length);
+    errors[error_count].message[length] = '\0';
+    errors[error_count].line_excerpt[0] = '\0'; /* The LOWMEM/S ring reuses its entries */
 
     error_count++;
 }
 
+/* Appends a number in decimal to a message in a LARGE_MESSAGE_BUFFER_SIZE buffer */
+static void append_number(char *message, LONG value) {
+    char digits[NUMBER_TEXT_LENGTH];
+    char *p = digits + sizeof(digits) - 1;
+    ULONG magnitude = value < 0 ? (ULONG)-value : (ULONG)value;
+
+    *p = '\0';
+    do {
+        *--p = (char)('0' + magnitude % DECIMAL_BASE);
+        magnitude /= DECIMAL_BASE;
+    } while (magnitude > 0);
+    if (value < 0) *--p = '-';
+    strncat(message, p, LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+}
+
+/* Makes room for one more issue, doubling the list up to MAX_ERRORS; returns 0 if memory ran out */
+static int errors_reserve(void) {
+    LintError *grown;
+    int capacity;
+
+    if (error_count < error_capacity) return 1;
+    if (lowmem_mode && error_capacity > 0) {
+        errors_stream(); /* The ring is full; print it and start again */
+        return 1;
+    }
+    capacity = error_capacity > 0 ? error_capacity * 2 : ERRORS_INITIAL_CAPACITY;
+    if (lowmem_mode) capacity = LOWMEM_ERROR_RING;
+    if (capacity > MAX_ERRORS) capacity = MAX_ERRORS;
+    grown = mem_alloc((ULONG)capacity * sizeof(LintError), MEMF_ANY, MEM_DIAGNOSTICS);
+    if (!grown) {
+        if (!errors_out_of_memory) { /* Print only once */
+            Printf("Warning: Not enough memory for more issues. Further errors will be ignored.\n");
+            errors_out_of_memory = 1;
+        }
+        return 0;
+    }
+    if (errors) {
+        memcpy(grown, errors, (size_t)error_count * sizeof(LintError));
+        mem_free(errors);
+    }
+    errors = grown;
+    error_capacity = capacity;
+    return 1;
+}
+
+/* Issues reported so far, counting those LOWMEM/S has already printed and emptied from the list */
+static ULONG issue_total(void) {
+    return errors_streamed + (ULONG)error_count;
+}
+
+/* Prints the issues held so far and empties the list (LOWMEM/S); the report
+   header comes before the first of them, as print_errors() puts it */
+static void errors_stream(void) {
+    if (errors_streamed == 0 && error_count > 0 && !quiet_mode) Printf("\n--- Detailed Error Report ---\n");
+    print_error_list();
+    errors_streamed += (ULONG)error_count;
+    error_count = 0;
+}
+
+static void errors_close(void) {
+    if (errors) {
+        mem_free(errors);
+        errors = NULL;
+    }
+    error_capacity = 0;
+}
+
 /* A helper to check if a word is a C89 type or storage class keyword */
 static int is_declaration_keyword(const char *word) {
-    const char *decl_keywords[] = {
+    static const char *const decl_keywords[] = {
         "auto", "char", "const", "double", "enum", "extern", "float", "int", "long",
         "register", "short", "signed", "static", "struct", "typedef", "union",
         "unsigned", "void", "volatile"
@@ -627,24 +1616,66 @@ static int is_declaration_keyword(const char *word) {
     return 0;
 }
 
+/* Whether a word starts a statement, so it is neither a declaration nor a call */
+static int is_statement_keyword(const char *word) {
+    static const char *const statement_keywords[] = {
+        "break", "case", "continue", "default", "do", "else", "for", "goto", "if",
+        "return", "sizeof", "switch", "while"
+    };
+    int i;
+    int num_keywords = sizeof(statement_keywords) / sizeof(statement_keywords[0]);
+    for (i = 0; i < num_keywords; i++) {
+        if (strcmp(word, statement_keywords[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+/* Copies a line into one of the line_context buffers, cut to MAX_LINE_LENGTH - 1
+   characters.  Unlike strncpy(), it does not pad the rest of the buffer */
+static void copy_line(char *buffer, const char *line) {
+    size_t length = strlen(line);
+
+    if (length > MAX_LINE_LENGTH - 1) length = MAX_LINE_LENGTH - 1;
+    memcpy(buffer, line, length);
+    buffer[length] = '\0';
+}
+
+/* Whether a line holds a letter, digit or '_' */
+static int line_has_word(const char *line) {
+    for (; *line; line++) {
+        if (isalnum((unsigned char)*line) || *line == '_') return 1;
+    }
+    return 0;
+}
+
+/* Whether a line holds word as a whole identifier, not as part of a longer one */
+static int line_has_identifier(const char *line, const char *word) {
+    size_t length = strlen(word);
+    const char *p = line;
+
+    while ((p = strstr(p, word)) != NULL) {
+        if ((p == line || !(isalnum((unsigned char)p[-1]) || p[-1] == '_')) &&
+            !(isalnum((unsigned char)p[length]) || p[length] == '_')) {
+            return 1;
+        }
+        p += length;
+    }
+    return 0;
+}
+
 /* Checks for all issues on a single line */
-static void process_line(const char *line, int line_num, const char *filename) {
-    char clean_line[MAX_LINE_LENGTH];
-    char original_line[MAX_LINE_LENGTH];
+/* Lexer: copies line to original_line and to clean_line with comments removed
+   and literal contents blanked.  Returns 0 if a '//' comment was reported,
+   which ends the checks for this line */
+static int lex_line(const char *line, int line_num, const char *filename, char *original_line, char *clean_line) {
     char *p;
     int in_string = 0;
     int in_char_literal = 0;
     const char *s;
-    char *trimmed_line;
-    char *first_word;
-    char line_copy[MAX_LINE_LENGTH];
-    char clean_comment[256];
-    size_t comment_len;
-    int initial_error_count = error_count; /* Store the error count at the start */
+    ULONG initial_issues = issue_total();
+
+    copy_line(original_line, line);
 
-    strncpy(original_line, line, sizeof(original_line) - 1);
-    original_line[sizeof(original_line) - 1] = '\0';
-    
     /* Create a working copy */
     p = clean_line;
     s = line;
@@ -662,17 +1693,20 @@ static void process_line(const char *line, int line_num, const char *filename) {
             continue;
         }
 
-        if (*s == '/' && *(s+1) == '*') {
+        if (*s == '/' && *(s+1) == '*' && !in_string && !in_char_literal) {
             parse_state.in_multiline_comment = 1;
             s += COMMENT_START_LENGTH;
             continue;
         }
 
-        if (*s == '/' && *(s+1) == '/') {
+        if (*s == '/' && *(s+1) == '/' && !in_string && !in_char_literal) {
             /* Only flag C++ comments if C89 mode is active and SAS/C mode is not active (SAS/C supports them) */
             if (validate_c89_standards && !validate_sasc_standards) {
                 add_error_with_excerpt(filename, line_num, s - line + ARRAY_OFFSET_1, ERROR_SYNTAX, "C++ comments ('//') are not allowed in C89.", original_line);
-                if (error_count > initial_error_count) return; /* Exit after first error */
+                if (issue_total() > initial_issues) {
+                    *p = '\0';
+                    return 0; /* Exit after first error */
+                }
             }
             break; /* Rest of the line is a comment */
         }
@@ -687,13 +1721,14 @@ static void process_line(const char *line, int line_num, const char *filename) {
             }
         }
         
-        /* Now check for quote characters (escapes already handled above) */
-        if (*s == '"') {
+        /* Now check for quote characters (escapes already handled above); a
+           quote of the other kind inside a literal is part of it */
+        if (*s == '"' && !in_char_literal) {
             *p++ = *s++;
             in_string = !in_string;
             continue;
         }
-        if (*s == '\'') {
+        if (*s == '\'' && !in_string) {
             *p++ = *s++;
             in_char_literal = !in_char_literal;
             continue;
@@ -709,14 +1744,34 @@ static void process_line(const char *line, int line_num, const char *filename) {
         *p++ = *s++;
     }
     *p = '\0';
+    return 1;
+}
+
+static void process_line(const char *line, int line_num, const char *filename) {
+    char *clean_line = line_context.clean;
+    char *original_line = line_context.original;
+    char *trimmed_line;
+    ULONG initial_issues = issue_total(); /* Store the issue count at the start */
+#ifdef CODEX_PROFILE
+    size_t line_bytes = profile_enabled ? strlen(line) : 0;
+#endif
+
+    PROFILE_BEGIN(RULE_LEXER);
+    if (!lex_line(line, line_num, filename, original_line, clean_line)) {
+        PROFILE_END(line_bytes);
+        return; /* Exit after first error */
+    }
 
     /* After cleaning comments, check content */
     trimmed_line = find_first_non_whitespace(clean_line);
+    PROFILE_END(line_bytes);
     if (!*trimmed_line) return; /* Line is empty or only comments */
 
     /* Check for $CODEX: comments ONLY if no other error has been found yet */
-    if (error_count == initial_error_count) {
-        const char *codex_pos = strstr(original_line, "$CODEX:");
+    if (issue_total() == initial_issues) {
+        const char *codex_pos;
+        PROFILE_BEGIN(RULE_CODEX_COMMENT);
+        codex_pos = strstr(original_line, "$CODEX:");
         if (codex_pos) {
             const char *comment_start = codex_pos + 7; /* Skip "$CODEX:" */
             while (*comment_start == ' ' || *comment_start == '\t') comment_start++; /* Skip leading whitespace */
@@ -725,178 +1780,462 @@ static void process_line(const char *line, int line_num, const char *filename) {
                 const char *comment_end = comment_start;
                 while (*comment_end && *comment_end != '/' && *comment_end != '*') comment_end++;
                 
-                /* Create a clean comment message */
-                comment_len = comment_end - comment_start;
-                if (comment_len >= sizeof(clean_comment)) comment_len = sizeof(clean_comment) - 1;
-                
-                strncpy(clean_comment, comment_start, comment_len);
-                clean_comment[comment_len] = '\0';
-                
                 /* Add the $CODEX comment as a test output since no other errors were found */
-                add_codex_comment(filename, line_num, clean_comment);
+                add_codex_comment(filename, line_num, comment_start, (size_t)(comment_end - comment_start));
+                initial_issues = issue_total(); /* The comment is not the line's first error; the rules still run */
             }
         }
+        PROFILE_END(line_bytes);
     }
 
-    /* --- STANDARDS VALIDATION CHECKS --- */
-    if (validate_c89_standards) {
-        check_c89_standards(clean_line, line_num, filename, original_line);
-        if (error_count > initial_error_count) return; /* Exit after first error */
-    }
-    
-    if (validate_c99_standards) {
-        check_c99_standards(clean_line, line_num, filename, original_line);
-        if (error_count > initial_error_count) return; /* Exit after first error */
-    }
-    
-    if (validate_amiga_standards) {
-        check_amiga_standards(clean_line, line_num, filename, original_line);
-        if (error_count > initial_error_count) return; /* Exit after first error */
-    }
-    
-    if (validate_ndk_standards) {
-        check_ndk_standards(clean_line, line_num, filename, original_line);
-        if (error_count > initial_error_count) return; /* Exit after first error */
-    }
-    
-    if (validate_sasc_standards) {
-        check_sasc_standards(clean_line, line_num, filename, original_line);
-        if (error_count > initial_error_count) return; /* Exit after first error */
-    }
-    
-    if (validate_vbcc_standards) {
-        check_vbcc_standards(clean_line, line_num, filename, original_line);
-        if (error_count > initial_error_count) return; /* Exit after first error */
-    }
-    
-    if (validate_dice_standards) {
-        check_dice_standards(clean_line, line_num, filename, original_line);
-        if (error_count > initial_error_count) return; /* Exit after first error */
-    }
-    
-    if (validate_memsafe_standards) {
-        check_memsafe_standards(clean_line, line_num, filename, original_line);
-        if (error_count > initial_error_count) return; /* Exit after first error */
-    }
+    /* A line of punctuation alone, such as "{" or "});", has no word or
+       number for the standards, magic number and Forbid() checks to find */
+    if (line_has_word(trimmed_line)) {
+        /* --- STANDARDS VALIDATION CHECKS --- */
+        if (validate_c89_standards) {
+            RUN_RULE(RULE_C89, line_bytes, check_c89_standards(clean_line, line_num, filename, original_line));
+            if (issue_total() > initial_issues) return; /* Exit after first error */
+        }
+
+        if (validate_c99_standards) {
+            RUN_RULE(RULE_C99, line_bytes, check_c99_standards(clean_line, line_num, filename, original_line));
+            if (issue_total() > initial_issues) return; /* Exit after first error */
+        }
+
+        if (validate_amiga_standards) {
+            RUN_RULE(RULE_AMIGA, line_bytes, check_amiga_standards(clean_line, line_num, filename, original_line));
+            if (issue_total() > initial_issues) return; /* Exit after first error */
+        }
+
+        if (validate_ndk_standards) {
+            RUN_RULE(RULE_NDK, line_bytes, check_ndk_standards(clean_line, line_num, filename, original_line));
+            if (issue_total() > initial_issues) return; /* Exit after first error */
+        }
+
+        if (validate_sasc_standards) {
+            RUN_RULE(RULE_SASC, line_bytes, check_sasc_standards(clean_line, line_num, filename, original_line));
+            if (issue_total() > initial_issues) return; /* Exit after first error */
+        }
+
+        if (validate_vbcc_standards) {
+            RUN_RULE(RULE_VBCC, line_bytes, check_vbcc_standards(clean_line, line_num, filename, original_line));
+            if (issue_total() > initial_issues) return; /* Exit after first error */
+        }
+
+        if (validate_dice_standards) {
+            RUN_RULE(RULE_DICE, line_bytes, check_dice_standards(clean_line, line_num, filename, original_line));
+            if (issue_total() > initial_issues) return; /* Exit after first error */
+        }
+
+        if (validate_memsafe_standards) {
+            RUN_RULE(RULE_MEMSAFE, line_bytes, check_memsafe_standards(clean_line, line_num, filename, original_line));
+            if (issue_total() > initial_issues) return; /* Exit after first error */
+        }
 
-    /* --- MAGIC NUMBER CHECK --- */
-    check_for_magic_numbers(clean_line, line_num, filename, original_line);
-    if (error_count > initial_error_count) return; /* Exit after first error */
+        /* --- MAGIC NUMBER CHECK --- */
+        RUN_RULE(RULE_MAGIC_NUMBERS, line_bytes, check_for_magic_numbers(clean_line, line_num, filename, original_line));
+        if (issue_total() > initial_issues) return; /* Exit after first error */
 
-    /* --- FORBID/PERMIT PAIR CHECK --- */
-    check_forbid_permit_pairs(clean_line, line_num, filename, original_line);
-    if (error_count > initial_error_count) return; /* Exit after first error */
+        /* --- FORBID/PERMIT PAIR CHECK --- */
+        RUN_RULE(RULE_FORBID_PERMIT, line_bytes, check_forbid_permit_pairs(clean_line, line_num, filename, original_line));
+        if (issue_total() > initial_issues) return; /* Exit after first error */
+    }
 
     /* --- C89 VARIABLE DECLARATION PLACEMENT --- */
     if (validate_c89_standards) {
-        /* Use a more robust approach to avoid false positives with function pointers and complex declarations */
-        char *line_copy = malloc(strlen(trimmed_line) + 1);
-        if (line_copy) {
-            strcpy(line_copy, trimmed_line);
-            first_word = strtok(line_copy, " \t\n\r");
-
-            if (first_word) {
-                if (is_declaration_keyword(first_word)) {
-                    /* Check if this is a simple variable declaration (not a function pointer or complex type) */
-                    char *paren_pos = strchr(trimmed_line, '(');
-                    char *brace_pos = strchr(trimmed_line, '{');
-                    char *semicolon_pos = strchr(trimmed_line, ';');
-                    
-                    /* Only flag if it's a simple declaration (ends with semicolon, no parentheses before semicolon) */
-                    if (semicolon_pos && (!paren_pos || semicolon_pos < paren_pos)) {
-                        if (parse_state.brace_depth > 0 && parse_state.statement_seen[parse_state.brace_depth]) {
-                            add_error_with_excerpt(filename, line_num, (trimmed_line - clean_line) + ARRAY_OFFSET_1, ERROR_SYNTAX, "Variable declaration after a statement is not allowed in C89.", original_line);
-                            free(line_copy);
-                            if (error_count > initial_error_count) return; /* Exit after first error */
-                        }
-                    }
-                } else if (strcmp(first_word, "case") != 0 && strcmp(first_word, "default") != 0 && *trimmed_line != '}') {
-                    /* It's a statement (but not a label or closing brace) */
-                    if (parse_state.brace_depth > 0) {
-                        parse_state.statement_seen[parse_state.brace_depth] = 1;
-                    }
-                }
-            }
-            free(line_copy);
-        }
+        RUN_RULE(RULE_C89_DECLARATIONS, line_bytes, check_c89_declarations(trimmed_line, clean_line, line_num, filename, original_line));
+        if (issue_total() > initial_issues) return; /* Exit after first error */
     }
 
     /* --- STYLE CHECKS --- */
-    if (strlen(original_line) > line_length_limit) {
-                    add_error_with_excerpt(filename, line_num, line_length_limit + ARRAY_OFFSET_1, ERROR_STYLE, "Line exceeds maximum length.", original_line);
-        if (error_count > initial_error_count) return; /* Exit after first error */
-    }
+    RUN_RULE(RULE_LINE_LENGTH, line_bytes, check_line_length(line_num, filename, original_line));
+    if (issue_total() > initial_issues) return; /* Exit after first error */
     
     /* Update block state AFTER all checks for the current line are done */
-    s = clean_line;
-    while(*s) {
+    RUN_RULE(RULE_BLOCK_STATE, line_bytes, update_block_state(clean_line));
+}
+
+/* Flags C89 variable declarations that follow a statement in the same block */
+static void check_c89_declarations(char *trimmed_line, const char *clean_line, int line_num, const char *filename, const char *original_line) {
+    char first_word[MAX_KEYWORD_LENGTH];
+    size_t length = strcspn(trimmed_line, " \t\n\r");
+
+    /* Only the first word matters; a word too long for the buffer cannot be a
+       keyword, and its truncated copy cannot match one either */
+    if (length == 0) return;
+    if (length >= sizeof(first_word)) length = sizeof(first_word) - 1;
+    memcpy(first_word, trimmed_line, length);
+    first_word[length] = '\0';
+
+    if (is_declaration_keyword(first_word)) {
+        /* Check if this is a simple variable declaration (not a function pointer or complex type) */
+        char *paren_pos = strchr(trimmed_line, '(');
+        char *semicolon_pos = strchr(trimmed_line, ';');
+        
+        /* Only flag if it's a simple declaration (ends with semicolon, no parentheses before semicolon) */
+        if (semicolon_pos && (!paren_pos || semicolon_pos < paren_pos)) {
+            if (parse_state.brace_depth > 0 && parse_state.statement_seen[parse_state.brace_depth]) {
+                add_error_with_excerpt(filename, line_num, (trimmed_line - clean_line) + ARRAY_OFFSET_1, ERROR_SYNTAX, "Variable declaration after a statement is not allowed in C89.", original_line);
+            }
+        }
+    } else if (strcmp(first_word, "case") != 0 && strcmp(first_word, "default") != 0 && *trimmed_line != '}') {
+        /* It's a statement (but not a label or closing brace) */
+        if (parse_state.brace_depth > 0) {
+            parse_state.statement_seen[parse_state.brace_depth] = 1;
+        }
+    }
+}
+
+/* Flags lines longer than the configured limit */
+static void check_line_length(int line_num, const char *filename, const char *original_line) {
+    if (strlen(original_line) > (size_t)line_length_limit) {
+        add_error_with_excerpt(filename, line_num, line_length_limit + ARRAY_OFFSET_1, ERROR_STYLE, "Line exceeds maximum length.", original_line);
+    }
+}
+
+/* Tracks brace depth and resets the per-block statement flag */
+static void update_block_state(const char *clean_line) {
+    const char *s = clean_line;
+
+    while(*s) {
         if (*s == '{') {
             if (parse_state.brace_depth < MAX_BLOCK_DEPTH - 1) {
                 parse_state.brace_depth++;
                 parse_state.statement_seen[parse_state.brace_depth] = 0; /* Reset for new block */
+            } else {
+                parse_state.brace_overflow++; /* Untracked, but must still be closed */
             }
         } else if (*s == '}') {
-            if (parse_state.brace_depth > 0) {
+            if (parse_state.brace_overflow > 0) {
+                parse_state.brace_overflow--;
+            } else if (parse_state.brace_depth > 0) {
                  parse_state.statement_seen[parse_state.brace_depth] = 0; /* Clear old state */
                  parse_state.brace_depth--;
             }
         }
         s++;
     }
-    
+}
+
+/* Blanks the comments and literal contents of part of an overlong line in
+   place, carrying the lexer state on from the part before it */
+static void skim_text(char *text) {
+    char *s;
+
+    for (s = text; *s; s++) {
+        char c = *s;
+        char previous = parse_state.skim_previous;
+
+        parse_state.skim_previous = '\0';
+        if (parse_state.in_multiline_comment) {
+            if (previous == '*' && c == '/') parse_state.in_multiline_comment = 0;
+            else if (c == '*') parse_state.skim_previous = c;
+            *s = ' ';
+        } else if (parse_state.skim_quote == '/') {
+            *s = ' ';
+        } else if (parse_state.skim_quote) {
+            if (previous == '\\') {
+                *s = ' '; /* Escaped */
+            } else if (c == parse_state.skim_quote) {
+                parse_state.skim_quote = '\0';
+            } else {
+                if (c == '\\') parse_state.skim_previous = c;
+                *s = ' ';
+            }
+        } else if (previous == '/' && (c == '*' || c == '/')) {
+            if (c == '*') parse_state.in_multiline_comment = 1;
+            else parse_state.skim_quote = '/';
+            *s = ' ';
+        } else if (c == '"' || c == '\'') {
+            parse_state.skim_quote = c;
+        } else if (c == '/') {
+            parse_state.skim_previous = c;
+        }
+    }
+}
 
+/* Reads the rest of a line too long for the line buffer.  It is not checked,
+   but its comments, literals and braces are followed so that the lines after
+   it are read in the right state, and the line is reported as cut short */
+static void skip_line_rest(BPTR file_handle, char *buffer, const char *line, int line_num, const char *filename, int in_comment) {
+    char *checked = line_context.words;
+    char *message = line_context.message;
+    int skipped = 0;
+
+    /* Go over the checked part again for the state it ends in */
+    parse_state.in_multiline_comment = in_comment;
+    parse_state.skim_quote = '\0';
+    parse_state.skim_previous = '\0';
+    copy_line(checked, line);
+    skim_text(checked);
+
+    while (FGets(file_handle, buffer, MAX_LINE_LENGTH)) {
+        int ended = strchr(buffer, '\n') != NULL;
+
+        total_bytes += strlen(buffer);
+        buffer[strcspn(buffer, "\n\r")] = '\0';
+        if (buffer[0]) {
+            /* process_line() stopped at the line length check, before it
+               counted the braces of the checked part */
+            if (!skipped) update_block_state(checked);
+            skipped = 1;
+            skim_text(buffer);
+            update_block_state(buffer);
+            if (stackcheck_enabled) stack_scan_line(buffer, buffer, line_num, filename);
+            if (validate_amiga_standards) check_loop_scopes(buffer, line_num, filename, line_context.original);
+        }
+        if (ended) break;
+    }
+    parse_state.skim_quote = '\0';
+    parse_state.skim_previous = '\0';
+
+    if (skipped) {
+        strncpy(message, "Line is longer than ", LARGE_MESSAGE_BUFFER_SIZE - 1);
+        message[LARGE_MESSAGE_BUFFER_SIZE - 1] = '\0';
+        append_number(message, MAX_LINE_LENGTH - 1);
+        strncat(message, " characters; only that much of it is checked", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+        add_error_with_excerpt(filename, line_num, MAX_LINE_LENGTH, ERROR_WARNING, message, line_context.original);
+    }
 }
 
 static int process_file(const char *filename) {
     BPTR file_handle;
-    static char line_buffer[MAX_LINE_LENGTH]; /* Static to avoid stack allocation in loop */
+    char *line_buffer;
+    char *skip_buffer; /* Rest of an overlong line */
     int line_num = 0;
+    int overlong;
+    int in_comment;
+    FileTelemetry telemetry;
+#ifdef CODEX_PROFILE
+    ULONG file_start = trace_enabled ? eclock_now() : 0;
+    ULONG stage_start = 0;
+#endif
 
     /* Reset state for each new file */
     memset(&parse_state, 0, sizeof(parse_state));
+    if (stackcheck_enabled) stack_file_begin();
+
+    /* Everything allocated for this file comes from file_arena */
+    line_buffer = arena_alloc(&file_arena, MAX_LINE_LENGTH);
+    skip_buffer = arena_alloc(&file_arena, MAX_LINE_LENGTH);
+    if (!line_buffer || !skip_buffer) {
+        Printf("Error: Not enough memory to read file '%s'\n", filename);
+        arena_reset(&file_arena);
+        return 1;
+    }
 
+    telemetry_mark(&telemetry); /* Always taken, so the mark is set whenever VERBOSE/S reads it */
+    STAGE_START();
     file_handle = Open(filename, MODE_OLDFILE);
     if (!file_handle) {
         Printf("Error: Cannot open file '%s'\n", filename);
+        arena_reset(&file_arena);
         return 1;
     }
 
+    if (total_files == 0) STARTUP_MARK("open");
     Printf("Analyzing: %s\n", filename); /* Always show which file is being processed */
     total_files++;
-
-    while (FGets(file_handle, line_buffer, sizeof(line_buffer))) {
+    if (memstats_enabled) mem_sample(); /* DOS buffers are held while the file is open */
+
+    for (;;) {
+#ifdef CODEX_PROFILE
+        /* Decide before reading whether the next line is traced in detail */
+        trace_line_sampled = trace_enabled && trace_sample_interval > 0 &&
+                             ((ULONG)(line_num + 1) % trace_sample_interval) == 0;
+        instrument_line = profile_enabled || patstats_enabled || trace_line_sampled;
+        if (trace_line_sampled) stage_start = eclock_now();
+#endif
+        if (!FGets(file_handle, line_buffer, MAX_LINE_LENGTH)) break;
         line_num++;
         total_lines++;
+        total_bytes += strlen(line_buffer);
+
+        /* A line longer than the buffer is checked on its first part only;
+           the rest is read after it so it does not count as further lines */
+        overlong = !strchr(line_buffer, '\n');
+        in_comment = parse_state.in_multiline_comment;
 
         /* Remove newline characters */
         line_buffer[strcspn(line_buffer, "\n\r")] = '\0';
+        STAGE_END(STAGE_READ);
 
+#ifdef CODEX_PROFILE
+        if (trace_line_sampled) {
+            trace_add("read", TRACE_STAGE, stage_start, eclock_now());
+            stage_start = eclock_now();
+        }
+#endif
         process_line(line_buffer, line_num, filename);
+        if (stackcheck_enabled) {
+            /* Every line, whatever process_line() stopped at; lex_line() has filled line_context */
+            RUN_RULE(RULE_STACK, strlen(line_buffer),
+                     stack_scan_line(line_context.clean, line_context.original, line_num, filename));
+        }
+        if (validate_amiga_standards) {
+            /* Also every line, so that loops are followed past lines with an issue */
+            RUN_RULE(RULE_LOOPS, strlen(line_buffer),
+                     check_loop_scopes(line_context.clean, line_num, filename, line_context.original));
+        }
+        if (overlong) skip_line_rest(file_handle, skip_buffer, line_buffer, line_num, filename, in_comment);
+        STAGE_END(STAGE_LINT);
+#ifdef CODEX_PROFILE
+        if (trace_line_sampled) trace_add("line", TRACE_STAGE, stage_start, eclock_now());
+#endif
     }
 
     Close(file_handle);
+    STAGE_END(STAGE_READ);
+    finish_file(filename, line_num);
+    STAGE_END(STAGE_FINISH);
+    if (verbose_enabled) print_file_telemetry(filename, line_num, &telemetry);
+
+#ifdef CODEX_PROFILE
+    trace_line_sampled = 0;
+    instrument_line = profile_enabled || patstats_enabled;
+    if (trace_enabled) trace_add(filename, TRACE_FILE, file_start, eclock_now());
+#endif
+    
+    if (lowmem_mode) {
+        /* Print this file's issues and hand every buffer back before the next file */
+        errors_stream();
+        errors_close();
+        arena_close(&file_arena);
+    } else {
+        arena_reset(&file_arena);
+    }
+    return 0;
+}
+
+/* Turns on the requested validation modes and the modes they imply */
+static void select_validation_modes(const ModeSwitches *requested) {
+    /* Set validation mode flags based on arguments; C89 is on by default */
+    validate_amiga_standards = requested->amiga != 0;
+    validate_ndk_standards = requested->ndk != 0;
+    validate_c89_standards = 1;
+    validate_c99_standards = requested->c99 != 0;
+    validate_sasc_standards = requested->sasc != 0;
+    validate_vbcc_standards = requested->vbcc != 0;
+    validate_dice_standards = requested->dice != 0;
+    validate_memsafe_standards = requested->memsafe != 0;
+
+    /* If the user explicitly asked for C99, disable the default C89 checks unless
+       the user also explicitly requested C89 or selected a mode that implies C89. */
+    if (requested->c99 &&
+        !requested->c89 &&
+        !requested->sasc &&
+        !requested->dice &&
+        !requested->memsafe) {
+        validate_c89_standards = 0;
+    }
+
+    /* Implement mode dependencies with warnings for conflicts */
+    if (validate_sasc_standards) {
+        if (validate_c99_standards) {
+            if (!quiet_mode) Printf("Warning: SAS/C mode overrides C99 mode (SAS/C is C89-only)\n");
+        }
+        validate_c89_standards = 1;  /* SASC implies C89 */
+        validate_c99_standards = 0;  /* SASC does NOT imply C99 */
+        enforce_compiler_compatibility = 1;  /* SASC enables compiler compatibility checking */
+    }
+    if (validate_vbcc_standards) {
+        if (validate_c89_standards) {
+            if (!quiet_mode) Printf("Warning: VBCC mode overrides C89 mode (VBCC supports C99)\n");
+        }
+        validate_c99_standards = 1;  /* VBCC implies C99 */
+        validate_c89_standards = 0;  /* VBCC does NOT imply C89 */
+        enforce_compiler_compatibility = 1;  /* VBCC enables compiler compatibility checking */
+    }
+    if (validate_amiga_standards) {
+        if (!validate_ndk_standards) {
+            if (!quiet_mode) Printf("Info: Amiga mode enables NDK validation\n");
+        }
+        validate_ndk_standards = 1;  /* AMIGA implies NDK */
+        enforce_amiga_pascalcase = 1;  /* AMIGA enables PascalCase enforcement */
+        enforce_compiler_compatibility = 1;  /* AMIGA enables compiler compatibility checking */
+    }
+    if (validate_dice_standards) {
+        if (!validate_c89_standards) {
+            if (!quiet_mode) Printf("Info: DICE mode enables C89 validation\n");
+        }
+        if (!validate_ndk_standards) {
+            if (!quiet_mode) Printf("Info: DICE mode enables NDK validation\n");
+        }
+        validate_c89_standards = 1;  /* DICE implies C89 for now */
+        validate_ndk_standards = 1;  /* DICE implies NDK */
+        enforce_compiler_compatibility = 1;  /* DICE enables compiler compatibility checking */
+    }
+    if (validate_ndk_standards) {
+        enforce_compiler_compatibility = 1;  /* NDK enables compiler compatibility checking */
+    }
+    if (validate_memsafe_standards) {
+        if (!validate_c89_standards) {
+            if (!quiet_mode) Printf("Info: MEMSAFE mode enables C89 validation\n");
+        }
+        validate_c89_standards = 1;  /* MEMSAFE implies C89 */
+    }
     
+    /* Ensure at least one standard is enabled - but don't override explicit mode choices */
+    if (!validate_c89_standards && !validate_c99_standards) {
+        /* Only default to C89 if no compiler mode was specified that would imply a standard */
+        if (!validate_sasc_standards && !validate_vbcc_standards && !validate_dice_standards) {
+            validate_c89_standards = 1;  /* Default to C89 if no specific mode specified */
+        }
+    }
+}
+
+/* Checks that need the whole file, run after its last line */
+static void finish_file(const char *filename, int line_count) {
+    current_rule = RULE_LEXER;
     if (parse_state.in_multiline_comment) {
-        add_error(filename, line_num, 1, ERROR_WARNING, "File ends with an unterminated '/*' comment.");
+        add_error(filename, line_count, 1, ERROR_WARNING, "File ends with an unterminated '/*' comment.");
     }
     
+    /* Setup calls in loops the file never closed */
+    current_rule = RULE_LOOPS;
+    loop_report_calls(0);
+    
     /* Validate Forbid()/Permit() pairs at end of file */
+    current_rule = RULE_FORBID_PERMIT;
     validate_forbid_permit_pairs(filename);
-    
-    return 0;
 }
 
-static void print_errors(void) {
+/* Puts each file's issues in line order.  Most are found in order; those
+   found when a loop or function ends go back to their own lines.  A line
+   keeps its issues in the order its rules reported them */
+static void errors_sort(void) {
+    static LintError moving; /* Too large for the stack budget */
+    int count = error_count < MAX_ERRORS ? error_count : MAX_ERRORS;
     int i;
-    const char *type_names[] = {"SYNTAX", "STYLE", "WARNING", "COMPILER", "COMMENT"};
+    int j;
+
+    for (i = 1; i < count; i++) {
+        for (j = i; j > 0 && errors[j - 1].line_number > errors[i].line_number; j--) {
+            if (strcmp(errors[j - 1].filename, errors[i].filename) != 0) break;
+        }
+        if (j < i) {
+            moving = errors[i];
+            memmove(&errors[j + 1], &errors[j], (size_t)(i - j) * sizeof(LintError));
+            errors[j] = moving;
+        }
+    }
+}
 
+static void print_errors(void) {
     if (!quiet_mode) Printf("\n--- Detailed Error Report ---\n");
+    print_error_list();
+}
+
+static void print_error_list(void) {
+    int i;
+
+    errors_sort();
     for (i = 0; i < error_count && i < MAX_ERRORS; i++) {
         Printf("%s:%ld:%ld: [%s] %s\n",
                errors[i].filename,
-               errors[i].line_number,
-               errors[i].column,
-               type_names[errors[i].type],
+               (LONG)errors[i].line_number,
+               (LONG)errors[i].column,
+               error_type_names[errors[i].type],
                errors[i].message);
         
         /* Show line excerpt if available */
@@ -922,7 +2261,7 @@ static void print_usage(void) {
     }
 
     Printf("Codex - Amiga C Linter & Style Checker (%s)\n", version_string);
-    Printf("Usage: Codex FILES/M/A,AMIGA/S,NDK/S,C89/S,C99/S,SASC/S,VBCC/S,DICE/S,MEMSAFE/S,QUIET/S,HELP/S\n\n");
+    Printf("Usage: Codex FILES/M/A,AMIGA/S,NDK/S,C89/S,C99/S,SASC/S,VBCC/S,DICE/S,MEMSAFE/S,QUIET/S,HELP/S,MEMSTATS/S,ENGINE/K,METRICS/K,VERBOSE/S,LOWMEM/S,STACKCHECK/S\n\n");
 
     Printf("  C89/S         Check compliance with ANSI C89 standards (default).\n");
     Printf("  C99/S         Check compliance with C99 standards.\n");
@@ -933,7 +2272,21 @@ static void print_usage(void) {
     Printf("  VBCC/S        Check for VBCC compatibility. Implies C99/S.\n");
     Printf("  DICE/S        Check for DICE keyword compatibility. Implies C89/S & NDK/S.\n");
     Printf("  QUIET/S       Suppress summary and only output violation lines.\n");
-    Printf("  HELP/S        Display this help message.\n\n");
+    Printf("  HELP/S        Display this help message.\n");
+    Printf("  MEMSTATS/S    Print static footprint, heap use by subsystem and peak memory after the report.\n");
+    Printf("  ENGINE/K      Table lookup engine: FAST (indexed, default) or LEGACY (linear scan).\n");
+    Printf("  METRICS/K     Write run metrics in Prometheus text format to the given file.\n");
+    Printf("  VERBOSE/S     Print the cost of each file and where the run's time went.\n");
+    Printf("  LOWMEM/S      Use as little memory as possible: print issues after each file, keep no tables or buffers.\n");
+    Printf("  STACKCHECK/S  Estimate the worst-case stack depth from main() over all FILES and check it against $STACK.\n");
+#ifdef CODEX_PROFILE
+    Printf("  PROFILE/S     Print per-rule calls, hits, bytes and time after the report.\n");
+    Printf("  TRACE/K       Write a Chrome trace-event JSON timeline to the given file.\n");
+    Printf("  TRACESAMPLE/K/N  Trace every Nth line with stage and rule spans (default 64, 0 = files only).\n");
+    Printf("  PATSTATS/S    Print tested/matched/diagnosed counts for every table pattern.\n");
+    Printf("  COUNTERS/S    Print time, IPC and miss rates per stage (and per rule with PROFILE).\n");
+#endif
+    Printf("\n");
 
     Printf("--- Examples ---\n");
     Printf("  Codex main.c AMIGA\n");
@@ -948,6 +2301,258 @@ static void print_usage(void) {
     Printf("    -> Checks main.c for memory safety, printing only the errors.\n");
 }
 
+/* Allocates memory charged to a subsystem; free it with mem_free() */
+static APTR mem_alloc(ULONG size, ULONG flags, MemSubsystem subsystem) {
+    MemBlockHeader *header = AllocVec(sizeof(MemBlockHeader) + size, flags);
+
+    if (!header) return NULL;
+    header->size = size;
+    header->subsystem = (ULONG)subsystem;
+    mem_charge(subsystem, size);
+    return header + 1;
+}
+
+static void mem_free(APTR memory) {
+    MemBlockHeader *header;
+
+    if (!memory) return;
+    header = (MemBlockHeader *)memory - 1;
+    mem_discharge((MemSubsystem)header->subsystem, header->size);
+    FreeVec(header);
+}
+
+/* Counts a new heap block against a subsystem */
+static void mem_charge(MemSubsystem subsystem, ULONG size) {
+    MemCounter *counter = &mem_counters[subsystem];
+
+    counter->allocations++;
+    mem_blocks_allocated++;
+    counter->bytes += size;
+    counter->total_bytes += size;
+    if (counter->bytes > counter->peak_bytes) counter->peak_bytes = counter->bytes;
+    mem_heap_bytes += size;
+    if (mem_heap_bytes > mem_heap_peak) mem_heap_peak = mem_heap_bytes;
+    if (memstats_enabled) mem_sample();
+}
+
+static void mem_discharge(MemSubsystem subsystem, ULONG size) {
+    MemCounter *counter = &mem_counters[subsystem];
+
+    counter->frees++;
+    counter->bytes -= size;
+    mem_heap_bytes -= size;
+}
+
+/* Hands out size bytes, 8-byte aligned, until the next arena_reset() */
+static APTR arena_alloc(Arena *arena, ULONG size) {
+    ArenaChunk *chunk;
+    ULONG chunk_size;
+    APTR memory;
+
+    size = ARENA_ROUND(size);
+    /* Chunks kept from earlier files are used up before new ones are added */
+    while (arena->current && arena->used + size > arena->current->size) {
+        arena->current = arena->current->next;
+        arena->used = 0;
+    }
+    if (!arena->current) {
+        if (!arena->pool) {
+            arena->pool = CreatePool(MEMF_ANY, ARENA_PUDDLE_SIZE, ARENA_PUDDLE_SIZE);
+            if (!arena->pool) return NULL;
+        }
+        chunk_size = arena->last ? arena->last->size * 2 : ARENA_CHUNK_SIZE;
+        if (chunk_size < size) chunk_size = size;
+        chunk = AllocPooled(arena->pool, ARENA_HEADER_SIZE + chunk_size);
+        if (!chunk) return NULL;
+        chunk->next = NULL;
+        chunk->size = chunk_size;
+        if (arena->last) arena->last->next = chunk;
+        else arena->chunks = chunk;
+        arena->last = chunk;
+        arena->current = chunk;
+        arena->used = 0;
+        mem_charge(arena->subsystem, ARENA_HEADER_SIZE + chunk_size);
+    }
+    memory = (char *)arena->current + ARENA_HEADER_SIZE + arena->used;
+    arena->used += size;
+    return memory;
+}
+
+/* Takes back everything handed out; the chunks stay for reuse */
+static void arena_reset(Arena *arena) {
+    arena->current = arena->chunks;
+    arena->used = 0;
+}
+
+static void arena_close(Arena *arena) {
+    ArenaChunk *chunk;
+
+    for (chunk = arena->chunks; chunk; chunk = chunk->next) {
+        mem_discharge(arena->subsystem, ARENA_HEADER_SIZE + chunk->size);
+    }
+    if (arena->pool) DeletePool(arena->pool); /* Frees every chunk at once */
+    arena->pool = NULL;
+    arena->chunks = NULL;
+    arena->last = NULL;
+    arena->current = NULL;
+    arena->used = 0;
+}
+
+/* Tracks the lowest system free memory seen; AvailMem() is too slow for every line */
+static void mem_sample(void) {
+    ULONG available = AvailMem(MEMF_ANY);
+
+    if (available < mem_free_lowest) mem_free_lowest = available;
+}
+
+/* Prints the MEMSTATS/S report */
+static void print_memory_stats(void) {
+    ULONG static_bytes[MEM_SUBSYSTEM_COUNT];
+    ULONG static_total = 0;
+    int i;
+
+    /* Fixed buffers and tables by owner; the read buffers come from file_arena */
+    static_bytes[MEM_INPUT] = sizeof(line_context);
+    static_bytes[MEM_TOKENS] = 0;
+    static_bytes[MEM_DIAGNOSTICS] = 0; /* The issue list is on the heap, see errors_reserve() */
+    static_bytes[MEM_STATE] = sizeof(parse_state) + sizeof(file_arena) + sizeof(stack_scan) + sizeof(stack_arena);
+    static_bytes[MEM_CACHES] = sizeof(pattern_tables);
+    static_bytes[MEM_INSTRUMENTATION] = sizeof(mem_counters);
+#ifdef CODEX_PROFILE
+    static_bytes[MEM_INSTRUMENTATION] += sizeof(profile_counters) + sizeof(pattern_tables) + sizeof(pattern_pending);
+#endif
+
+    mem_sample();
+    Printf("\n--- Memory Statistics ---\n");
+    Printf("%-16s %10s %8s %8s %10s %10s\n", "Subsystem", "Static", "Allocs", "Frees", "Peak heap", "Total heap");
+    for (i = 0; i < MEM_SUBSYSTEM_COUNT; i++) {
+        Printf("%-16s %10ld %8ld %8ld %10ld %10ld\n", mem_subsystem_names[i], (LONG)static_bytes[i],
+               (LONG)mem_counters[i].allocations, (LONG)mem_counters[i].frees,
+               (LONG)mem_counters[i].peak_bytes, (LONG)mem_counters[i].total_bytes);
+        static_total += static_bytes[i];
+    }
+    Printf("Static footprint: %ld bytes\n", (LONG)static_total);
+    Printf("Heap: %ld bytes at peak, %ld allocations, %ld bytes still allocated\n",
+           (LONG)mem_heap_peak, (LONG)mem_blocks_allocated, (LONG)mem_heap_bytes);
+    Printf("System free memory: %ld bytes at start, %ld lowest (%ld bytes used at peak)\n",
+           (LONG)mem_free_at_start, (LONG)mem_free_lowest, (LONG)(mem_free_at_start - mem_free_lowest));
+}
+
+/* Maps an ENGINE/K value to its engine, ignoring case */
+static int engine_by_name(const char *name, EngineId *engine) {
+    static const char *engine_names[] = { "LEGACY", "FAST" };
+    int i;
+
+    for (i = 0; i < (int)(sizeof(engine_names) / sizeof(engine_names[0])); i++) {
+        const char *a = name;
+        const char *b = engine_names[i];
+        while (*a && toupper((unsigned char)*a) == *b) {
+            a++;
+            b++;
+        }
+        if (!*a && !*b) {
+            *engine = (EngineId)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Builds the first-character index of every table and turns the FAST engine on */
+static int engine_open(void) {
+    ULONG total = 0;
+    UWORD *order;
+    UWORD *lengths;
+    int t;
+
+    for (t = 0; t < PATTERN_TABLE_COUNT; t++) total += (ULONG)pattern_tables[t].count;
+    pattern_indexes = mem_alloc(PATTERN_TABLE_COUNT * sizeof(PatternIndex) + 2 * total * sizeof(UWORD),
+                                MEMF_ANY | MEMF_CLEAR, MEM_CACHES);
+    if (!pattern_indexes) return 0;
+    order = (UWORD *)(pattern_indexes + PATTERN_TABLE_COUNT);
+    lengths = order + total;
+
+    for (t = 0; t < PATTERN_TABLE_COUNT; t++) {
+        const PatternTable *table = &pattern_tables[t];
+        PatternIndex *index = &pattern_indexes[t];
+        UWORD next[FIRST_CHAR_SLOTS];
+        int starts = 0;
+        int c;
+        int i;
+
+        index->order = order;
+        index->lengths = lengths;
+        /* Counting sort by first character; stable, so table order survives */
+        for (i = 0; i < table->count; i++) {
+            index->first[(UBYTE)table->patterns[i][0] + 1]++;
+            lengths[i] = (UWORD)strlen(table->patterns[i]);
+        }
+        for (c = 1; c < FIRST_CHAR_SLOTS; c++) {
+            if (c < FIRST_CHAR_SLOTS - 1 && index->first[c + 1] > index->first[c]) index->starts[starts++] = (char)c;
+            index->first[c] += index->first[c - 1];
+        }
+        index->starts[starts] = '\0';
+        memcpy(next, index->first, sizeof(next));
+        for (i = 0; i < table->count; i++) order[next[(UBYTE)table->patterns[i][0]]++] = (UWORD)i;
+
+        order += table->count;
+        lengths += table->count;
+    }
+    fast_engine = 1;
+    return 1;
+}
+
+static void engine_close(void) {
+    fast_engine = 0;
+    if (pattern_indexes) {
+        mem_free(pattern_indexes);
+        pattern_indexes = NULL;
+    }
+}
+
+/* FAST engine: entry equal to word, or -1; same answer as the strcmp() scan */
+static int pattern_lookup(PatternTableId table, const char *word) {
+    const PatternIndex *index = &pattern_indexes[table];
+    const char **patterns = pattern_tables[table].patterns;
+    UBYTE c = (UBYTE)*word;
+    int k;
+
+    index_probes++;
+    if (index->first[c] == index->first[c + 1]) return -1;
+    index_bucket_scans++;
+    for (k = index->first[c]; k < index->first[c + 1]; k++) {
+        if (strcmp(word, patterns[index->order[k]]) == 0) return index->order[k];
+    }
+    return -1;
+}
+
+/* FAST engine: an entry occurring in text, or -1; found if and only if the
+   strstr() scan would find one.  One pass over text instead of one per entry;
+   strpbrk() skips to the characters that start an entry, and the second
+   character is checked before calling strncmp() */
+static int pattern_search(PatternTableId table, const char *text) {
+    const PatternIndex *index = &pattern_indexes[table];
+    const char **patterns = pattern_tables[table].patterns;
+    const char *p;
+    int k;
+
+    if (index->first[1] > index->first[0]) return index->order[0]; /* An empty entry matches anything */
+    for (p = strpbrk(text, index->starts); p; p = strpbrk(p + 1, index->starts)) {
+        UBYTE c = (UBYTE)*p;
+        index_bucket_scans++;
+        for (k = index->first[c]; k < index->first[c + 1]; k++) {
+            int i = index->order[k];
+            if (p[1] != patterns[i][1] && patterns[i][1]) continue;
+            if (strncmp(p, patterns[i], index->lengths[i]) == 0) {
+                index_probes += (ULONG)(p - text) + 1;
+                return i;
+            }
+        }
+    }
+    index_probes += (ULONG)strlen(text);
+    return -1;
+}
+
 /* Helper to find the first non-whitespace character in a string */
 static char* find_first_non_whitespace(char *str) {
     while (*str && isspace((unsigned char)*str)) {
@@ -1011,24 +2616,27 @@ static char* find_first_non_whitespace(char *str) {
 
 /* Check for Amiga coding standards compliance */
 static void check_amiga_standards(const char *line, int line_num, const char *filename, const char *original_line) {
-    char line_copy[MAX_LINE_LENGTH];
+    char *line_copy = line_context.words;
     char *token;
     char *paren_pos;
+    char first_word[MAX_KEYWORD_LENGTH];
+    size_t word_len = 0;
     
     /* Initialize line_copy for use throughout the function */
-    strncpy(line_copy, line, sizeof(line_copy) - 1);
-    line_copy[sizeof(line_copy) - 1] = '\0';
+    copy_line(line_copy, line);
     
     /* Check for standard C types that should use Amiga types */
-    /* Use more specific patterns to avoid false positives in strings/comments */
+    /* Use more specific patterns to avoid false positives in strings/comments.
+       The unsigned forms are left to the check after these, which names UWORD
+       and ULONG rather than the signed WORD and LONG */
     if ((strstr(line, "char *") && !strstr(line, "\"char *")) || 
         (strstr(line, "char*") && !strstr(line, "\"char*"))) {
         add_error_with_excerpt(filename, line_num, 1, ERROR_WARNING, 
                  "Use Amiga types (UBYTE* or STRPTR) instead of char*", original_line);
     }
     
-    if ((strstr(line, "long ") && !strstr(line, "\"long ")) || 
-        (strstr(line, "long\t") && !strstr(line, "\"long\t"))) {
+    if (((strstr(line, "long ") && !strstr(line, "\"long ")) || 
+         (strstr(line, "long\t") && !strstr(line, "\"long\t"))) && !strstr(line, "unsigned long")) {
         add_error_with_excerpt(filename, line_num, 1, ERROR_WARNING, 
                  "Use Amiga types (LONG) instead of long", original_line);
     }
@@ -1039,8 +2647,8 @@ static void check_amiga_standards(const char *line, int line_num, const char *fi
                  "Use Amiga types (ULONG) instead of int", original_line);
     }
     
-    if ((strstr(line, "short ") && !strstr(line, "\"short ")) || 
-        (strstr(line, "short\t") && !strstr(line, "\"short\t"))) {
+    if (((strstr(line, "short ") && !strstr(line, "\"short ")) || 
+         (strstr(line, "short\t") && !strstr(line, "\"short\t"))) && !strstr(line, "unsigned short")) {
         add_error_with_excerpt(filename, line_num, 1, ERROR_WARNING, 
                  "Use Amiga types (WORD) instead of short", original_line);
     }
@@ -1053,49 +2661,50 @@ static void check_amiga_standards(const char *line, int line_num, const char *fi
                  "Use Amiga primitive types (ULONG, UBYTE, UWORD) instead of standard C types", original_line);
     }
     
-    /* Check for deprecated Amiga types with warnings */
-    if (strstr(line, "USHORT") || strstr(line, "ushort")) {
+    /* Check for deprecated Amiga types with warnings.  They are typedefs, so
+       only the whole upper-case name counts, not "counter" or "my_ushort" */
+    if (line_has_identifier(line, "USHORT")) {
         add_error_with_excerpt(filename, line_num, 1, ERROR_WARNING, 
                  "USHORT is deprecated - use UWORD instead", original_line);
     }
     
-    if (strstr(line, "SHORT") || strstr(line, "short")) {
+    if (line_has_identifier(line, "SHORT")) {
         add_error_with_excerpt(filename, line_num, 1, ERROR_WARNING, 
                  "SHORT is deprecated - use WORD instead", original_line);
     }
     
-    if (strstr(line, "COUNT") || strstr(line, "count")) {
+    if (line_has_identifier(line, "COUNT")) {
         add_error_with_excerpt(filename, line_num, 1, ERROR_WARNING, 
                  "COUNT is deprecated - use WORD instead", original_line);
     }
     
-    if (strstr(line, "UCOUNT") || strstr(line, "ucount")) {
+    if (line_has_identifier(line, "UCOUNT")) {
         add_error_with_excerpt(filename, line_num, 1, ERROR_WARNING, 
                  "UCOUNT is deprecated - use UWORD instead", original_line);
     }
     
-    if (strstr(line, "CPTR") || strstr(line, "cptr")) {
+    if (line_has_identifier(line, "CPTR")) {
         add_error_with_excerpt(filename, line_num, 1, ERROR_WARNING, 
                  "CPTR is deprecated - use ULONG instead", original_line);
     }
     
     /* Check for other deprecated or problematic types */
-    if (strstr(line, "LONGBITS") || strstr(line, "longbits")) {
+    if (line_has_identifier(line, "LONGBITS")) {
         add_error_with_excerpt(filename, line_num, 1, ERROR_WARNING, 
                  "LONGBITS is for bit manipulation - consider if you really need this", original_line);
     }
     
-    if (strstr(line, "WORDBITS") || strstr(line, "wordbits")) {
+    if (line_has_identifier(line, "WORDBITS")) {
         add_error_with_excerpt(filename, line_num, 1, ERROR_WARNING, 
                  "WORDBITS is for bit manipulation - consider if you really need this", original_line);
     }
     
-    if (strstr(line, "BYTEBITS") || strstr(line, "bytebits")) {
+    if (line_has_identifier(line, "BYTEBITS")) {
         add_error_with_excerpt(filename, line_num, 1, ERROR_WARNING, 
                  "BYTEBITS is for bit manipulation - consider if you really need this", original_line);
     }
     
-    if (strstr(line, "RPTR") || strstr(line, "rptr")) {
+    if (line_has_identifier(line, "RPTR")) {
         add_error_with_excerpt(filename, line_num, 1, ERROR_WARNING, 
                  "RPTR is for relative pointers - consider if you really need this", original_line);
     }
@@ -1137,13 +2746,34 @@ static void check_amiga_standards(const char *line, int line_num, const char *fi
     /* Check for PascalCase function definitions (not stdlib functions) */
     token = strtok(line_copy, " \t\n\r");
     
+    /* A definition starts with a type word of its own, never with "}", a call
+       such as "CopyMem(a," or a keyword such as if or while */
     if (token) {
+        while (word_len < sizeof(first_word) - 1 && (isalnum((unsigned char)token[word_len]) || token[word_len] == '_')) {
+            first_word[word_len] = token[word_len];
+            word_len++;
+        }
+        first_word[word_len] = '\0';
+    }
+    
+    if (token && word_len > 0 && token[word_len] == '\0' && !is_statement_keyword(first_word)) {
         /* Check if this looks like a function definition */
         paren_pos = strchr(line, '(');
         
-        if (paren_pos) {
-            /* This looks like a function definition - get the function name (next token) */
-            char *func_name = strtok(NULL, " \t\n\r*(");
+        /* An '=' before the '(' makes it an initializer, as in "int count = Count();" */
+        if (paren_pos && !memchr(line, '=', (size_t)(paren_pos - line))) {
+            /* This looks like a function definition - the function name is the word before the '(' */
+            size_t name_end = (size_t)(paren_pos - line);
+            size_t name_start;
+            char *func_name = NULL;
+
+            while (name_end > word_len && (line[name_end - 1] == ' ' || line[name_end - 1] == '\t')) name_end--;
+            name_start = name_end;
+            while (name_start > word_len && (isalnum((unsigned char)line[name_start - 1]) || line[name_start - 1] == '_')) name_start--;
+            if (name_start < name_end && name_end < MAX_LINE_LENGTH) {
+                line_copy[name_end] = '\0';
+                func_name = line_copy + name_start;
+            }
             if (func_name) {
                 /* Only check PascalCase for non-stdlib and non-Amiga functions */
                 if (!is_stdlib_function(func_name) && !is_amiga_function(func_name) && islower((unsigned char)func_name[0])) {
@@ -1169,11 +2799,10 @@ static void check_amiga_standards(const char *line, int line_num, const char *fi
 
 /* Check for NDK compiler-specific.h reserved words */
 static void check_ndk_standards(const char *line, int line_num, const char *filename, const char *original_line) {
-    char line_copy[MAX_LINE_LENGTH];
+    char *line_copy = line_context.words;
     char *token;
     
-    strncpy(line_copy, line, sizeof(line_copy) - 1);
-    line_copy[sizeof(line_copy) - 1] = '\0';
+    copy_line(line_copy, line);
     
     token = strtok(line_copy, " \t\n\r");
     
@@ -1195,9 +2824,10 @@ static void check_c89_standards(const char *line, int line_num, const char *file
     const char *p;
     const char *init_start;
     const char *init_end;
-    size_t init_len;
-    char init_buf[256];
-    char *init_token;
+    const char *next_semicolon = line; /* Cached forward searches, NULL once exhausted */
+    const char *next_paren = line;
+    size_t word_len;
+    char init_word[MAX_KEYWORD_LENGTH];
     
     /* Check for C++ comments - but skip if SAS/C mode is active (SAS/C supports them) */
     if (strstr(line, "//") && !validate_sasc_standards) {
@@ -1231,19 +2861,25 @@ static void check_c89_standards(const char *line, int line_num, const char *file
             while (*p == ' ' || *p == '\t') p++;
             if (*p == '(') {
                 init_start = p + 1;
-                init_end = strchr(init_start, ';');
-                if (!init_end) init_end = strchr(init_start, ')');
+                /* Only search again once a cached hit falls behind, so a line
+                   full of "for (" tokens is still scanned in linear time */
+                if (next_semicolon && next_semicolon < init_start) next_semicolon = strchr(init_start, ';');
+                if (next_paren && next_paren < init_start) next_paren = strchr(init_start, ')');
+                init_end = next_semicolon ? next_semicolon : next_paren;
                 if (init_end && init_end > init_start) {
-                    init_len = (size_t)(init_end - init_start);
-                    if (init_len >= sizeof(init_buf)) init_len = sizeof(init_buf) - 1;
-                    strncpy(init_buf, init_start, init_len);
-                    init_buf[init_len] = '\0';
-
-                    init_token = strtok(init_buf, " \t\n\r*();,");
-                    if (init_token && is_declaration_keyword(init_token)) {
-                        add_error(filename, line_num, 1, ERROR_SYNTAX,
-                                 "Variable declaration in for loop not allowed in C89");
-                        break;
+                    /* Only the first word of the initializer matters; find it in
+                       place and copy it only if it is short enough to be a keyword */
+                    while (init_start < init_end && strchr(FOR_INIT_DELIMITERS, *init_start)) init_start++;
+                    word_len = 0;
+                    while (init_start + word_len < init_end && !strchr(FOR_INIT_DELIMITERS, init_start[word_len])) word_len++;
+                    if (word_len > 0 && word_len < sizeof(init_word)) {
+                        memcpy(init_word, init_start, word_len);
+                        init_word[word_len] = '\0';
+                        if (is_declaration_keyword(init_word)) {
+                            add_error(filename, line_num, 1, ERROR_SYNTAX,
+                                     "Variable declaration in for loop not allowed in C89");
+                            break;
+                        }
                     }
                 }
             }
@@ -1345,28 +2981,27 @@ static void check_c99_standards(const char *line, int line_num, const char *file
 
 /* Check for SAS/C compliance */
 static void check_sasc_standards(const char *line, int line_num, const char *filename, const char *original_line) {
-    char line_copy[MAX_LINE_LENGTH];
+    char *line_copy = line_context.words;
     char *token;
     
-    strncpy(line_copy, line, sizeof(line_copy) - 1);
-    line_copy[sizeof(line_copy) - 1] = '\0';
+    copy_line(line_copy, line);
     
     token = strtok(line_copy, " \t\n\r*();,");
     
     while (token) {
         if (is_sasc_keyword(token)) {
             char replacement[REPLACEMENT_BUFFER_SIZE];
-            char message[256];
+            char *message = line_context.message;
             if (find_universal_replacement(token, replacement, sizeof(replacement)) && strcmp(replacement, "(none)") != 0) {
-                strncpy(message, "Keyword '", sizeof(message) - 1);
-                strncat(message, token, sizeof(message) - strlen(message) - 1);
-                strncat(message, "' is incompatible with SAS/C. Use universal syntax '", sizeof(message) - strlen(message) - 1);
-                strncat(message, replacement, sizeof(message) - strlen(message) - 1);
-                strncat(message, "' instead.", sizeof(message) - strlen(message) - 1);
+                strncpy(message, "Keyword '", MESSAGE_BUFFER_SIZE - 1);
+                strncat(message, token, MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                strncat(message, "' is incompatible with SAS/C. Use universal syntax '", MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                strncat(message, replacement, MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                strncat(message, "' instead.", MESSAGE_BUFFER_SIZE - strlen(message) - 1);
             } else {
-                strncpy(message, "Keyword '", sizeof(message) - 1);
-                strncat(message, token, sizeof(message) - strlen(message) - 1);
-                strncat(message, "' is incompatible with SAS/C and has no direct universal equivalent.", sizeof(message) - strlen(message) - 1);
+                strncpy(message, "Keyword '", MESSAGE_BUFFER_SIZE - 1);
+                strncat(message, token, MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                strncat(message, "' is incompatible with SAS/C and has no direct universal equivalent.", MESSAGE_BUFFER_SIZE - strlen(message) - 1);
             }
             add_error(filename, line_num, 1, ERROR_COMPILER, message);
             return;
@@ -1377,28 +3012,27 @@ static void check_sasc_standards(const char *line, int line_num, const char *fil
 
 /* Check for VBCC compliance */
 static void check_vbcc_standards(const char *line, int line_num, const char *filename, const char *original_line) {
-    char line_copy[MAX_LINE_LENGTH];
+    char *line_copy = line_context.words;
     char *token;
 
-    strncpy(line_copy, line, sizeof(line_copy) - 1);
-    line_copy[sizeof(line_copy) - 1] = '\0';
+    copy_line(line_copy, line);
 
     token = strtok(line_copy, " \t\n\r*();,");
 
     while (token) {
         if (is_vbcc_keyword(token)) {
             char replacement[REPLACEMENT_BUFFER_SIZE];
-            char message[256];
+            char *message = line_context.message;
             if (find_universal_replacement(token, replacement, sizeof(replacement)) && strcmp(replacement, "(none)") != 0) {
-                strncpy(message, "Keyword '", sizeof(message) - 1);
-                strncat(message, token, sizeof(message) - strlen(message) - 1);
-                strncat(message, "' is incompatible with VBCC. Use universal syntax '", sizeof(message) - strlen(message) - 1);
-                strncat(message, replacement, sizeof(message) - strlen(message) - 1);
-                strncat(message, "' instead.", sizeof(message) - strlen(message) - 1);
+                strncpy(message, "Keyword '", MESSAGE_BUFFER_SIZE - 1);
+                strncat(message, token, MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                strncat(message, "' is incompatible with VBCC. Use universal syntax '", MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                strncat(message, replacement, MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                strncat(message, "' instead.", MESSAGE_BUFFER_SIZE - strlen(message) - 1);
             } else {
-                strncpy(message, "Keyword '", sizeof(message) - 1);
-                strncat(message, token, sizeof(message) - strlen(message) - 1);
-                strncat(message, "' is incompatible with VBCC and has no direct universal equivalent.", sizeof(message) - strlen(message) - 1);
+                strncpy(message, "Keyword '", MESSAGE_BUFFER_SIZE - 1);
+                strncat(message, token, MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                strncat(message, "' is incompatible with VBCC and has no direct universal equivalent.", MESSAGE_BUFFER_SIZE - strlen(message) - 1);
             }
             add_error(filename, line_num, 1, ERROR_COMPILER, message);
             return;
@@ -1411,9 +3045,13 @@ static void check_vbcc_standards(const char *line, int line_num, const char *fil
 static int is_ndk_reserved_word(const char *word) {
     int i;
     int num_words = sizeof(ndk_reserved_words) / sizeof(ndk_reserved_words[0]);
+
+    if (fast_engine) return pattern_lookup(PATTERNS_NDK_RESERVED, word) >= 0;
     
     for (i = 0; i < num_words; i++) {
+        PATTERN_TESTED(PATTERNS_NDK_RESERVED, i);
         if (strcmp(word, ndk_reserved_words[i]) == 0) {
+            PATTERN_MATCHED(PATTERNS_NDK_RESERVED, i);
             return 1;
         }
     }
@@ -1424,9 +3062,13 @@ static int is_ndk_reserved_word(const char *word) {
 static int is_c99_keyword(const char *word) {
     int i;
     int num_keywords = sizeof(c99_keywords) / sizeof(c99_keywords[0]);
+
+    if (fast_engine) return pattern_search(PATTERNS_C99_KEYWORDS, word) >= 0;
     
     for (i = 0; i < num_keywords; i++) {
+        PATTERN_TESTED(PATTERNS_C99_KEYWORDS, i);
         if (strstr(word, c99_keywords[i])) {
+            PATTERN_MATCHED(PATTERNS_C99_KEYWORDS, i);
             return 1;
         }
     }
@@ -1439,15 +3081,20 @@ static int is_c99_feature(const char *line) {
     int num_features = sizeof(c99_features) / sizeof(c99_features[0]);
     
     for (i = 0; i < num_features; i++) {
+        PATTERN_TESTED(PATTERNS_C99_FEATURES, i);
         /* Avoid false positives: "..." is also used in C89 variadic functions. */
         if (strcmp(c99_features[i], "...") == 0) {
             if (strstr(line, "#define") && strstr(line, "...")) {
+                PATTERN_MATCHED(PATTERNS_C99_FEATURES, i);
                 return 1;
             }
             continue;
         }
 
-        if (strstr(line, c99_features[i])) return 1;
+        if (strstr(line, c99_features[i])) {
+            PATTERN_MATCHED(PATTERNS_C99_FEATURES, i);
+            return 1;
+        }
     }
     return 0;
 }
@@ -1456,9 +3103,13 @@ static int is_c99_feature(const char *line) {
 static int is_c99_designated_init(const char *line) {
     int i;
     int num_patterns = sizeof(c99_designated_init_patterns) / sizeof(c99_designated_init_patterns[0]);
+
+    if (fast_engine) return pattern_search(PATTERNS_C99_DESIGNATED_INIT, line) >= 0;
     
     for (i = 0; i < num_patterns; i++) {
+        PATTERN_TESTED(PATTERNS_C99_DESIGNATED_INIT, i);
         if (strstr(line, c99_designated_init_patterns[i])) {
+            PATTERN_MATCHED(PATTERNS_C99_DESIGNATED_INIT, i);
             return 1;
         }
     }
@@ -1501,9 +3152,13 @@ static int is_c99_variadic_macro(const char *line) {
 static int is_c99_flexible_array(const char *line) {
     int i;
     int num_patterns = sizeof(c99_flexible_array_patterns) / sizeof(c99_flexible_array_patterns[0]);
+
+    if (fast_engine) return pattern_search(PATTERNS_C99_FLEXIBLE_ARRAY, line) >= 0;
     
     for (i = 0; i < num_patterns; i++) {
+        PATTERN_TESTED(PATTERNS_C99_FLEXIBLE_ARRAY, i);
         if (strstr(line, c99_flexible_array_patterns[i])) {
+            PATTERN_MATCHED(PATTERNS_C99_FLEXIBLE_ARRAY, i);
             return 1;
         }
     }
@@ -1514,9 +3169,13 @@ static int is_c99_flexible_array(const char *line) {
 static int is_c99_stdlib_function(const char *line) {
     int i;
     int num_functions = sizeof(c99_stdlib_functions) / sizeof(c99_stdlib_functions[0]);
+
+    if (fast_engine) return pattern_search(PATTERNS_C99_STDLIB, line) >= 0;
     
     for (i = 0; i < num_functions; i++) {
+        PATTERN_TESTED(PATTERNS_C99_STDLIB, i);
         if (strstr(line, c99_stdlib_functions[i])) {
+            PATTERN_MATCHED(PATTERNS_C99_STDLIB, i);
             return 1;
         }
     }
@@ -1527,9 +3186,13 @@ static int is_c99_stdlib_function(const char *line) {
 static int is_c99_header_file(const char *line) {
     int i;
     int num_headers = sizeof(c99_header_files) / sizeof(c99_header_files[0]);
+
+    if (fast_engine) return pattern_search(PATTERNS_C99_HEADERS, line) >= 0;
     
     for (i = 0; i < num_headers; i++) {
+        PATTERN_TESTED(PATTERNS_C99_HEADERS, i);
         if (strstr(line, c99_header_files[i])) {
+            PATTERN_MATCHED(PATTERNS_C99_HEADERS, i);
             return 1;
         }
     }
@@ -1540,9 +3203,13 @@ static int is_c99_header_file(const char *line) {
 static int is_sasc_keyword(const char *word) {
     int i;
     int num_keywords = sizeof(sasc_keywords) / sizeof(sasc_keywords[0]);
+
+    if (fast_engine) return pattern_lookup(PATTERNS_SASC_KEYWORDS, word) >= 0;
     
     for (i = 0; i < num_keywords; i++) {
+        PATTERN_TESTED(PATTERNS_SASC_KEYWORDS, i);
         if (strcmp(word, sasc_keywords[i]) == 0) {
+            PATTERN_MATCHED(PATTERNS_SASC_KEYWORDS, i);
             return 1;
         }
     }
@@ -1553,9 +3220,13 @@ static int is_sasc_keyword(const char *word) {
 static int is_vbcc_keyword(const char *word) {
     int i;
     int num_keywords = sizeof(vbcc_keywords) / sizeof(vbcc_keywords[0]);
+
+    if (fast_engine) return pattern_lookup(PATTERNS_VBCC_KEYWORDS, word) >= 0;
     
     for (i = 0; i < num_keywords; i++) {
+        PATTERN_TESTED(PATTERNS_VBCC_KEYWORDS, i);
         if (strcmp(word, vbcc_keywords[i]) == 0) {
+            PATTERN_MATCHED(PATTERNS_VBCC_KEYWORDS, i);
             return 1;
         }
     }
@@ -1566,9 +3237,13 @@ static int is_vbcc_keyword(const char *word) {
 static int is_c89_header_file(const char *line) {
     int i;
     int num_headers = sizeof(c89_header_files) / sizeof(c89_header_files[0]);
+
+    if (fast_engine) return pattern_search(PATTERNS_C89_HEADERS, line) >= 0;
     
     for (i = 0; i < num_headers; i++) {
+        PATTERN_TESTED(PATTERNS_C89_HEADERS, i);
         if (strstr(line, c89_header_files[i])) {
+            PATTERN_MATCHED(PATTERNS_C89_HEADERS, i);
             return 1;
         }
     }
@@ -1579,28 +3254,27 @@ static int is_c89_header_file(const char *line) {
 static void check_dice_standards(const char *line, int line_num, const char *filename, const char *original_line) {
     /* DICE mode currently implements C89 + compiler keywords */
     /* This will be expanded for full DICE compiler compatibility */
-    char line_copy[MAX_LINE_LENGTH];
+    char *line_copy = line_context.words;
     char *token;
 
-    strncpy(line_copy, line, sizeof(line_copy) - 1);
-    line_copy[sizeof(line_copy) - 1] = '\0';
+    copy_line(line_copy, line);
 
     token = strtok(line_copy, " \t\n\r*();,");
 
     while (token) {
         if (is_ndk_reserved_word(token)) {
             char replacement[REPLACEMENT_BUFFER_SIZE];
-            char message[256];
+            char *message = line_context.message;
             if (find_universal_replacement(token, replacement, sizeof(replacement)) && strcmp(replacement, "(none)") != 0) {
-                strncpy(message, "Keyword '", sizeof(message) - 1);
-                strncat(message, token, sizeof(message) - strlen(message) - 1);
-                strncat(message, "' is DICE-incompatible. Use universal syntax '", sizeof(message) - strlen(message) - 1);
-                strncat(message, replacement, sizeof(message) - strlen(message) - 1);
-                strncat(message, "' instead.", sizeof(message) - strlen(message) - 1);
+                strncpy(message, "Keyword '", MESSAGE_BUFFER_SIZE - 1);
+                strncat(message, token, MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                strncat(message, "' is DICE-incompatible. Use universal syntax '", MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                strncat(message, replacement, MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                strncat(message, "' instead.", MESSAGE_BUFFER_SIZE - strlen(message) - 1);
             } else {
-                strncpy(message, "Keyword '", sizeof(message) - 1);
-                strncat(message, token, sizeof(message) - strlen(message) - 1);
-                strncat(message, "' is DICE-incompatible and has no direct universal equivalent.", sizeof(message) - strlen(message) - 1);
+                strncpy(message, "Keyword '", MESSAGE_BUFFER_SIZE - 1);
+                strncat(message, token, MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                strncat(message, "' is DICE-incompatible and has no direct universal equivalent.", MESSAGE_BUFFER_SIZE - strlen(message) - 1);
             }
             add_error(filename, line_num, 1, ERROR_COMPILER, message);
             return;
@@ -1611,37 +3285,36 @@ static void check_dice_standards(const char *line, int line_num, const char *fil
 
 /* Check for memory safety issues */
 static void check_memsafe_standards(const char *line, int line_num, const char *filename, const char *original_line) {
-    char line_copy[MAX_LINE_LENGTH];
+    char *line_copy = line_context.words;
     char *token;
-    char replacement[256];
+    char replacement[REPLACEMENT_BUFFER_SIZE]; /* The longest replacement is 32 characters */
     
-    strncpy(line_copy, line, sizeof(line_copy) - 1);
-    line_copy[sizeof(line_copy) - 1] = '\0';
+    copy_line(line_copy, line);
     
     token = strtok(line_copy, " \t\n\r*();,");
     
     while (token) {
         if (is_memsafe_unsafe_function(token)) {
             if (find_memsafe_replacement(token, replacement, sizeof(replacement))) {
-                char message[LARGE_MESSAGE_BUFFER_SIZE];
+                char *message = line_context.message;
 
                 /* --- NEW: Add qualified guidance for specific functions --- */
                 if (strcmp(token, "realpath") == 0) {
-                    strncpy(message, "Unsafe use of 'realpath' suspected. Ensure the second argument is a valid buffer, not NULL.", sizeof(message) - 1);
+                    strncpy(message, "Unsafe use of 'realpath' suspected. Ensure the second argument is a valid buffer, not NULL.", LARGE_MESSAGE_BUFFER_SIZE - 1);
                 } else if (strcmp(token, "scanf") == 0 || strcmp(token, "sscanf") == 0) {
-                    strncpy(message, "Unsafe use of '", sizeof(message) - 1);
-                    strncat(message, token, sizeof(message) - strlen(message) - 1);
-                    strncat(message, "' suspected. Ensure format string uses width specifiers (e.g., '%10s') and check the return value.", sizeof(message) - strlen(message) - 1);
+                    strncpy(message, "Unsafe use of '", LARGE_MESSAGE_BUFFER_SIZE - 1);
+                    strncat(message, token, LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                    strncat(message, "' suspected. Ensure format string uses width specifiers (e.g., '%10s') and check the return value.", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
                 } else {
                     /* --- Fallback to the original generic message --- */
-                    strncpy(message, "Memory-unsafe function '", sizeof(message) - 1);
-                    strncat(message, token, sizeof(message) - strlen(message) - 1);
-                    strncat(message, "' found - consider using '", sizeof(message) - strlen(message) - 1);
-                    strncat(message, replacement, sizeof(message) - strlen(message) - 1);
-                    strncat(message, "' instead", sizeof(message) - strlen(message) - 1);
+                    strncpy(message, "Memory-unsafe function '", LARGE_MESSAGE_BUFFER_SIZE - 1);
+                    strncat(message, token, LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                    strncat(message, "' found - consider using '", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                    strncat(message, replacement, LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                    strncat(message, "' instead", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
                 }
                 
-                message[sizeof(message) - 1] = '\0'; /* Ensure null termination */
+                message[LARGE_MESSAGE_BUFFER_SIZE - 1] = '\0'; /* Ensure null termination */
                 add_error(filename, line_num, 1, ERROR_WARNING, message);
                 
                 return;
@@ -1655,9 +3328,13 @@ static void check_memsafe_standards(const char *line, int line_num, const char *
 static int is_memsafe_unsafe_function(const char *word) {
     int i;
     int num_functions = sizeof(memsafe_unsafe_functions) / sizeof(memsafe_unsafe_functions[0]);
+
+    if (fast_engine) return pattern_lookup(PATTERNS_MEMSAFE_UNSAFE, word) >= 0;
     
     for (i = 0; i < num_functions; i++) {
+        PATTERN_TESTED(PATTERNS_MEMSAFE_UNSAFE, i);
         if (strcmp(word, memsafe_unsafe_functions[i]) == 0) {
+            PATTERN_MATCHED(PATTERNS_MEMSAFE_UNSAFE, i);
             return 1;
         }
     }
@@ -1668,9 +3345,13 @@ static int is_memsafe_unsafe_function(const char *word) {
 static int is_stdlib_function(const char *word) {
     int i;
     int num_functions = sizeof(stdlib_functions) / sizeof(stdlib_functions[0]);
+
+    if (fast_engine) return pattern_lookup(PATTERNS_STDLIB, word) >= 0;
     
     for (i = 0; i < num_functions; i++) {
+        PATTERN_TESTED(PATTERNS_STDLIB, i);
         if (strcmp(word, stdlib_functions[i]) == 0) {
+            PATTERN_MATCHED(PATTERNS_STDLIB, i);
             return 1;
         }
     }
@@ -1681,20 +3362,70 @@ static int is_stdlib_function(const char *word) {
 static int is_amiga_function(const char *word) {
     int i;
     int num_functions = sizeof(amiga_functions) / sizeof(amiga_functions[0]);
+
+    if (fast_engine) return pattern_lookup(PATTERNS_AMIGA_FUNCTIONS, word) >= 0;
     
     for (i = 0; i < num_functions; i++) {
+        PATTERN_TESTED(PATTERNS_AMIGA_FUNCTIONS, i);
         if (strcmp(word, amiga_functions[i]) == 0) {
+            PATTERN_MATCHED(PATTERNS_AMIGA_FUNCTIONS, i);
             return 1;
         }
     }
     return 0;
 }
 
+/* Whether a function sets up or tears down a system resource, for the loop rules */
+static int is_loop_setup_function(const char *word) {
+    int i;
+    int num_functions = sizeof(loop_setup_functions) / sizeof(loop_setup_functions[0]);
+
+    if (fast_engine) return pattern_lookup(PATTERNS_LOOP_SETUP, word) >= 0;
+
+    for (i = 0; i < num_functions; i++) {
+        PATTERN_TESTED(PATTERNS_LOOP_SETUP, i);
+        if (strcmp(word, loop_setup_functions[i]) == 0) {
+            PATTERN_MATCHED(PATTERNS_LOOP_SETUP, i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Index of an unbuffered dos.library I/O function, or -1 */
+static int find_unbuffered_io(const char *word) {
+    return loop_table_lookup(PATTERNS_UNBUFFERED_IO, word);
+}
+
+/* Index of word in one of the loop rules' function tables, or -1 */
+static int loop_table_lookup(PatternTableId table, const char *word) {
+    const PatternTable *entry = &pattern_tables[table];
+    int i;
+
+    if (fast_engine) return pattern_lookup(table, word);
+
+    for (i = 0; i < entry->count; i++) {
+        PATTERN_TESTED(table, i);
+        if (strcmp(word, entry->patterns[i]) == 0) {
+            PATTERN_MATCHED(table, i);
+            return i;
+        }
+    }
+    return -1;
+}
+
 /* Helper function to find memory-safe replacement for unsafe function */
 static int find_memsafe_replacement(const char *function, char *replacement, size_t max_len) {
     int i;
     int num_functions = sizeof(memsafe_unsafe_functions) / sizeof(memsafe_unsafe_functions[0]);
     
+    if (fast_engine) {
+        i = pattern_lookup(PATTERNS_MEMSAFE_UNSAFE, function);
+        if (i < 0) return 0;
+        strncpy(replacement, memsafe_safe_replacements[i], max_len - 1);
+        replacement[max_len - 1] = '\0';
+        return 1;
+    }
     for (i = 0; i < num_functions; i++) {
         if (strcmp(function, memsafe_unsafe_functions[i]) == 0) {
             strncpy(replacement, memsafe_safe_replacements[i], max_len - 1);
@@ -1709,8 +3440,17 @@ static int find_memsafe_replacement(const char *function, char *replacement, siz
 static int find_universal_replacement(const char *keyword, char *replacement, size_t max_len) {
     int i;
     int num_keywords = sizeof(non_universal_keywords) / sizeof(non_universal_keywords[0]);
+    if (fast_engine) {
+        i = pattern_lookup(PATTERNS_NON_UNIVERSAL, keyword);
+        if (i < 0) return 0;
+        strncpy(replacement, universal_replacements[i], max_len - 1);
+        replacement[max_len - 1] = '\0';
+        return 1;
+    }
     for (i = 0; i < num_keywords; i++) {
+        PATTERN_TESTED(PATTERNS_NON_UNIVERSAL, i);
         if (strcmp(keyword, non_universal_keywords[i]) == 0) {
+            PATTERN_MATCHED(PATTERNS_NON_UNIVERSAL, i);
             strncpy(replacement, universal_replacements[i], max_len - 1);
             replacement[max_len - 1] = '\0';
             return 1;
@@ -1861,4 +3601,2286 @@ static void check_for_magic_numbers(const char *line, int line_num, const char *
         }
         p++;
     }
-}
\ No newline at end of file
+}
+
+/* ============================================================================ */
+/* LOOP SCOPES */
+/* ============================================================================ */
+
+/* for, while and do loops are followed through the lines with a brace count of
+   their own, so that a line that stopped at an earlier issue still moves them
+   along.  A call belongs to the innermost loop it runs in on every pass: its
+   body, the condition of a while, or the last two clauses of a for.  Each loop
+   also keeps the names it changes, to tell calls whose arguments change from
+   pass to pass from calls that repeat the same work, and whether it polls or
+   waits, to find busy-wait loops when it ends */
+
+static void check_loop_scopes(const char *line, int line_num, const char *filename, const char *original_line) {
+    const char *p = line;
+    size_t length = strlen(line);
+
+    while (*p == ' ' || *p == '\t') p++;
+    if (parse_state.loop_in_directive || *p == '#') {
+        parse_state.loop_in_directive = length > 0 && line[length - 1] == '\\';
+        return;
+    }
+    parse_state.loop_filename = filename;
+    while (*p) {
+        if (isalpha((unsigned char)*p) || *p == '_') {
+            p = loop_word(p, line, line_num, filename, original_line);
+        } else if (isdigit((unsigned char)*p)) {
+            loop_punctuation('0');
+            while (isalnum((unsigned char)*p) || *p == '.') p++;
+        } else if (p[0] == '-' && p[1] == '>') {
+            p += 2; /* Not a comparison */
+        } else {
+            loop_punctuation(*p);
+            p++;
+        }
+    }
+}
+
+/* The loop a call at the current position runs in on every pass, or NULL */
+static LoopScope *loop_innermost(void) {
+    int i;
+
+    for (i = parse_state.loop_count - 1; i >= 0; i--) {
+        LoopScope *loop = &parse_state.loops[i];
+        if (loop->phase != LOOP_HEADER) return loop;
+        if (loop->kind != LOOP_FOR || loop->header_part > 0) return loop; /* Not a for initializer */
+    }
+    return NULL;
+}
+
+/* A token has come after a loop header: the body is a single statement unless it was '{' */
+static void loop_statement_starts(void) {
+    LoopScope *loop;
+
+    if (parse_state.loop_count <= 0) return;
+    loop = &parse_state.loops[parse_state.loop_count - 1];
+    if (loop->phase == LOOP_PENDING) {
+        loop->phase = LOOP_STATEMENT;
+        loop->brace_depth = parse_state.loop_braces;
+    }
+}
+
+static void loop_push(LoopKind kind, LoopPhase phase, int line_num) {
+    LoopScope *loop;
+
+    loop_statement_starts(); /* A loop can be the body of another */
+    if (parse_state.loop_count >= MAX_LOOP_DEPTH) return; /* Calls still count for the loops around it */
+    loop = &parse_state.loops[parse_state.loop_count++];
+    loop->line = line_num;
+    loop->brace_depth = parse_state.loop_braces;
+    loop->kind = (UBYTE)kind;
+    loop->phase = (UBYTE)phase;
+    loop->header_parens = 0;
+    loop->header_part = 0;
+    loop->variable_count = 0;
+    loop->variables_lost = 0;
+    loop->compares = 0;
+    loop->compared_count = 0;
+    loop->stepped_count = 0;
+    loop->set_count = 0;
+    loop->counters_lost = 0;
+    loop->blocks = 0;
+    loop->poll = POLL_NONE;
+}
+
+/* The body of the innermost loop has ended; a do loop still has its condition to come */
+static void loop_pop(void) {
+    LoopScope *loop = &parse_state.loops[parse_state.loop_count - 1];
+
+    if (loop->kind == LOOP_DO && loop->phase != LOOP_HEADER) {
+        loop->phase = LOOP_TAIL;
+        return;
+    }
+    loop_finish();
+}
+
+/* Ends the innermost loop.  One that polls but never waits is a busy wait,
+   unless it only counts its way through or drains a port.  What the loop
+   changed, waited for or polled without an issue carries over to the loop
+   around it */
+static void loop_finish(void) {
+    LoopScope *loop = &parse_state.loops[--parse_state.loop_count];
+    LoopScope *outer;
+    char *message = line_context.message;
+    int i;
+
+    loop_report_calls(parse_state.loop_count); /* Now that all the loop changes is known */
+    if (loop->poll != POLL_NONE && !loop->blocks &&
+        (loop->poll == POLL_CONDITION || (loop->poll == POLL_BODY && !loop_counts(loop)))) {
+        strncpy(message, "The loop at line ", LARGE_MESSAGE_BUFFER_SIZE - 1);
+        message[LARGE_MESSAGE_BUFFER_SIZE - 1] = '\0';
+        append_number(message, (LONG)loop->line);
+        strncat(message, " polls ", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+        strncat(message, loop->poll_name, LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+        strncat(message, " without waiting; it busy-waits and takes the CPU from every other task. "
+                "Wait for a signal with Wait(), WaitPort() or WaitIO() instead.",
+                LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+        add_error_with_excerpt(parse_state.loop_filename, loop->poll_line, loop->poll_column, ERROR_WARNING, message,
+                               loop->poll_excerpt);
+        loop->poll = POLL_NONE; /* Reported once, not again for the loops around it */
+    }
+    if (parse_state.loop_count == 0) return;
+
+    outer = &parse_state.loops[parse_state.loop_count - 1];
+    for (i = 0; i < loop->variable_count; i++) loop_add_variable(outer, loop->variables[i]);
+    if (loop->variables_lost) outer->variables_lost = 1;
+    for (i = 0; i < loop->stepped_count; i++) loop_add_name(outer, outer->stepped, &outer->stepped_count, loop->stepped[i]);
+    for (i = 0; i < loop->set_count; i++) loop_add_name(outer, outer->set, &outer->set_count, loop->set[i]);
+    if (loop->counters_lost) outer->counters_lost = 1;
+    if (loop->blocks) {
+        outer->blocks = 1;
+    } else if (loop->poll != POLL_NONE && outer->poll == POLL_NONE) {
+        outer->poll = POLL_BODY;
+        outer->poll_line = loop->poll_line;
+        outer->poll_column = loop->poll_column;
+        strcpy(outer->poll_name, loop->poll_name);
+        strcpy(outer->poll_excerpt, loop->poll_excerpt);
+    }
+}
+
+/* Notes the first poll of a loop: a call, or a read of the chips' registers or a message list */
+static void loop_poll(LoopScope *loop, const char *name, const char *suffix, int negated, int column, int line_num, const char *original_line) {
+    if (loop->poll != POLL_NONE) return;
+    if (loop->phase != LOOP_HEADER) {
+        loop->poll = POLL_BODY;
+    } else if (strcmp(name, "GetMsg") == 0 && !negated) {
+        loop->poll = POLL_DRAIN;
+    } else {
+        loop->poll = POLL_CONDITION;
+    }
+    loop->poll_line = line_num;
+    loop->poll_column = column;
+    strncpy(loop->poll_name, name, LOOP_VARIABLE_LENGTH - 1);
+    loop->poll_name[LOOP_VARIABLE_LENGTH - 1] = '\0';
+    strncat(loop->poll_name, suffix, LOOP_VARIABLE_LENGTH - strlen(loop->poll_name) - 1);
+    loop_copy_excerpt(loop->poll_excerpt, original_line);
+}
+
+/* A statement has ended: so have the single-statement loop bodies it finished */
+static void loop_end_statements(void) {
+    while (parse_state.loop_count > 0) {
+        LoopScope *loop = &parse_state.loops[parse_state.loop_count - 1];
+        if (loop->phase != LOOP_STATEMENT || loop->brace_depth != parse_state.loop_braces) break;
+        loop_pop();
+    }
+}
+
+/* Moves the loops along over one character that is not part of a word */
+static void loop_punctuation(char c) {
+    LoopScope *loop = parse_state.loop_count > 0 ? &parse_state.loops[parse_state.loop_count - 1] : NULL;
+
+    if (isspace((unsigned char)c)) return;
+    if (loop && loop->phase == LOOP_TAIL) { /* A do without its while */
+        loop_finish();
+        loop = parse_state.loop_count > 0 ? &parse_state.loops[parse_state.loop_count - 1] : NULL;
+    }
+    if (loop && loop->phase == LOOP_HEADER) {
+        if (c == '(') {
+            loop->header_parens++;
+        } else if (c == ')' && loop->header_parens > 0 && --loop->header_parens == 0) {
+            if (loop->kind == LOOP_DO) {
+                loop_finish(); /* The condition comes after the body */
+            } else {
+                loop->phase = LOOP_PENDING;
+            }
+        } else if (c == ';' && loop->header_parens == 1) {
+            loop->header_part++;
+        } else if ((c == '<' || c == '>') && (loop->kind != LOOP_FOR || loop->header_part == 1)) {
+            loop->compares = 1;
+        }
+        return;
+    }
+    if (loop && loop->phase == LOOP_PENDING && c == '{') {
+        loop->phase = LOOP_BLOCK;
+        loop->brace_depth = parse_state.loop_braces++;
+        return;
+    }
+    loop_statement_starts();
+    if (c == '{') {
+        parse_state.loop_braces++;
+    } else if (c == '}') {
+        if (parse_state.loop_braces > 0) parse_state.loop_braces--;
+        if (loop && loop->phase == LOOP_BLOCK && loop->brace_depth == parse_state.loop_braces) loop_pop();
+        loop_end_statements();
+        if (parse_state.loop_braces == 0) { /* Out of the function */
+            loop_report_calls(0);
+            parse_state.loop_count = 0;
+            chip_function_end();
+        }
+    } else if (c == ';') {
+        loop_end_statements();
+    }
+}
+
+/* Remembers that a loop changes name; a name in capitals is taken for a constant */
+static void loop_add_variable(LoopScope *loop, const char *name) {
+    const char *p;
+    int i;
+
+    for (p = name; *p && !islower((unsigned char)*p); p++) { }
+    if (!*p) return;
+    for (i = 0; i < loop->variable_count; i++) {
+        if (strcmp(loop->variables[i], name) == 0) return;
+    }
+    if (loop->variable_count >= LOOP_VARIABLES) {
+        loop->variables_lost = 1;
+        return;
+    }
+    strncpy(loop->variables[loop->variable_count], name, LOOP_VARIABLE_LENGTH - 1);
+    loop->variables[loop->variable_count][LOOP_VARIABLE_LENGTH - 1] = '\0';
+    loop->variable_count++;
+}
+
+/* Adds a name to one of the lists loop_counts() reads */
+static void loop_add_name(LoopScope *loop, char names[][LOOP_VARIABLE_LENGTH], UBYTE *count, const char *name) {
+    if (loop_has_name(names, *count, name)) return;
+    if (*count >= LOOP_COUNTER_NAMES) {
+        loop->counters_lost = 1;
+        return;
+    }
+    strncpy(names[*count], name, LOOP_VARIABLE_LENGTH - 1);
+    names[*count][LOOP_VARIABLE_LENGTH - 1] = '\0';
+    (*count)++;
+}
+
+static int loop_has_name(char names[][LOOP_VARIABLE_LENGTH], int count, const char *name) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (strncmp(names[i], name, LOOP_VARIABLE_LENGTH - 1) == 0) return 1;
+    }
+    return 0;
+}
+
+/* Whether a loop counts its way to the end: its condition compares with < or >
+   a name the loop only steps with ++, --, += or -=.  A name it sets with =,
+   as in x = custom.vhposr, holds whatever was read and counts nothing.  With
+   more names than are kept, any comparison is taken to count */
+static int loop_counts(LoopScope *loop) {
+    int i;
+
+    if (!loop->compares) return 0;
+    if (loop->counters_lost) return 1;
+    for (i = 0; i < loop->compared_count; i++) {
+        if (loop_has_name(loop->stepped, loop->stepped_count, loop->compared[i]) &&
+            !loop_has_name(loop->set, loop->set_count, loop->compared[i])) return 1;
+    }
+    return 0;
+}
+
+/* Whether the argument list starting after '(' may change from pass to pass:
+   it names something the loop changes, or calls a function */
+static int loop_uses_variable(const LoopScope *loop, const char *arguments) {
+    char word[LOOP_VARIABLE_LENGTH];
+    const char *p = arguments;
+    int depth = 1;
+    int i;
+
+    if (loop->variables_lost) return 1;
+    while (*p && depth > 0) {
+        if (isalpha((unsigned char)*p) || *p == '_') {
+            size_t length = 0;
+            while (isalnum((unsigned char)*p) || *p == '_') {
+                if (length < sizeof(word) - 1) word[length++] = *p;
+                p++;
+            }
+            word[length] = '\0';
+            while (*p == ' ' || *p == '\t') p++;
+            if (*p == '(') return 1;
+            for (i = 0; i < loop->variable_count; i++) {
+                if (strcmp(loop->variables[i], word) == 0) return 1;
+            }
+            continue;
+        }
+        if (isdigit((unsigned char)*p)) {
+            while (isalnum((unsigned char)*p)) p++;
+            continue;
+        }
+        if (*p == '(') depth++;
+        else if (*p == ')') depth--;
+        p++;
+    }
+    return 0;
+}
+
+/* Reads the word at start: a loop keyword opens a loop, a name that is changed
+   joins the loop's names and a name followed by '(' is a call.  Returns the end */
+static const char *loop_word(const char *start, const char *line, int line_num, const char *filename, const char *original_line) {
+    char word[LOOP_VARIABLE_LENGTH];
+    const char *end = start;
+    const char *next;
+    size_t length = 0;
+    int column = (int)(start - line) + ARRAY_OFFSET_1;
+    int stepped;
+    int set;
+    LoopScope *loop;
+
+    while (isalnum((unsigned char)*end) || *end == '_') {
+        if (length < sizeof(word) - 1) word[length++] = *end;
+        end++;
+    }
+    word[length] = '\0';
+    for (next = end; *next == ' ' || *next == '\t'; next++) { }
+
+    if (parse_state.loop_count > 0 && parse_state.loops[parse_state.loop_count - 1].phase == LOOP_TAIL) {
+        loop = &parse_state.loops[parse_state.loop_count - 1];
+        if (strcmp(word, "while") == 0) {
+            loop->phase = LOOP_HEADER;
+            return end;
+        }
+        loop_finish(); /* A do without its while */
+    }
+    if (strcmp(word, "while") == 0) {
+        loop_push(LOOP_WHILE, LOOP_HEADER, line_num);
+        return end;
+    }
+    if (strcmp(word, "for") == 0) {
+        loop_push(LOOP_FOR, LOOP_HEADER, line_num);
+        return end;
+    }
+    if (strcmp(word, "do") == 0) {
+        loop_push(LOOP_DO, LOOP_PENDING, line_num);
+        return end;
+    }
+    if (strcmp(word, "FOREVER") == 0) { /* for(;;) in exec/types.h */
+        loop_push(LOOP_FOR, LOOP_PENDING, line_num);
+        return end;
+    }
+    chip_word(word, start, next, line, column, line_num, original_line);
+    loop_statement_starts();
+    if (parse_state.loop_count == 0) return end;
+
+    loop = &parse_state.loops[parse_state.loop_count - 1];
+    stepped = ((next[0] == '+' || next[0] == '-') && (next[1] == next[0] || next[1] == '=')) ||
+              (start - line >= 2 && (strncmp(start - 2, "++", 2) == 0 || strncmp(start - 2, "--", 2) == 0));
+    set = (next[0] == '=' && next[1] != '=') || (next[0] && strchr("*/%&|^", next[0]) && next[1] == '=');
+    if (loop->phase == LOOP_HEADER && loop->kind != LOOP_FOR) {
+        /* Whatever a while condition tests must change for the loop to end */
+        if (*next != '(') loop_add_variable(loop, word);
+    } else if (set || stepped) {
+        loop_add_variable(loop, word);
+    }
+    if (loop->phase == LOOP_HEADER && (loop->kind != LOOP_FOR || loop->header_part == 1) && *next != '(') {
+        loop_add_name(loop, loop->compared, &loop->compared_count, word);
+    }
+    if (stepped) {
+        loop_add_name(loop, loop->stepped, &loop->stepped_count, word);
+    } else if (set && !(loop->phase == LOOP_HEADER && loop->header_part == 0 && loop->kind == LOOP_FOR)) {
+        loop_add_name(loop, loop->set, &loop->set_count, word); /* for (i = 0; ...) starts a count */
+    }
+
+    loop = loop_innermost();
+    if (*next == '(' && !is_statement_keyword(word) && strcmp(word, "sizeof") != 0) {
+        if (loop && loop_table_lookup(PATTERNS_BLOCKING, word) >= 0) {
+            loop->blocks = 1;
+        } else if (loop && loop_table_lookup(PATTERNS_POLLING, word) >= 0) {
+            loop_poll(loop, word, "()", loop_negated(line, start, next + 1), column, line_num, original_line);
+        }
+        loop_call(word, next + 1, column, line_num, filename, original_line);
+    } else if (loop && loop_table_lookup(PATTERNS_HARDWARE_REGISTERS, word) >= 0 &&
+               (next[0] == '.' || (next[0] == '-' && next[1] == '>'))) {
+        loop_poll(loop, word, " registers", 1, column, line_num, original_line);
+    } else if (loop && strcmp(word, "volatile") == 0) {
+        loop_poll(loop, word, " data", 1, column, line_num, original_line);
+    } else if (loop && loop->phase == LOOP_HEADER && loop->kind != LOOP_FOR &&
+               loop_table_lookup(PATTERNS_MESSAGE_LISTS, word) >= 0 && loop_list_waits(line, start, end)) {
+        /* A loop that walks a list while it has nodes does not wait on it */
+        loop_poll(loop, word, "", 1, column, line_num, original_line);
+    }
+    return end;
+}
+
+/* Whether a condition polling at start waits for the call to fail, as in
+   !GetMsg(port), !(msg = GetMsg(port)) or (msg = GetMsg(port)) == NULL */
+static int loop_negated(const char *line, const char *start, const char *arguments) {
+    const char *p = start;
+    int depth = 1;
+
+    while (p > line && (p[-1] == ' ' || p[-1] == '\t' || p[-1] == '(')) p--;
+    if (p - line >= 2 && p[-1] == '=' && !strchr("=!<>", p[-2])) { /* Back over the assignment */
+        p--;
+        while (p > line && (p[-1] == ' ' || p[-1] == '\t')) p--;
+        while (p > line && (isalnum((unsigned char)p[-1]) || p[-1] == '_')) p--;
+        while (p > line && (p[-1] == ' ' || p[-1] == '\t' || p[-1] == '(')) p--;
+    }
+    if (p > line && p[-1] == '!') return 1;
+
+    for (p = arguments; *p && depth > 0; p++) {
+        if (*p == '(') depth++;
+        else if (*p == ')') depth--;
+    }
+    while (*p == ' ' || *p == '\t' || *p == ')') p++;
+    return p[0] == '=' && p[1] == '=';
+}
+
+/* Whether a condition reading the list field at start..end of a member chain
+   waits for a node, as in !port->mp_MsgList.lh_Head->ln_Succ or
+   list->lh_TailPred == (struct Node *)list */
+static int loop_list_waits(const char *line, const char *start, const char *end) {
+    const char *p = start;
+    const char *q = end;
+    int member = 0;
+
+    for (;;) { /* Back to the start of the chain */
+        const char *name = p;
+        while (name > line && (name[-1] == ' ' || name[-1] == '\t')) name--;
+        if (name > line && name[-1] == '.') name--;
+        else if (name - line >= 2 && name[-1] == '>' && name[-2] == '-') name -= 2;
+        else break;
+        while (name > line && (name[-1] == ' ' || name[-1] == '\t')) name--;
+        while (name > line && (isalnum((unsigned char)name[-1]) || name[-1] == '_')) name--;
+        p = name;
+        member = 1;
+    }
+    if (!member) return 0; /* A name of its own, not a field */
+    while (p > line && (p[-1] == ' ' || p[-1] == '\t' || p[-1] == '(')) p--;
+    if (p > line && p[-1] == '!') return 1;
+
+    for (;;) { /* On to its end */
+        while (*q == ' ' || *q == '\t') q++;
+        if (q[0] == '.') q++;
+        else if (q[0] == '-' && q[1] == '>') q += 2;
+        else break;
+        while (*q == ' ' || *q == '\t') q++;
+        while (isalnum((unsigned char)*q) || *q == '_') q++;
+    }
+    while (*q == ' ' || *q == '\t' || *q == ')') q++;
+    return q[0] == '=' && q[1] == '=';
+}
+
+/* Checks a call made inside a loop */
+static void loop_call(const char *name, const char *arguments, int column, int line_num, const char *filename, const char *original_line) {
+    LoopScope *loop = loop_innermost();
+    char *message = line_context.message;
+    const char *length_text;
+    size_t length;
+    LONG size;
+    int io;
+
+    if (!loop) return;
+    if (is_loop_setup_function(name)) {
+        /* Whether the arguments change is only known once the whole loop is read */
+        loop_hold_call(loop, name, arguments, column, line_num, original_line);
+        return;
+    }
+
+    io = find_unbuffered_io(name);
+    if (io >= 0 && loop_argument(arguments, IO_LENGTH_ARGUMENT, &length_text, &length) &&
+        loop_constant_size(length_text, length, &size) && size <= UNBUFFERED_IO_LIMIT) {
+        strncpy(message, name, LARGE_MESSAGE_BUFFER_SIZE - 1);
+        message[LARGE_MESSAGE_BUFFER_SIZE - 1] = '\0';
+        strncat(message, "() of ", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+        append_number(message, size);
+        strncat(message, size == 1 ? " byte" : " bytes", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+        strncat(message, " in the loop at line ", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+        append_number(message, (LONG)loop->line);
+        strncat(message, " is a DOS packet round trip on every pass; use buffered ", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+        strncat(message, buffered_io_replacements[io], LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+        strncat(message, ", or move more bytes per call.", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+        add_error_with_excerpt(filename, line_num, column, ERROR_WARNING, message, original_line);
+    }
+}
+
+/* Keeps a setup call until its loop ends.  With no room left it is reported
+   at once, as a call that may change from pass to pass */
+static void loop_hold_call(const LoopScope *loop, const char *name, const char *arguments, int column, int line_num, const char *original_line) {
+    LoopCall *call;
+    const char *end = arguments;
+    size_t length;
+    int depth = 1;
+
+    if (parse_state.loop_call_count >= LOOP_PENDING_CALLS) {
+        loop_report_call(name, loop->line, 0, line_num, column, original_line);
+        return;
+    }
+    call = &parse_state.loop_calls[parse_state.loop_call_count++];
+    call->line = line_num;
+    call->column = column;
+    call->loop = (int)(loop - parse_state.loops);
+    strcpy(call->name, name); /* loop_word() cut it to LOOP_VARIABLE_LENGTH */
+
+    while (*end && depth > 0) {
+        if (*end == '(') depth++;
+        else if (*end == ')') depth--;
+        end++;
+    }
+    length = (size_t)(end - arguments);
+    call->varies = length >= LOOP_ARGUMENTS_LENGTH;
+    if (call->varies) length = 0;
+    memcpy(call->arguments, arguments, length);
+    call->arguments[length] = '\0';
+
+    loop_copy_excerpt(call->excerpt, original_line);
+}
+
+/* Keeps original_line for an issue reported once the loop ends; the excerpt
+   holds LINE_EXCERPT_LIMIT + 1 characters, to tell a cut line */
+static void loop_copy_excerpt(char *excerpt, const char *original_line) {
+    size_t length;
+
+    for (length = 0; length < LINE_EXCERPT_LIMIT + 1 && original_line[length]; length++) {
+        excerpt[length] = original_line[length];
+    }
+    excerpt[length] = '\0';
+}
+
+/* Reports the setup calls held for the loop at first_loop and the loops inside it */
+static void loop_report_calls(int first_loop) {
+    int kept = 0;
+    int i;
+
+    for (i = 0; i < parse_state.loop_call_count; i++) {
+        LoopCall *call = &parse_state.loop_calls[i];
+        const LoopScope *loop = &parse_state.loops[call->loop];
+
+        if (call->loop < first_loop) {
+            if (kept != i) parse_state.loop_calls[kept] = *call;
+            kept++;
+            continue;
+        }
+        loop_report_call(call->name, loop->line, !call->varies && !loop_uses_variable(loop, call->arguments),
+                         call->line, call->column, call->excerpt);
+    }
+    parse_state.loop_call_count = kept;
+}
+
+/* Reports a setup call made on every pass of the loop at loop_line */
+static void loop_report_call(const char *name, int loop_line, int repeats, int line_num, int column, const char *excerpt) {
+    char *message = line_context.message;
+
+    strncpy(message, name, LARGE_MESSAGE_BUFFER_SIZE - 1);
+    message[LARGE_MESSAGE_BUFFER_SIZE - 1] = '\0';
+    strncat(message, "() in the loop at line ", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+    append_number(message, (LONG)loop_line);
+    if (repeats) {
+        strncat(message, " repeats the same costly system call on every pass; call it once outside the loop.",
+                LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+    } else {
+        strncat(message, " is a costly system call on every pass; reuse what it sets up across passes if you can.",
+                LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+    }
+    add_error_with_excerpt(parse_state.loop_filename, line_num, column, ERROR_WARNING, message, excerpt);
+}
+
+/* Finds argument index (from 0) of the list starting after '('; returns 0
+   if the list does not reach it on this line */
+static int loop_argument(const char *arguments, int index, const char **start, size_t *length) {
+    const char *p = arguments;
+    int depth = 0;
+
+    *start = p;
+    for (; *p; p++) {
+        if (*p == '(') {
+            depth++;
+        } else if (*p == ')' && depth > 0) {
+            depth--;
+        } else if ((*p == ',' || *p == ')') && depth == 0) {
+            if (index == 0) {
+                *length = (size_t)(p - *start);
+                return 1;
+            }
+            if (*p == ')') return 0;
+            index--;
+            *start = p + 1;
+        }
+    }
+    return 0;
+}
+
+/* Value of a length argument that is a number, sizeof a C or Exec type, or,
+   under STACKCHECK/S, a #define the project has made; returns 0 otherwise */
+static int loop_constant_size(const char *text, size_t length, LONG *size) {
+    const char *end = text + length;
+    char word[LOOP_VARIABLE_LENGTH];
+    size_t word_length = 0;
+
+    while (text < end && isspace((unsigned char)*text)) text++;
+    while (end > text && isspace((unsigned char)end[-1])) end--;
+    if (text == end) return 0;
+    if (isdigit((unsigned char)*text)) {
+        char *after;
+
+        *size = strtol(text, &after, 0);
+        while (after < end && strchr("uUlL", *after)) after++;
+        return after == end;
+    }
+    if (end - text > 6 && strncmp(text, "sizeof", 6) == 0 && !isalnum((unsigned char)text[6]) && text[6] != '_') {
+        text += 6;
+        while (text < end && (isspace((unsigned char)*text) || *text == '(')) text++;
+        while (end > text && (isspace((unsigned char)end[-1]) || end[-1] == ')')) end--;
+        while (text < end && word_length < sizeof(word) - 1) word[word_length++] = *text++;
+        word[word_length] = '\0';
+        return text == end && stack_type_size(word, size);
+    }
+    return stackcheck_enabled && stack_evaluate(text, (size_t)(end - text), size);
+}
+
+/* ============================================================================ */
+/* CHIP RAM */
+/* ============================================================================ */
+
+/* The words the loop scopes read also follow MEMF_CHIP memory through each
+   function.  An allocation counts when it goes into one of the first
+   MAX_FUNCTION_LOCALS locals the function declares; parameters, globals and
+   later locals are not followed, so chip RAM put there is never reported.  It
+   is needed in chip RAM if it is passed to a call in chip_memory_functions[],
+   or if it leaves the function: stored elsewhere, such as in a custom chip
+   register or an IOAudio request, or returned.  At the end of the function, a
+   chip allocation nothing needed is reported at its line; the issues are put
+   back in line order when the list is printed */
+
+/* Reads one word inside a function for the chip RAM rule */
+static void chip_word(const char *word, const char *start, const char *next, const char *line, int column, int line_num, const char *original_line) {
+    ChipAllocation *allocation;
+    char type[LOOP_VARIABLE_LENGTH];
+    const char *before;
+    int allocator;
+
+    if (parse_state.loop_braces == 0) return;
+    if (*next == '(') {
+        allocator = loop_table_lookup(PATTERNS_MEMORY_ALLOCATORS, word);
+        if (allocator >= 0) chip_allocation(allocator, next + 1, line, start, column, line_num, original_line);
+        return;
+    }
+
+    /* A declaration: a type name, perhaps with '*', before the name */
+    before = chip_skip_back(line, start);
+    while (before > line && before[-1] == '*') before = chip_skip_back(line, before - 1);
+    if (*next && strchr(";=,[", *next) && next[1] != '=' && before > line &&
+        (isalnum((unsigned char)before[-1]) || before[-1] == '_')) {
+        const char *type_start = before;
+
+        while (type_start > line && (isalnum((unsigned char)type_start[-1]) || type_start[-1] == '_')) type_start--;
+        strncpy(type, type_start, sizeof(type) - 1);
+        type[sizeof(type) - 1] = '\0';
+        if ((size_t)(before - type_start) < sizeof(type)) type[before - type_start] = '\0';
+        if (!isdigit((unsigned char)type[0]) && !is_statement_keyword(type) &&
+            parse_state.local_count < MAX_FUNCTION_LOCALS) {
+            strcpy(parse_state.locals[parse_state.local_count++], word);
+            return;
+        }
+    }
+
+    allocation = chip_find(word, strlen(word));
+    if (!allocation || (next[0] == '=' && next[1] != '=')) return; /* Given a new value */
+    chip_use(allocation, line, start, next);
+}
+
+/* Starts following a call to memory_allocators[allocator] that asks for MEMF_CHIP
+   and stores its result in a local, as in buffer = AllocMem(size, MEMF_CHIP) */
+static void chip_allocation(int allocator, const char *arguments, const char *line, const char *start, int column, int line_num, const char *original_line) {
+    ChipAllocation *allocation;
+    const char *text;
+    const char *p;
+    const char *name;
+    size_t length;
+    int requirements = memory_requirement_arguments[allocator];
+    int pool = 0;
+
+    if (requirements == ALLOCATION_FROM_POOL) {
+        ChipAllocation *from;
+
+        if (!loop_argument(arguments, 0, &text, &length)) return;
+        while (length > 0 && isspace((unsigned char)*text)) {
+            text++;
+            length--;
+        }
+        while (length > 0 && isspace((unsigned char)text[length - 1])) length--;
+        from = chip_find(text, length);
+        if (!from || strcmp(from->function, "CreatePool") != 0) return; /* Not a pool of chip RAM this function made */
+        pool = (int)(from - parse_state.chip) + 1;
+    } else if (!loop_argument(arguments, requirements, &text, &length) || !chip_requested(text, length)) {
+        return;
+    }
+
+    /* The local it is assigned to, past a cast */
+    p = chip_skip_back(line, start);
+    if (p > line && p[-1] == ')') {
+        int depth = 0;
+
+        do {
+            p--;
+            if (*p == ')') depth++;
+            else if (*p == '(') depth--;
+        } while (p > line && depth > 0);
+        p = chip_skip_back(line, p);
+    }
+    if (p - line < 2 || p[-1] != '=' || strchr("=!<>+-*/%&|^", p[-2])) return;
+    p = chip_skip_back(line, p - 1);
+    for (name = p; name > line && (isalnum((unsigned char)name[-1]) || name[-1] == '_'); name--) { }
+    if (name == p || (name > line && (name[-1] == '.' || name[-1] == '>'))) return;
+    if ((size_t)(p - name) >= LOOP_VARIABLE_LENGTH || parse_state.chip_count >= MAX_CHIP_ALLOCATIONS) return;
+
+    allocation = &parse_state.chip[parse_state.chip_count];
+    strncpy(allocation->name, name, (size_t)(p - name));
+    allocation->name[p - name] = '\0';
+    if (!chip_is_local(allocation->name)) return;
+    strcpy(allocation->function, memory_allocators[allocator]);
+    allocation->line = line_num;
+    allocation->column = column;
+    allocation->used = 0;
+    allocation->pool = (UBYTE)pool;
+    allocation->report = pool == 0;
+    loop_copy_excerpt(allocation->excerpt, original_line);
+    parse_state.chip_count++;
+}
+
+/* A chip allocation is named away from its assignment: marks it used unless
+   only the CPU can be touching it.  next is past the name and blanks */
+static void chip_use(ChipAllocation *allocation, const char *line, const char *start, const char *next) {
+    char name[LOOP_VARIABLE_LENGTH];
+    const char *before;
+    int call = chip_enclosing_call(line, start, name);
+    int needed = 0;
+
+    before = chip_skip_back(line, start);
+    if (before > line && before[-1] == ')') { /* Back over a cast */
+        while (before > line && before[-1] != '(') before--;
+        if (before > line) before = chip_skip_back(line, before - 1);
+    }
+    if (call > 0) {
+        needed = loop_table_lookup(PATTERNS_CHIP_MEMORY, name) >= 0;
+    } else if (call < 0 && ((before > line && before[-1] == ',') || *next == ',' || *next == ')')) {
+        needed = 1; /* An argument of a call begun on an earlier line, which may be one of them */
+    } else if (before > line && before[-1] == '=' && (before - line < 2 || !strchr("=!<>", before[-2]))) {
+        needed = 1; /* Stored elsewhere */
+    } else if (before - line >= 6 && strncmp(before - 6, "return", 6) == 0) {
+        needed = 1;
+    }
+    if (!needed) return;
+    allocation->used = 1;
+    if (allocation->pool) parse_state.chip[allocation->pool - 1].used = 1;
+}
+
+/* 1 if the word at start is an argument of a call opened on this line, with
+   name set to the function; casts, grouping and if, while and sizeof are
+   passed over.  0 if it is only inside those, -1 if no '(' is open before it */
+static int chip_enclosing_call(const char *line, const char *start, char *name) {
+    const char *p = start;
+    const char *end;
+    const char *word;
+    int depth = 0;
+    int open = -1;
+
+    while (p > line) {
+        p--;
+        if (*p == ')') {
+            depth++;
+        } else if (*p == '(' && depth > 0) {
+            depth--;
+        } else if (*p == '(') {
+            open = 0;
+            end = chip_skip_back(line, p);
+            for (word = end; word > line && (isalnum((unsigned char)word[-1]) || word[-1] == '_'); word--) { }
+            if (word < end && (size_t)(end - word) < LOOP_VARIABLE_LENGTH && !isdigit((unsigned char)*word)) {
+                strncpy(name, word, (size_t)(end - word));
+                name[end - word] = '\0';
+                if (!is_statement_keyword(name)) return 1;
+            }
+        }
+    }
+    return open;
+}
+
+/* Moves back from p over blanks */
+static const char *chip_skip_back(const char *line, const char *p) {
+    while (p > line && (p[-1] == ' ' || p[-1] == '\t')) p--;
+    return p;
+}
+
+/* Whether requirements text names MEMF_CHIP */
+static int chip_requested(const char *text, size_t length) {
+    size_t chip_length = sizeof("MEMF_CHIP") - 1;
+    size_t i;
+
+    for (i = 0; i + chip_length <= length; i++) {
+        if (strncmp(text + i, "MEMF_CHIP", chip_length) == 0 &&
+            (i + chip_length == length || (!isalnum((unsigned char)text[i + chip_length]) && text[i + chip_length] != '_'))) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int chip_is_local(const char *name) {
+    int i;
+
+    for (i = 0; i < parse_state.local_count; i++) {
+        if (strcmp(parse_state.locals[i], name) == 0) return 1;
+    }
+    return 0;
+}
+
+/* The latest chip allocation held in the local name, or NULL */
+static ChipAllocation *chip_find(const char *name, size_t length) {
+    int i;
+
+    for (i = parse_state.chip_count - 1; i >= 0; i--) {
+        if (strncmp(parse_state.chip[i].name, name, length) == 0 && parse_state.chip[i].name[length] == '\0') {
+            return &parse_state.chip[i];
+        }
+    }
+    return NULL;
+}
+
+/* The function has ended: reports the chip RAM only the CPU used */
+static void chip_function_end(void) {
+    char *message = line_context.message;
+    int i;
+
+    for (i = 0; i < parse_state.chip_count; i++) {
+        ChipAllocation *allocation = &parse_state.chip[i];
+
+        if (allocation->used || !allocation->report) continue;
+        strncpy(message, allocation->name, LARGE_MESSAGE_BUFFER_SIZE - 1);
+        message[LARGE_MESSAGE_BUFFER_SIZE - 1] = '\0';
+        strncat(message, " gets MEMF_CHIP memory from ", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+        strncat(message, allocation->function, LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+        strncat(message, "(), but the function never hands it to graphics, audio, the blitter or a custom chip "
+                "register. Chip RAM is scarce and slower for the CPU; use MEMF_ANY.",
+                LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+        add_error_with_excerpt(parse_state.loop_filename, allocation->line, allocation->column, ERROR_WARNING, message,
+                               allocation->excerpt);
+    }
+    parse_state.chip_count = 0;
+    parse_state.local_count = 0;
+}
+
+/* ============================================================================ */
+/* STACK DEPTH (STACKCHECK/S) */
+/* ============================================================================ */
+
+/* The linted files are read as one project: every function definition gets a
+   frame estimated from its parameters and the locals declared at the start of
+   its lines, and every name followed by '(' in a body is a call.  Once all
+   files are read, the worst case from main() is worked out without recursion
+   and checked against the $STACK cookie.  Calls into libraries and through
+   function pointers are not in the graph. */
+
+/* Starts an empty call graph, reusing the arena of an earlier run */
+static int stack_open(void) {
+    arena_reset(&stack_arena);
+    stack_buckets = arena_alloc(&stack_arena, STACK_HASH_SIZE * sizeof(StackSymbol *));
+    if (!stack_buckets) return 0;
+    memset(stack_buckets, 0, STACK_HASH_SIZE * sizeof(StackSymbol *));
+    memset(&stack_scan, 0, sizeof(stack_scan));
+    stack_root = NULL;
+    stack_from_main = 0;
+    stack_out_of_memory = 0;
+    stack_limit = 0;
+    stack_cookie_file = NULL;
+    stack_cookie_line = 0;
+    stack_functions = 0;
+    stack_recursive_calls = 0;
+    return 1;
+}
+
+static void stack_close(void) {
+    arena_close(&stack_arena);
+    stack_buckets = NULL;
+}
+
+/* Forgets where the previous file left off */
+static void stack_file_begin(void) {
+    memset(&stack_scan, 0, sizeof(stack_scan));
+}
+
+/* The current file's name, copied into the call graph the first time it is needed */
+static const char *stack_filename(const char *filename) {
+    size_t length;
+    char *copy;
+
+    if (stack_scan.filename) return stack_scan.filename;
+    length = strlen(filename);
+    copy = arena_alloc(&stack_arena, (ULONG)length + 1);
+    if (!copy) {
+        stack_out_of_memory = 1;
+        return NULL;
+    }
+    memcpy(copy, filename, length + 1);
+    stack_scan.filename = copy;
+    return copy;
+}
+
+/* Finds a name of one kind, adding it if create is set; NULL if absent or out of memory */
+static StackSymbol *stack_symbol(const char *name, SymbolKind kind, int create) {
+    ULONG hash = 0;
+    const char *s;
+    StackSymbol *symbol;
+    size_t length;
+
+    for (s = name; *s; s++) hash = hash * 31 + (UBYTE)*s;
+    hash %= STACK_HASH_SIZE;
+    for (symbol = stack_buckets[hash]; symbol; symbol = symbol->next) {
+        if (symbol->kind == (UBYTE)kind && strcmp(symbol->name, name) == 0) return symbol;
+    }
+    if (!create) return NULL;
+
+    length = strlen(name);
+    symbol = arena_alloc(&stack_arena, (ULONG)(sizeof(StackSymbol) + length + 1));
+    if (!symbol) {
+        stack_out_of_memory = 1;
+        return NULL;
+    }
+    memset(symbol, 0, sizeof(StackSymbol));
+    memcpy(symbol + 1, name, length + 1);
+    symbol->name = (const char *)(symbol + 1);
+    symbol->kind = (UBYTE)kind;
+    symbol->next = stack_buckets[hash];
+    stack_buckets[hash] = symbol;
+    return symbol;
+}
+
+/* Records the size of a struct, union or typedef */
+static void stack_define_size(const char *name, SymbolKind kind, LONG size, int unknown) {
+    StackSymbol *symbol = stack_symbol(name, kind, 1);
+
+    if (!symbol) return;
+    symbol->value = size;
+    symbol->flags = (UBYTE)(SYMBOL_DEFINED | (unknown ? SYMBOL_SIZE_UNKNOWN : 0));
+}
+
+/* Copies the identifier at p into buffer, cut to STACK_NAME_LENGTH; returns its end, or p if there is none */
+static const char *stack_word(const char *p, char *buffer) {
+    size_t length = 0;
+
+    if (!isalpha((unsigned char)*p) && *p != '_') return p;
+    while (isalnum((unsigned char)*p) || *p == '_') {
+        if (length < STACK_NAME_LENGTH - 1) buffer[length++] = *p;
+        p++;
+    }
+    buffer[length] = '\0';
+    return p;
+}
+
+/* Value of numbers and known #defines joined by + - * and /, with or without
+   outer parentheses; returns 0 if the text holds anything else */
+static int stack_evaluate(const char *text, size_t length, LONG *value) {
+    const char *p = text;
+    const char *end = text + length;
+    LONG sum = 0;
+    LONG term = 0;
+    LONG factor;
+    int sign = 1;
+    char op = '+';
+
+    while (end > p && isspace((unsigned char)end[-1])) end--;
+    while (p < end && isspace((unsigned char)*p)) p++;
+    if (p < end && *p == '(' && end[-1] == ')') {
+        p++;
+        end--;
+    }
+    for (;;) {
+        while (p < end && isspace((unsigned char)*p)) p++;
+        if (p >= end) return 0;
+        if (isdigit((unsigned char)*p)) {
+            char *after;
+
+            factor = strtol(p, &after, 0);
+            p = after;
+            while (p < end && strchr("uUlL", *p)) p++;
+        } else {
+            const char *word = stack_word(p, stack_scan.lookup);
+            StackSymbol *define;
+
+            if (word == p || word > end) return 0;
+            define = stack_symbol(stack_scan.lookup, SYMBOL_DEFINE, 0);
+            if (!define) return 0;
+            factor = define->value;
+            p = word;
+        }
+
+        if (op == '*') {
+            term *= factor;
+        } else if (op == '/') {
+            if (factor == 0) return 0;
+            term /= factor;
+        } else {
+            sum += sign * term;
+            term = factor;
+            sign = op == '-' ? -1 : 1;
+        }
+
+        while (p < end && isspace((unsigned char)*p)) p++;
+        if (p >= end) break;
+        op = *p++;
+        if (!strchr("+-*/", op)) return 0;
+    }
+    *value = sum + sign * term;
+    return 1;
+}
+
+/* Size of a C or Exec type name; returns 0 if the word is not one */
+static int stack_type_size(const char *word, LONG *size) {
+    int i;
+
+    for (i = 0; i < (int)(sizeof(type_sizes) / sizeof(type_sizes[0])); i++) {
+        if (strcmp(word, type_sizes[i].name) == 0) {
+            *size = type_sizes[i].size;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Size of a struct or union by tag, from the linted files or the NDK; 0 and *unknown set if neither has it */
+static LONG stack_record_size(const char *tag, int *unknown) {
+    StackSymbol *record = stack_symbol(tag, SYMBOL_TAG, 0);
+    int i;
+
+    if (record) {
+        if (record->flags & SYMBOL_SIZE_UNKNOWN) *unknown = 1;
+        return record->value;
+    }
+    for (i = 0; i < (int)(sizeof(ndk_struct_sizes) / sizeof(ndk_struct_sizes[0])); i++) {
+        if (strcmp(tag, ndk_struct_sizes[i].name) == 0) return ndk_struct_sizes[i].size;
+    }
+    *unknown = 1;
+    return 0;
+}
+
+/* Bytes of stack taken by a declaration at the start of a line; returns 0 if
+   the line is not a declaration.  A part of unknown size counts as nothing
+   and sets *unknown.  name, if given, gets the last name declared */
+static int stack_declaration(const char *text, LONG *size, int *unknown, char *name) {
+    char *word = stack_scan.word;
+    const char *p = text;
+    const char *next;
+    LONG base = -1;
+    LONG word_size;
+    int base_unknown = 0;
+    int long_seen = 0;
+
+    *size = 0;
+    /* The type: qualifiers, then C and Exec type words, a struct, union or enum, or a typedef name */
+    for (;;) {
+        next = stack_word(p, word);
+        if (next == p) break;
+        if (is_statement_keyword(word)) return 0;
+        if (strcmp(word, "static") == 0 || strcmp(word, "extern") == 0 || strcmp(word, "typedef") == 0) {
+            return 1; /* Not on the stack */
+        }
+        if (strcmp(word, "const") == 0 || strcmp(word, "volatile") == 0 ||
+            strcmp(word, "register") == 0 || strcmp(word, "auto") == 0) {
+            p = next;
+        } else if (strcmp(word, "struct") == 0 || strcmp(word, "union") == 0 || strcmp(word, "enum") == 0) {
+            int is_enum = word[0] == 'e';
+
+            while (*next == ' ' || *next == '\t') next++;
+            p = next;
+            next = stack_word(p, word);
+            if (next == p) return 0; /* A struct defined in place */
+            base = is_enum ? STACK_SLOT_SIZE : stack_record_size(word, &base_unknown);
+            p = next;
+            break;
+        } else if (stack_type_size(word, &word_size)) {
+            if (strcmp(word, "long") == 0) {
+                base = long_seen ? STACK_SLOT_SIZE * 2 : word_size; /* long long */
+                long_seen = 1;
+            } else if (strcmp(word, "int") == 0 || strcmp(word, "signed") == 0 || strcmp(word, "unsigned") == 0) {
+                if (base < 0) base = word_size; /* unsigned char, long int */
+            } else {
+                base = word_size;
+            }
+            p = next;
+        } else if (base >= 0) {
+            break; /* The first declarator */
+        } else {
+            StackSymbol *type = stack_symbol(word, SYMBOL_TYPE, 0);
+            const char *after = next;
+
+            if (type) {
+                base = type->value;
+                if (type->flags & SYMBOL_SIZE_UNKNOWN) base_unknown = 1;
+                p = next;
+                break;
+            }
+            /* A type from a header Codex has not read: a declarator must follow */
+            while (*after == ' ' || *after == '\t' || *after == '*') after++;
+            next = stack_word(after, stack_scan.lookup);
+            if (next == after) return 0;
+            while (*next == ' ' || *next == '\t') next++;
+            if (*next == '\0' || !strchr(";,=[", *next)) return 0;
+            base = 0;
+            base_unknown = 1;
+            p += strlen(word);
+            break;
+        }
+        while (*p == ' ' || *p == '\t') p++;
+    }
+    if (base < 0) return 0;
+
+    /* The declarators */
+    for (;;) {
+        int pointer = 0;
+        int prototype = 0;
+        int depth = 0;
+        LONG count = 1;
+
+        while (*p == ' ' || *p == '\t' || *p == '*' || *p == '(') {
+            if (*p == '*') pointer = 1;
+            p++;
+            next = stack_word(p, word);
+            if (strcmp(word, "const") == 0 || strcmp(word, "volatile") == 0) p = next;
+        }
+        next = stack_word(p, word);
+        if (next == p) break;
+        if (name) strcpy(name, word);
+        p = next;
+        while (*p == ' ' || *p == '\t' || *p == ')') p++;
+        if (*p == '(' && !pointer) prototype = 1; /* A function declared in a body */
+        while (*p == '[') {
+            const char *close = strchr(p, ']');
+            LONG dimension;
+
+            if (!close) break;
+            if (stack_evaluate(p + 1, (size_t)(close - p - 1), &dimension) && dimension > 0) {
+                count *= dimension;
+            } else {
+                *unknown = 1;
+            }
+            p = close + 1;
+            while (*p == ' ' || *p == '\t') p++;
+        }
+        if (!prototype) {
+            LONG bytes = (pointer ? STACK_SLOT_SIZE : base) * count;
+
+            if (!pointer && base_unknown) *unknown = 1;
+            *size += (bytes + STACK_ALIGN - 1) / STACK_ALIGN * STACK_ALIGN;
+        }
+
+        /* Past the initializer or parameter list to the next declarator */
+        while (*p && !(depth == 0 && (*p == ',' || *p == ';'))) {
+            if (*p == '(' || *p == '[' || *p == '{') depth++;
+            else if (*p == ')' || *p == ']' || *p == '}') depth--;
+            if (depth < 0) break;
+            p++;
+        }
+        if (*p != ',') break;
+        p++;
+    }
+    return 1;
+}
+
+/* Takes the stack size from the first $STACK cookie of the project */
+static void stack_read_cookie(const char *cookie, int line_num, const char *filename) {
+    const char *p = cookie + strlen(STACK_COOKIE);
+
+    while (*p == ' ' || *p == '\t') p++;
+    if (!isdigit((unsigned char)*p)) return; /* Only mentioned, as in a comment */
+    stack_limit = strtol(p, NULL, DECIMAL_BASE);
+    stack_cookie_file = stack_filename(filename);
+    stack_cookie_line = line_num;
+}
+
+/* Remembers "#define NAME value" when the value is a constant expression */
+static void stack_read_define(const char *text) {
+    const char *p = text;
+    const char *end;
+    StackSymbol *define;
+    LONG value;
+
+    while (*p == ' ' || *p == '\t') p++;
+    if (strncmp(p, "define", sizeof("define") - 1) != 0) return;
+    p += sizeof("define") - 1;
+    if (*p != ' ' && *p != '\t') return;
+    while (*p == ' ' || *p == '\t') p++;
+    end = stack_word(p, stack_scan.word);
+    if (end == p || *end == '(') return; /* Function-like macro */
+    if (!stack_evaluate(end, strlen(end), &value)) return;
+    define = stack_symbol(stack_scan.word, SYMBOL_DEFINE, 1);
+    if (!define) return;
+    define->value = value;
+    define->flags |= SYMBOL_DEFINED;
+}
+
+/* Reads one line into the call graph: definitions, calls, locals, types and #defines */
+static void stack_scan_line(const char *clean_line, const char *original_line, int line_num, const char *filename) {
+    StackScan *scan = &stack_scan;
+    const char *s = clean_line;
+    const char *cookie;
+    LONG size;
+    int unknown = 0;
+
+    if (!stack_buckets) return;
+    if (!stack_cookie_file && (cookie = strstr(original_line, STACK_COOKIE)) != NULL) {
+        stack_read_cookie(cookie, line_num, filename);
+    }
+    while (*s == ' ' || *s == '\t') s++;
+    if (scan->in_directive || *s == '#') {
+        size_t length = strlen(s);
+
+        if (!scan->in_directive) stack_read_define(s + 1);
+        scan->in_directive = length > 0 && s[length - 1] == '\\';
+        return;
+    }
+
+    /* Locals and members are declared at the start of a line */
+    if (scan->block == BLOCK_FUNCTION && scan->depth > 0) {
+        if (stack_declaration(s, &size, &unknown, NULL)) {
+            scan->frame += size;
+            if (unknown) scan->frame_unknown = 1;
+        }
+    } else if (scan->block == BLOCK_RECORD && scan->depth == 1) {
+        if (stack_declaration(s, &size, &unknown, NULL)) {
+            scan->record_size += size;
+            if (unknown) scan->record_unknown = 1;
+        }
+    } else if (scan->depth == 0 && strncmp(s, "typedef", sizeof("typedef") - 1) == 0 &&
+               !strchr(s, '{') && !strchr(s, '(')) {
+        char *name = scan->statement.last_word;
+
+        name[0] = '\0';
+        if (stack_declaration(s + sizeof("typedef") - 1, &size, &unknown, name) && name[0]) {
+            stack_define_size(name, SYMBOL_TYPE, size, unknown);
+        }
+    }
+
+    while (*s) {
+        if (isalpha((unsigned char)*s) || *s == '_') {
+            const char *next = stack_word(s, scan->word);
+            const char *after = next;
+
+            while (*after == ' ' || *after == '\t') after++;
+            if (scan->depth == 0) {
+                stack_file_word(line_num, *after == '(');
+            } else if (scan->block == BLOCK_ENUM && scan->depth == 1) {
+                next = stack_enum_constant(after);
+            } else if (scan->block == BLOCK_FUNCTION && *after == '(' &&
+                       !is_statement_keyword(scan->word) && !is_declaration_keyword(scan->word)) {
+                stack_add_call(line_num, filename);
+            }
+            s = next;
+            continue;
+        }
+        if (isdigit((unsigned char)*s)) {
+            while (isalnum((unsigned char)*s) || *s == '.') s++;
+            continue;
+        }
+        if (*s == '{') {
+            stack_open_brace(filename);
+        } else if (*s == '}') {
+            stack_close_brace();
+        } else if (scan->depth == 0) {
+            stack_file_punctuation(*s);
+        }
+        s++;
+    }
+}
+
+/* Follows the words of a statement at file scope */
+static void stack_file_word(int line_num, int before_paren) {
+    StackStatement *statement = &stack_scan.statement;
+    const char *word = stack_scan.word;
+
+    if (statement->paren_depth > 0) {
+        if (!statement->params_done && strcmp(word, "void") != 0) statement->param_seen = 1;
+        return;
+    }
+    if (statement->tag_next) {
+        strcpy(statement->tag, word);
+        statement->tag_next = 0;
+    } else if (strcmp(word, "struct") == 0 || strcmp(word, "union") == 0) {
+        statement->aggregate = 1;
+        statement->tag_next = 1;
+    } else if (strcmp(word, "enum") == 0) {
+        statement->enumeration = 1;
+    } else if (strcmp(word, "typedef") == 0) {
+        statement->typedef_seen = 1;
+    } else if (before_paren && !statement->params_done && !statement->name[0]) {
+        strcpy(statement->name, word);
+        statement->name_line = line_num;
+    }
+    strcpy(statement->last_word, word);
+}
+
+/* Follows the parentheses, '=' and ';' of a statement at file scope */
+static void stack_file_punctuation(char c) {
+    StackStatement *statement = &stack_scan.statement;
+
+    if (c == '(') {
+        statement->paren_depth++;
+    } else if (c == ')') {
+        if (statement->paren_depth > 0 && --statement->paren_depth == 0) statement->params_done = 1;
+    } else if (statement->paren_depth > 0) {
+        if (statement->params_done) return;
+        if (c == ',' && statement->paren_depth == 1) statement->param_commas++;
+        else if (c == '*' || c == '.') statement->param_seen = 1;
+    } else if (c == '=') {
+        statement->assigned = 1;
+    } else if (c == ';') {
+        stack_end_statement();
+    }
+}
+
+/* Defines the enum constant in stack_scan.word, at its own value if it is
+   given one; returns the end of that value */
+static const char *stack_enum_constant(const char *after) {
+    StackScan *scan = &stack_scan;
+    StackSymbol *constant;
+    const char *end = after;
+    LONG value = scan->enum_next;
+
+    if (*after == '=') {
+        end = after + 1 + strcspn(after + 1, ",}");
+        if (!stack_evaluate(after + 1, (size_t)(end - after - 1), &value)) value = -1;
+    }
+    if (value >= 0) {
+        constant = stack_symbol(scan->word, SYMBOL_DEFINE, 1);
+        if (constant) {
+            constant->value = value;
+            constant->flags |= SYMBOL_DEFINED;
+        }
+    }
+    scan->enum_next = value >= 0 ? value + 1 : -1;
+    return end;
+}
+
+/* A '{': the start of a function body, a struct or union, or something else */
+static void stack_open_brace(const char *filename) {
+    StackScan *scan = &stack_scan;
+    StackStatement *statement = &scan->statement;
+    StackSymbol *function;
+
+    if (scan->depth++ > 0) {
+        if (scan->block == BLOCK_RECORD) scan->record_unknown = 1; /* Nested struct or union */
+        return;
+    }
+    statement->tag_next = 0;
+    if (statement->name[0] && statement->params_done && !statement->assigned) {
+        scan->block = BLOCK_FUNCTION;
+        scan->frame = STACK_CALL_OVERHEAD;
+        if (statement->param_seen) scan->frame += (statement->param_commas + 1) * STACK_SLOT_SIZE;
+        scan->frame_unknown = 0;
+        function = stack_symbol(statement->name, SYMBOL_FUNCTION, 1);
+        if (function && !(function->flags & SYMBOL_DEFINED)) {
+            function->flags |= SYMBOL_DEFINED;
+            function->filename = stack_filename(filename);
+            function->line = statement->name_line;
+            stack_functions++;
+        }
+        scan->function = function;
+    } else if (statement->aggregate && !statement->assigned) {
+        scan->block = BLOCK_RECORD;
+        scan->record_size = 0;
+        scan->record_unknown = 0;
+    } else if (statement->enumeration && !statement->assigned) {
+        scan->block = BLOCK_ENUM;
+        scan->enum_next = 0;
+    } else {
+        scan->block = BLOCK_OTHER;
+    }
+}
+
+/* A '}': the end of a function body, or of a struct or union whose size is now known */
+static void stack_close_brace(void) {
+    StackScan *scan = &stack_scan;
+
+    if (scan->depth == 0 || --scan->depth > 0) return;
+    if (scan->block == BLOCK_FUNCTION) {
+        if (scan->function) {
+            /* A name defined twice, as static functions in two files may be, keeps the larger frame */
+            if (scan->frame > scan->function->value) scan->function->value = scan->frame;
+            if (scan->frame_unknown) scan->function->flags |= SYMBOL_SIZE_UNKNOWN;
+        }
+        scan->function = NULL;
+        stack_end_statement(); /* A body ends its statement without a ';' */
+    } else if (scan->block == BLOCK_RECORD) {
+        scan->record_size = (scan->record_size + STACK_ALIGN - 1) / STACK_ALIGN * STACK_ALIGN;
+        scan->statement.record_closed = 1;
+        if (scan->statement.tag[0]) {
+            stack_define_size(scan->statement.tag, SYMBOL_TAG, scan->record_size, scan->record_unknown);
+        }
+    }
+    scan->block = BLOCK_NONE;
+}
+
+/* The end of a statement at file scope; names a typedef'd struct, union or enum */
+static void stack_end_statement(void) {
+    StackScan *scan = &stack_scan;
+    StackStatement *statement = &scan->statement;
+
+    if (statement->typedef_seen && statement->last_word[0]) {
+        if (statement->record_closed) {
+            stack_define_size(statement->last_word, SYMBOL_TYPE, scan->record_size, scan->record_unknown);
+        } else if (statement->enumeration) {
+            stack_define_size(statement->last_word, SYMBOL_TYPE, STACK_SLOT_SIZE, 0);
+        }
+    }
+    memset(statement, 0, sizeof(*statement));
+}
+
+/* Records a call from the function being read to the one named in stack_scan.word */
+static void stack_add_call(int line_num, const char *filename) {
+    StackSymbol *caller = stack_scan.function;
+    StackSymbol *callee;
+    StackCall *call;
+
+    if (!caller) return;
+    callee = stack_symbol(stack_scan.word, SYMBOL_FUNCTION, 1);
+    if (!callee) return;
+    for (call = caller->calls; call; call = call->next) {
+        if (call->callee == callee) return;
+    }
+    call = arena_alloc(&stack_arena, sizeof(StackCall));
+    if (!call) {
+        stack_out_of_memory = 1;
+        return;
+    }
+    call->callee = callee;
+    call->filename = stack_filename(filename);
+    call->line = line_num;
+    call->next = caller->calls;
+    caller->calls = call;
+    callee->flags |= SYMBOL_CALLED;
+}
+
+/* Works out the worst case from every function root reaches, deepest first,
+   on an explicit path rather than by recursing; a call back into the path
+   is reported and left out of the depth */
+static void stack_search(StackSymbol *root, StackSymbol **path) {
+    char *message = line_context.message;
+    int top = 0;
+
+    if (root->state != SEARCH_NEW) return;
+    root->state = SEARCH_ACTIVE;
+    root->next_call = root->calls;
+    path[top++] = root;
+    while (top > 0) {
+        StackSymbol *function = path[top - 1];
+        StackCall *call = function->next_call;
+
+        if (call) {
+            StackSymbol *callee = call->callee;
+
+            function->next_call = call->next;
+            if (!(callee->flags & SYMBOL_DEFINED)) continue; /* Library or macro */
+            if (callee->state == SEARCH_ACTIVE) {
+                stack_recursive_calls++;
+                if (call->filename) {
+                    strncpy(message, "Recursive call to '", LARGE_MESSAGE_BUFFER_SIZE - 1);
+                    strncat(message, callee->name, LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                    strncat(message, "': the stack depth of the cycle has no bound.", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+                    add_error(call->filename, call->line, 1, ERROR_WARNING, message);
+                }
+            } else if (callee->state == SEARCH_NEW) {
+                callee->state = SEARCH_ACTIVE;
+                callee->next_call = callee->calls;
+                path[top++] = callee;
+            }
+            continue;
+        }
+
+        /* Every callee is done or on the path, so the worst case from here is known */
+        function->depth = function->value;
+        function->heaviest = NULL;
+        if (function->flags & SYMBOL_SIZE_UNKNOWN) function->flags |= SYMBOL_DEPTH_UNKNOWN;
+        for (call = function->calls; call; call = call->next) {
+            StackSymbol *callee = call->callee;
+
+            if (callee->state != SEARCH_DONE) continue;
+            if (callee->flags & SYMBOL_DEPTH_UNKNOWN) function->flags |= SYMBOL_DEPTH_UNKNOWN;
+            if (function->value + callee->depth > function->depth) {
+                function->depth = function->value + callee->depth;
+                function->heaviest = callee;
+            }
+        }
+        function->state = SEARCH_DONE;
+        top--;
+    }
+}
+
+/* Works out the worst case from main(), or from the deepest entry point
+   without it, and checks it against the stack; run once every file is read */
+static void stack_analyse(void) {
+    char *message = line_context.message;
+    StackSymbol **path;
+    StackSymbol *symbol;
+    LONG limit = stack_limit > 0 ? stack_limit : STACK_DEFAULT_CLI;
+    int pass;
+    int i;
+
+    if (!stack_buckets || stack_functions == 0) return;
+    current_rule = RULE_STACK;
+    path = arena_alloc(&stack_arena, (ULONG)stack_functions * sizeof(StackSymbol *));
+    if (!path) {
+        stack_out_of_memory = 1;
+        return;
+    }
+
+    symbol = stack_symbol("main", SYMBOL_FUNCTION, 0);
+    stack_from_main = symbol && (symbol->flags & SYMBOL_DEFINED);
+    if (stack_from_main) {
+        stack_root = symbol;
+        stack_search(symbol, path);
+    }
+    /* Other entry points, such as library vectors and hooks, then cycles nothing else calls */
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < STACK_HASH_SIZE; i++) {
+            for (symbol = stack_buckets[i]; symbol; symbol = symbol->next) {
+                if (symbol->kind != SYMBOL_FUNCTION || !(symbol->flags & SYMBOL_DEFINED)) continue;
+                if (pass == 0 && (symbol->flags & SYMBOL_CALLED)) continue;
+                stack_search(symbol, path);
+                /* Without main(), the deepest entry point stands in for it, or any function at all */
+                if (!stack_from_main && (pass == 0 || !stack_root) &&
+                    (!stack_root || symbol->depth > stack_root->depth)) {
+                    stack_root = symbol;
+                }
+            }
+        }
+    }
+    if (!stack_root || !stack_root->filename || stack_root->depth <= limit) return;
+
+    strncpy(message, "Worst-case stack depth of ", LARGE_MESSAGE_BUFFER_SIZE - 1);
+    if (stack_root->flags & SYMBOL_DEPTH_UNKNOWN) strncat(message, "at least ", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+    append_number(message, stack_root->depth);
+    strncat(message, " bytes from ", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+    strncat(message, stack_root->name, LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+    strncat(message, "() exceeds the ", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+    append_number(message, limit);
+    if (stack_limit > 0) {
+        strncat(message, " byte stack set by $STACK.", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+    } else {
+        strncat(message, " byte CLI default; set the stack size with a $STACK cookie.", LARGE_MESSAGE_BUFFER_SIZE - strlen(message) - 1);
+    }
+    add_error(stack_root->filename, stack_root->line, 1, ERROR_WARNING, message);
+}
+
+/* Whether a searched function is deeper than best and not shown yet */
+static int stack_chain_candidate(StackSymbol *symbol, StackSymbol *best, StackSymbol **shown, int count) {
+    int i;
+
+    if (symbol->state != SEARCH_DONE || !(symbol->flags & SYMBOL_DEFINED)) return 0;
+    if (best && symbol->depth <= best->depth) return 0;
+    for (i = 0; i < count; i++) {
+        if (shown[i] == symbol) return 0;
+    }
+    return 1;
+}
+
+/* The deepest chain not shown yet: through a callee of main(), or from an entry point without it */
+static StackSymbol *stack_next_chain(StackSymbol **shown, int count) {
+    StackSymbol *best = NULL;
+    StackSymbol *symbol;
+    StackCall *call;
+    int i;
+
+    if (stack_from_main) {
+        for (call = stack_root->calls; call; call = call->next) {
+            if (stack_chain_candidate(call->callee, best, shown, count)) best = call->callee;
+        }
+        return best;
+    }
+    for (i = 0; i < STACK_HASH_SIZE; i++) {
+        for (symbol = stack_buckets[i]; symbol; symbol = symbol->next) {
+            if (symbol->kind == SYMBOL_FUNCTION && !(symbol->flags & SYMBOL_CALLED) &&
+                stack_chain_candidate(symbol, best, shown, count)) {
+                best = symbol;
+            }
+        }
+    }
+    return best;
+}
+
+/* Prints one chain: its depth, then each function with its frame */
+static void print_stack_chain(StackSymbol *head, StackSymbol *first) {
+    StackSymbol *function;
+    LONG depth = first->depth + (head ? head->value : 0);
+    int unknown = (first->flags & SYMBOL_DEPTH_UNKNOWN) || (head && (head->flags & SYMBOL_SIZE_UNKNOWN));
+
+    Printf("  %6ld%s ", (LONG)depth, unknown ? "+" : " ");
+    if (head) Printf("%s (%ld%s) > ", head->name, (LONG)head->value, (head->flags & SYMBOL_SIZE_UNKNOWN) ? "+" : "");
+    for (function = first; function; function = function->heaviest) {
+        Printf("%s%s (%ld%s)", function == first ? "" : " > ", function->name, (LONG)function->value,
+               (function->flags & SYMBOL_SIZE_UNKNOWN) ? "+" : "");
+    }
+    Printf("\n");
+}
+
+/* Prints the STACKCHECK/S report after the issues */
+static void print_stack_report(void) {
+    StackSymbol *shown[STACK_CHAINS_SHOWN];
+    StackSymbol *chain;
+    int count = 0;
+
+    Printf("\n--- Stack Depth ---\n");
+    if (!stack_root) {
+        Printf("No function definitions found.\n");
+        return;
+    }
+    Printf("%ld functions defined, %ld recursive calls.\n", (LONG)stack_functions, (LONG)stack_recursive_calls);
+    Printf("Worst case from %s() at %s:%ld: %s%ld bytes.\n", stack_root->name,
+           stack_root->filename ? stack_root->filename : "?", (LONG)stack_root->line,
+           (stack_root->flags & SYMBOL_DEPTH_UNKNOWN) ? "at least " : "", (LONG)stack_root->depth);
+    if (stack_limit > 0) {
+        Printf("Stack: %ld bytes, set by $STACK at %s:%ld.\n", (LONG)stack_limit,
+               stack_cookie_file ? stack_cookie_file : "?", (LONG)stack_cookie_line);
+    } else {
+        Printf("Stack: %ld bytes, the CLI default; no $STACK cookie found.\n", (LONG)STACK_DEFAULT_CLI);
+    }
+    if (stack_out_of_memory) Printf("Warning: Not enough memory for the whole call graph, the figures are incomplete.\n");
+    Printf("Heaviest call chains in bytes, with each frame (+ marks a part of unknown size):\n");
+    while (count < STACK_CHAINS_SHOWN && (chain = stack_next_chain(shown, count)) != NULL) {
+        shown[count++] = chain;
+        print_stack_chain(stack_from_main ? stack_root : NULL, chain);
+    }
+    if (count == 0) print_stack_chain(NULL, stack_root);
+}
+
+/* ============================================================================ */
+/* TIMING AND METRICS */
+/* ============================================================================ */
+
+/* Opens timer.device so ReadEClock() can be used for timing */
+static int eclock_open(void) {
+    struct EClockVal now;
+
+    memset(&eclock_request, 0, sizeof(eclock_request));
+    if (OpenDevice(TIMERNAME, UNIT_ECLOCK, (struct IORequest *)&eclock_request, 0) != 0) {
+        return 0;
+    }
+    TimerBase = eclock_request.tr_node.io_Device;
+    eclock_freq = ReadEClock(&now);
+    return 1;
+}
+
+/* Closes timer.device again */
+static void eclock_close(void) {
+    if (TimerBase) {
+        CloseDevice((struct IORequest *)&eclock_request);
+        TimerBase = NULL;
+    }
+}
+
+/* Low 32 bits of the E-clock, enough for differences below about 1.5 hours */
+static ULONG eclock_now(void) {
+    struct EClockVal now;
+
+    ReadEClock(&now);
+    return now.ev_lo;
+}
+
+/* Converts E-clock ticks to microseconds without overflowing 32 bits */
+static ULONG eclock_to_us(ULONG ticks) {
+    ULONG seconds;
+    ULONG remainder;
+    ULONG milliseconds;
+
+    if (eclock_freq == 0) return 0;
+    seconds = ticks / eclock_freq;
+    remainder = ticks % eclock_freq;
+    milliseconds = (remainder * MICROSECONDS_PER_MILLISECOND) / eclock_freq;
+    remainder = (remainder * MICROSECONDS_PER_MILLISECOND) % eclock_freq;
+    return seconds * MICROSECONDS_PER_SECOND + milliseconds * MICROSECONDS_PER_MILLISECOND +
+           (remainder * MICROSECONDS_PER_MILLISECOND) / eclock_freq;
+}
+
+/* Marks the start of a stage */
+static void stage_begin(void) {
+#ifdef CODEX_PROFILE
+    if (counters_enabled) counters_read(stage_start_events);
+#endif
+    stage_start_ticks = eclock_now();
+}
+
+/* Charges the time (and events) since the last mark to a stage and starts the next */
+static void stage_end(StageId stage) {
+    StageCounter *counter = &stage_counters[stage];
+    ULONG now;
+#ifdef CODEX_PROFILE
+    double events[COUNTER_COUNT];
+    int i;
+#endif
+
+    now = eclock_now();
+    counter->ticks += now - stage_start_ticks;
+    stage_start_ticks = now;
+#ifdef CODEX_PROFILE
+    if (counters_enabled) {
+        counters_read(events);
+        for (i = 0; i < COUNTER_COUNT; i++) {
+            counter->events[i] += events[i] - stage_start_events[i];
+            stage_start_events[i] = events[i];
+        }
+    }
+#endif
+}
+
+/* Run time not charged to any stage: start-up and building the lookup index */
+static ULONG run_idle_ticks(void) {
+    ULONG staged = 0;
+    int i;
+
+    for (i = 0; i < STAGE_COUNT; i++) staged += stage_counters[i].ticks;
+    return run_ticks > staged ? run_ticks - staged : 0;
+}
+
+/* Records the running totals before a file is linted */
+static void telemetry_mark(FileTelemetry *mark) {
+    int i;
+
+    for (i = 0; i < STAGE_COUNT; i++) mark->ticks[i] = stage_counters[i].ticks;
+    mark->bytes = total_bytes;
+    mark->diagnostics = diagnostics_found;
+}
+
+/* Prints what linting one file cost, and how many files are still queued */
+static void print_file_telemetry(const char *filename, int lines, const FileTelemetry *start) {
+    Printf("  %s: %ld lines, %ld bytes, %ld issues; read %ld us, lint %ld us, finish %ld us",
+           filename, (LONG)lines, (LONG)(total_bytes - start->bytes),
+           (LONG)(diagnostics_found - start->diagnostics),
+           (LONG)eclock_to_us(stage_counters[STAGE_READ].ticks - start->ticks[STAGE_READ]),
+           (LONG)eclock_to_us(stage_counters[STAGE_LINT].ticks - start->ticks[STAGE_LINT]),
+           (LONG)eclock_to_us(stage_counters[STAGE_FINISH].ticks - start->ticks[STAGE_FINISH]));
+    if (files_queued > 0) Printf("; %ld of %ld files queued", (LONG)(files_queued - total_files), (LONG)files_queued);
+    Printf("\n");
+}
+
+/* Prints where the run's time went, after the summary (VERBOSE/S) */
+static void print_run_telemetry(void) {
+    ULONG run_ms = eclock_to_us(run_ticks) / MICROSECONDS_PER_MILLISECOND;
+
+    if (!stage_timing_enabled) return;
+    Printf("\n--- Run Telemetry ---\n");
+    Printf("Worker: busy %ld us (lint %ld, finish %ld), I/O wait %ld us, output %ld us, idle %ld us\n",
+           (LONG)eclock_to_us(stage_counters[STAGE_LINT].ticks + stage_counters[STAGE_FINISH].ticks),
+           (LONG)eclock_to_us(stage_counters[STAGE_LINT].ticks),
+           (LONG)eclock_to_us(stage_counters[STAGE_FINISH].ticks),
+           (LONG)eclock_to_us(stage_counters[STAGE_READ].ticks),
+           (LONG)eclock_to_us(stage_counters[STAGE_OUTPUT].ticks),
+           (LONG)eclock_to_us(run_idle_ticks()));
+    Printf("Processed %ld files, %ld lines, %ld bytes, %ld issues in %ld us",
+           (LONG)total_files, (LONG)total_lines, (LONG)total_bytes, (LONG)diagnostics_found,
+           (LONG)eclock_to_us(run_ticks));
+    if (run_ms > 0) {
+        Printf(" (%ld lines/s, %ld KB/s)", (LONG)((ULONG)total_lines * MICROSECONDS_PER_MILLISECOND / run_ms),
+               (LONG)(total_bytes / run_ms)); /* Bytes per ms is about KB per second */
+    }
+    Printf("\n");
+}
+
+/* Writes the # HELP and # TYPE lines that introduce a metric */
+static void metrics_write_header(BPTR file, const char *name, const char *type, const char *help) {
+    FPrintf(file, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/* Writes E-clock ticks as seconds */
+static void metrics_write_seconds(BPTR file, ULONG ticks) {
+    ULONG us = eclock_to_us(ticks);
+
+    FPrintf(file, "%ld.%06ld\n", (LONG)(us / MICROSECONDS_PER_SECOND), (LONG)(us % MICROSECONDS_PER_SECOND));
+}
+
+/* Writes part/whole with four decimals, 0 when whole is 0 */
+static void metrics_write_ratio(BPTR file, ULONG part, ULONG whole) {
+    ULONG scaled = 0;
+
+    /* Halve both until part * scale fits in 32 bits; part <= whole, so whole stays non-zero */
+    while (part > 0xFFFFFFFFUL / METRICS_RATIO_SCALE) {
+        part >>= 1;
+        whole >>= 1;
+    }
+    if (whole > 0) scaled = part * METRICS_RATIO_SCALE / whole;
+    FPrintf(file, "%ld.%04ld\n", (LONG)(scaled / METRICS_RATIO_SCALE), (LONG)(scaled % METRICS_RATIO_SCALE));
+}
+
+/* Writes the run's metrics in the Prometheus text format.  The file is written
+   under a temporary name and renamed when complete, so a collector never
+   reads half a file */
+static int metrics_write(const char *filename) {
+    static char temp_name[METRICS_NAME_MAX];
+    BPTR file;
+    int rule;
+    int type;
+    int i;
+
+    if (strlen(filename) + strlen(METRICS_TEMP_SUFFIX) >= sizeof(temp_name)) return 0;
+    strcpy(temp_name, filename);
+    strcat(temp_name, METRICS_TEMP_SUFFIX);
+    file = Open(temp_name, MODE_NEWFILE);
+    if (!file) return 0;
+
+    metrics_write_header(file, "codex_files_processed", "gauge", "Files linted in the last run.");
+    FPrintf(file, "codex_files_processed %ld\n", (LONG)total_files);
+    metrics_write_header(file, "codex_lines_processed", "gauge", "Lines linted in the last run.");
+    FPrintf(file, "codex_lines_processed %ld\n", (LONG)total_lines);
+    metrics_write_header(file, "codex_bytes_processed", "gauge", "Bytes of source read in the last run.");
+    FPrintf(file, "codex_bytes_processed %ld\n", (LONG)total_bytes);
+
+    metrics_write_header(file, "codex_diagnostics", "gauge", "Issues found, by rule and type, including any past the report limit.");
+    for (rule = 0; rule < RULE_COUNT; rule++) {
+        for (type = 0; type < ERROR_TYPE_COUNT; type++) {
+            FPrintf(file, "codex_diagnostics{rule=\"%s\",type=\"%s\"} %ld\n",
+                    rule_names[rule], error_type_names[type], (LONG)rule_diagnostics[rule][type]);
+        }
+    }
+
+    if (stage_timing_enabled) {
+        metrics_write_header(file, "codex_stage_duration_seconds", "gauge", "Time spent in each pipeline stage.");
+        for (i = 0; i < STAGE_COUNT; i++) {
+            FPrintf(file, "codex_stage_duration_seconds{stage=\"%s\"} ", stage_names[i]);
+            metrics_write_seconds(file, stage_counters[i].ticks);
+        }
+
+        /* Codex lints one file after another, so the one worker is busy
+           linting, waiting for input, writing the report, or doing none of
+           these (start-up and building the lookup index) */
+        metrics_write_header(file, "codex_worker_seconds", "gauge", "Time the worker spent in each state.");
+        FPrintf(file, "codex_worker_seconds{state=\"busy\"} ");
+        metrics_write_seconds(file, stage_counters[STAGE_LINT].ticks + stage_counters[STAGE_FINISH].ticks);
+        FPrintf(file, "codex_worker_seconds{state=\"io_wait\"} ");
+        metrics_write_seconds(file, stage_counters[STAGE_READ].ticks);
+        FPrintf(file, "codex_worker_seconds{state=\"output\"} ");
+        metrics_write_seconds(file, stage_counters[STAGE_OUTPUT].ticks);
+        FPrintf(file, "codex_worker_seconds{state=\"idle\"} ");
+        metrics_write_seconds(file, run_idle_ticks());
+        metrics_write_header(file, "codex_run_duration_seconds", "gauge", "Wall-clock time of the last run.");
+        FPrintf(file, "codex_run_duration_seconds ");
+        metrics_write_seconds(file, run_ticks);
+    }
+
+    /* The FAST engine's first-character index is the only lookup cache; a hit
+       is a probe that rules out every entry without comparing a string */
+    metrics_write_header(file, "codex_cache_lookups", "gauge", "Probes of each lookup cache.");
+    FPrintf(file, "codex_cache_lookups{cache=\"pattern_index\"} %ld\n", (LONG)index_probes);
+    metrics_write_header(file, "codex_cache_hit_ratio", "gauge", "Share of probes answered by the cache alone.");
+    FPrintf(file, "codex_cache_hit_ratio{cache=\"pattern_index\"} ");
+    metrics_write_ratio(file, index_probes - index_bucket_scans, index_probes);
+
+    metrics_write_header(file, "codex_heap_peak_bytes", "gauge", "Most heap memory Codex held at once.");
+    FPrintf(file, "codex_heap_peak_bytes %ld\n", (LONG)mem_heap_peak);
+    metrics_write_header(file, "codex_subsystem_heap_peak_bytes", "gauge", "Most heap memory each subsystem held at once.");
+    for (i = 0; i < MEM_SUBSYSTEM_COUNT; i++) {
+        FPrintf(file, "codex_subsystem_heap_peak_bytes{subsystem=\"%s\"} %ld\n",
+                mem_subsystem_names[i], (LONG)mem_counters[i].peak_bytes);
+    }
+
+    if (Close(file) == DOSFALSE) {
+        DeleteFile(temp_name);
+        return 0;
+    }
+    /* AmigaDOS Rename() will not replace an existing file */
+    if (!Rename(temp_name, filename)) {
+        DeleteFile(filename);
+        if (!Rename(temp_name, filename)) {
+            DeleteFile(temp_name);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+#ifdef CODEX_PROFILE
+/* ============================================================================ */
+/* PROFILING SUPPORT (CODEX_PROFILE builds only) */
+/* ============================================================================ */
+
+/* Starts measuring one rule invocation */
+static void profile_begin(RuleId rule) {
+    pattern_pending_count = 0;
+    profile_mark.rule = rule;
+    profile_mark.issues = issue_total();
+    profile_mark.timed = profile_enabled &&
+                         (profile_counters[rule].calls % PROFILE_SAMPLE_INTERVAL) == 0;
+    if (profile_mark.timed || trace_line_sampled) {
+        profile_mark.start = eclock_now();
+    }
+    if (profile_mark.timed && counters_enabled) counters_read(profile_mark.events);
+}
+
+/* Finishes the invocation started by profile_begin() */
+static void profile_end(ULONG bytes) {
+    ProfileCounter *counter = &profile_counters[profile_mark.rule];
+    double events[COUNTER_COUNT];
+    ULONG end = 0;
+    int i;
+
+    if (profile_mark.timed && counters_enabled) counters_read(events);
+    if (profile_mark.timed || trace_line_sampled) end = eclock_now();
+    if (trace_line_sampled) {
+        trace_add(rule_names[profile_mark.rule], TRACE_RULE, profile_mark.start, end);
+    }
+    if (!profile_enabled) return;
+
+    if (profile_mark.timed) {
+        counter->ticks += end - profile_mark.start;
+        counter->timed_calls++;
+        if (counters_enabled) {
+            for (i = 0; i < COUNTER_COUNT; i++) counter->events[i] += events[i] - profile_mark.events[i];
+        }
+    }
+    counter->calls++;
+    counter->bytes += bytes;
+    if (issue_total() > profile_mark.issues) counter->hits++;
+}
+
+
+/* Estimated ticks for all calls of a rule, scaling up sampled timings */
+static ULONG profile_estimated_ticks(const ProfileCounter *counter) {
+    if (counter->timed_calls == 0) return 0;
+    if (counter->timed_calls == counter->calls) return counter->ticks;
+    return (counter->ticks / counter->timed_calls) * counter->calls;
+}
+
+/* Prints the per-rule table, most expensive rule first */
+static void print_profile(void) {
+    int order[RULE_COUNT];
+    ULONG total_ticks = 0;
+    ULONG ticks;
+    int i;
+    int j;
+
+    for (i = 0; i < RULE_COUNT; i++) {
+        total_ticks += profile_estimated_ticks(&profile_counters[i]);
+        order[i] = i;
+    }
+
+    /* Insertion sort by estimated time, the table is tiny */
+    for (i = 1; i < RULE_COUNT; i++) {
+        int current = order[i];
+        ticks = profile_estimated_ticks(&profile_counters[current]);
+        for (j = i - 1; j >= 0 && profile_estimated_ticks(&profile_counters[order[j]]) < ticks; j--) {
+            order[j + 1] = order[j];
+        }
+        order[j + 1] = current;
+    }
+
+    Printf("\n--- Rule Profile ---\n");
+    Printf("%-20s %10s %8s %12s %12s %6s\n", "Rule", "Calls", "Hits", "Bytes", "Time (us)", "%Time");
+    for (i = 0; i < RULE_COUNT; i++) {
+        const ProfileCounter *counter = &profile_counters[order[i]];
+        LONG percent = 0;
+
+        if (counter->calls == 0) continue;
+        ticks = profile_estimated_ticks(counter);
+        if (total_ticks >= PERCENT_SCALE) percent = (LONG)(ticks / (total_ticks / PERCENT_SCALE));
+        Printf("%-20s %10ld %8ld %12ld %12ld %5ld%%\n", rule_names[order[i]],
+               (LONG)counter->calls, (LONG)counter->hits, (LONG)counter->bytes,
+               (LONG)eclock_to_us(ticks), percent);
+    }
+    Printf("Total rule time: %ld us", (LONG)eclock_to_us(total_ticks));
+    if (PROFILE_SAMPLE_INTERVAL > 1) {
+        Printf(" (1 in %ld calls timed, estimated)", (LONG)PROFILE_SAMPLE_INTERVAL);
+    }
+    Printf("\n");
+}
+
+/* Opens the hardware counters; returns 0 with a reason if there are none */
+static int counters_open(const char **reason) {
+#ifdef CODEX_HOST_BUILD
+    return host_counters_open(counter_available, reason) > 0;
+#else
+    int i;
+
+    /* AmigaOS has no performance counter interface; the stages are still timed */
+    for (i = 0; i < COUNTER_COUNT; i++) counter_available[i] = 0;
+    *reason = "no counters on this system";
+    return 0;
+#endif
+}
+
+/* Reads the running totals of all counters, 0 for those not available */
+static void counters_read(double events[COUNTER_COUNT]) {
+#ifdef CODEX_HOST_BUILD
+    host_counters_read(events);
+#else
+    int i;
+
+    for (i = 0; i < COUNTER_COUNT; i++) events[i] = 0.0;
+#endif
+}
+
+static void counters_close(void) {
+#ifdef CODEX_HOST_BUILD
+    host_counters_close();
+#endif
+}
+
+
+/* Prints a ratio in hundredths as "n.nn", or "-" if it cannot be computed */
+static void print_counter_ratio(double numerator, double denominator, double scale, int available) {
+    LONG hundredths;
+
+    if (!available || denominator <= 0.0) {
+        Printf(" %8s", "-");
+        return;
+    }
+    hundredths = (LONG)(numerator * scale * COUNTER_HUNDREDTHS / denominator + 0.5);
+    Printf(" %5ld.%02ld", hundredths / COUNTER_HUNDREDTHS, hundredths % COUNTER_HUNDREDTHS);
+}
+
+/* Prints the column headings of the counter table */
+static void print_counter_header(const char *first_column, int with_events) {
+    Printf("%-20s %10s", first_column, "Time (us)");
+    if (with_events) {
+        Printf(" %10s %10s %8s %8s %8s %8s", "Kcycles", "Kinstr", "IPC", "BrMiss%", "L1D/Ki", "LLC/Ki");
+    }
+    Printf("\n");
+}
+
+/* Prints one row of the counter table */
+static void print_counter_row(const char *name, ULONG ticks, const double *events, int with_events) {
+    const double *e = events;
+
+    Printf("%-20s %10ld", name, (LONG)eclock_to_us(ticks));
+    if (!with_events) {
+        Printf("\n");
+        return;
+    }
+    if (counter_available[COUNTER_CYCLES]) {
+        Printf(" %10ld", (LONG)(e[COUNTER_CYCLES] / COUNTER_SCALE));
+    } else {
+        Printf(" %10s", "-");
+    }
+    if (counter_available[COUNTER_INSTRUCTIONS]) {
+        Printf(" %10ld", (LONG)(e[COUNTER_INSTRUCTIONS] / COUNTER_SCALE));
+    } else {
+        Printf(" %10s", "-");
+    }
+    print_counter_ratio(e[COUNTER_INSTRUCTIONS], e[COUNTER_CYCLES], 1.0,
+                        counter_available[COUNTER_CYCLES] && counter_available[COUNTER_INSTRUCTIONS]);
+    print_counter_ratio(e[COUNTER_BRANCH_MISSES], e[COUNTER_BRANCHES], PERCENT_SCALE,
+                        counter_available[COUNTER_BRANCHES] && counter_available[COUNTER_BRANCH_MISSES]);
+    print_counter_ratio(e[COUNTER_L1D_MISSES], e[COUNTER_INSTRUCTIONS], COUNTER_SCALE,
+                        counter_available[COUNTER_INSTRUCTIONS] && counter_available[COUNTER_L1D_MISSES]);
+    print_counter_ratio(e[COUNTER_LLC_MISSES], e[COUNTER_INSTRUCTIONS], COUNTER_SCALE,
+                        counter_available[COUNTER_INSTRUCTIONS] && counter_available[COUNTER_LLC_MISSES]);
+    Printf("\n");
+}
+
+/* Prints time and hardware events per stage and, with PROFILE/S, per rule */
+static void print_counters(void) {
+    double total_events = 0.0;
+    int with_events;
+    int i;
+
+    /* Counters that opened but never counted (e.g. in a VM) are no better than none */
+    for (i = 0; i < STAGE_COUNT; i++) total_events += stage_counters[i].events[COUNTER_CYCLES];
+    with_events = total_events > 0.0;
+
+    Printf("\n--- Hardware Counters ---\n");
+    if (!with_events && counter_available[COUNTER_CYCLES]) {
+        Printf("The cycle counter did not count, showing time only\n");
+    }
+    print_counter_header("Stage", with_events);
+    for (i = 0; i < STAGE_COUNT; i++) {
+        print_counter_row(stage_names[i], stage_counters[i].ticks, stage_counters[i].events, with_events);
+    }
+    if (!profile_enabled || !with_events) return;
+
+    Printf("\n");
+    print_counter_header("Rule", with_events);
+    for (i = 0; i < RULE_COUNT; i++) {
+        const ProfileCounter *counter = &profile_counters[i];
+
+        if (counter->timed_calls == 0) continue;
+        print_counter_row(rule_names[i], counter->ticks, counter->events, with_events);
+    }
+    if (PROFILE_SAMPLE_INTERVAL > 1) {
+        Printf("Rule rows cover the timed calls only (1 in %ld)\n", (LONG)PROFILE_SAMPLE_INTERVAL);
+    }
+}
+
+/* Allocates the trace buffer; events are only written out at exit */
+static int trace_open(void) {
+    trace_events = mem_alloc(TRACE_MAX_EVENTS * sizeof(TraceEvent), MEMF_ANY, MEM_INSTRUMENTATION);
+    if (!trace_events) return 0;
+    trace_event_count = 0;
+    trace_dropped = 0;
+    trace_origin = eclock_now();
+    return 1;
+}
+
+/* Buffers one span; the name must stay valid until trace_write() */
+static void trace_add(const char *name, TraceCategory category, ULONG start, ULONG end) {
+    TraceEvent *event;
+
+    if (trace_event_count >= TRACE_MAX_EVENTS) {
+        trace_dropped++;
+        return;
+    }
+    event = &trace_events[trace_event_count++];
+    event->name = name;
+    event->category = category;
+    event->start = start - trace_origin;
+    event->duration = end - start;
+}
+
+/* Writes a JSON string literal, escaping what JSON requires */
+static void trace_write_string(BPTR file, const char *text) {
+    FPutC(file, '"');
+    while (*text) {
+        if (*text == '"' || *text == '\\') {
+            FPutC(file, '\\');
+            FPutC(file, *text);
+        } else if ((unsigned char)*text < ' ') {
+            FPrintf(file, "\\u%04lx", (LONG)(unsigned char)*text);
+        } else {
+            FPutC(file, *text);
+        }
+        text++;
+    }
+    FPutC(file, '"');
+}
+
+/* Writes the buffered events as Chrome trace-event JSON (Perfetto, chrome://tracing) */
+static int trace_write(const char *filename) {
+    static const char *category_names[] = { "file", "stage", "rule" };
+    BPTR file;
+    ULONG i;
+
+    file = Open(filename, MODE_NEWFILE);
+    if (!file) return 0;
+
+    FPuts(file, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"tool\":\"Codex\",");
+    FPrintf(file, "\"sample_interval\":%ld,\"dropped_events\":%ld},\"traceEvents\":[\n",
+            (LONG)trace_sample_interval, (LONG)trace_dropped);
+    FPuts(file, "{\"ph\":\"M\",\"pid\":1,\"tid\":1,\"name\":\"thread_name\",\"args\":{\"name\":\"Codex\"}}");
+    for (i = 0; i < trace_event_count; i++) {
+        const TraceEvent *event = &trace_events[i];
+
+        FPuts(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":1,\"name\":");
+        trace_write_string(file, event->name);
+        FPrintf(file, ",\"cat\":\"%s\",\"ts\":%ld,\"dur\":%ld}",
+                category_names[event->category],
+                (LONG)eclock_to_us(event->start), (LONG)eclock_to_us(event->duration));
+    }
+    FPuts(file, "\n]}\n");
+    return Close(file) != DOSFALSE;
+}
+
+/* Releases the trace buffer */
+static void trace_close(void) {
+    if (trace_events) {
+        mem_free(trace_events);
+        trace_events = NULL;
+    }
+}
+
+/* Lays out the per-pattern counters and allocates them */
+static int patstats_open(void) {
+    ULONG total = 0;
+    int i;
+
+    for (i = 0; i < PATTERN_TABLE_COUNT; i++) {
+        pattern_tables[i].base = total;
+        total += (ULONG)pattern_tables[i].count;
+    }
+    pattern_counters = mem_alloc(total * sizeof(PatternCounter), MEMF_ANY | MEMF_CLEAR, MEM_INSTRUMENTATION);
+    pattern_pending_count = 0;
+    return pattern_counters != NULL;
+}
+
+/* Counts a match and remembers it until the rule reports an issue or finishes */
+static void pattern_matched(ULONG counter) {
+    pattern_counters[counter].matched++;
+    if (pattern_pending_count < PATSTATS_MAX_PENDING) {
+        pattern_pending[pattern_pending_count++] = counter;
+    }
+}
+
+/* Credits the issue being added to the matches that preceded it in this rule */
+static void pattern_credit_diagnosis(void) {
+    int i;
+
+    if (!pattern_counters) return;
+    for (i = 0; i < pattern_pending_count; i++) {
+        pattern_counters[pattern_pending[i]].diagnosed++;
+    }
+    pattern_pending_count = 0;
+}
+
+/* Earlier pattern that keeps this one from ever matching first, or -1.
+   Lookups return on the first hit, so an exact duplicate is unreachable,
+   and in a strstr() table so is any entry containing an earlier entry. */
+static int pattern_shadowed_by(const PatternTable *table, int index, int *duplicate) {
+    int j;
+
+    for (j = 0; j < index; j++) {
+        if (strcmp(table->patterns[j], table->patterns[index]) == 0) {
+            *duplicate = 1;
+            return j;
+        }
+    }
+    if (table->substring) {
+        for (j = 0; j < index; j++) {
+            if (strstr(table->patterns[index], table->patterns[j])) {
+                *duplicate = 0;
+                return j;
+            }
+        }
+    }
+    return -1;
+}
+
+/* Prints every pattern of every table with its counters and pruning hints */
+static void print_pattern_stats(void) {
+    LONG total_patterns = 0;
+    LONG dead = 0;
+    LONG duplicates = 0;
+    LONG subsumed = 0;
+    LONG unreferenced = 0;
+    int i;
+    int j;
+
+    Printf("\n--- Pattern Statistics ---\n");
+    for (i = 0; i < PATTERN_TABLE_COUNT; i++) {
+        const PatternTable *table = &pattern_tables[i];
+        ULONG tested = 0;
+        ULONG matched = 0;
+
+        for (j = 0; j < table->count; j++) {
+            tested += pattern_counters[table->base + j].tested;
+            matched += pattern_counters[table->base + j].matched;
+        }
+        Printf("\n%s (%s, %ld patterns): ", table->name,
+               table->substring ? "substring" : "exact", (LONG)table->count);
+        if (!table->referenced) {
+            Printf("UNREFERENCED, no rule consults this table\n");
+        } else if (tested == 0) {
+            Printf("not consulted in the active modes\n");
+        } else {
+            Printf("%ld tests, %ld matches\n", (LONG)tested, (LONG)matched);
+        }
+        Printf("%4s  %-24s %10s %8s %9s  %s\n", "#", "Pattern", "Tested", "Matched", "Diagnosed", "Note");
+
+        for (j = 0; j < table->count; j++) {
+            const PatternCounter *counter = &pattern_counters[table->base + j];
+            int duplicate = 0;
+            int shadow = pattern_shadowed_by(table, j, &duplicate);
+
+            total_patterns++;
+            Printf("%4ld  %-24s %10ld %8ld %9ld  ", (LONG)j, table->patterns[j],
+                   (LONG)counter->tested, (LONG)counter->matched, (LONG)counter->diagnosed);
+            if (shadow >= 0 && duplicate) {
+                Printf("DUPLICATE of #%ld", (LONG)shadow);
+                duplicates++;
+            } else if (shadow >= 0) {
+                Printf("SUBSUMED by #%ld", (LONG)shadow);
+                subsumed++;
+            } else if (!table->referenced) {
+                Printf("unreferenced");
+            } else if (counter->tested > 0 && counter->matched == 0) {
+                Printf("DEAD");
+                dead++;
+            }
+            Printf("\n");
+        }
+        if (!table->referenced) unreferenced += table->count;
+    }
+    Printf("\n%ld patterns in %ld tables: %ld dead, %ld duplicate, %ld subsumed, %ld in unreferenced tables\n",
+           total_patterns, (LONG)PATTERN_TABLE_COUNT, dead, duplicates, subsumed, unreferenced);
+}
+
+/* Releases the pattern counters */
+static void patstats_close(void) {
+    if (pattern_counters) {
+        mem_free(pattern_counters);
+        pattern_counters = NULL;
+    }
+}
+#endif /* CODEX_PROFILE */
@@ -0,0 +1,52 @@
+/*
+ * Codex - fuzz target for whole-buffer linting
+ *
+ * Writes the input to a scratch file and lints it with process_file(), so
+ * the line reader, the draining of overlong lines and the end-of-file
+ * checks are fuzzed together with the rules.
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "fuzzcommon.h"
+
+#define FUZZ_SCRATCH_FORMAT "/tmp/codex-fuzz-%ld.c"
+
+static void fuzz_run(const char *text, size_t size) {
+    static char scratch[FUZZ_MAX_PATH];
+    FILE *file;
+
+    if (!scratch[0]) sprintf(scratch, FUZZ_SCRATCH_FORMAT, (long)getpid());
+    file = fopen(scratch, "wb");
+    if (!file) {
+        fprintf(stderr, "fuzz: cannot write '%s'\n", scratch);
+        abort();
+    }
+    fwrite(text, 1, size, file);
+    fclose(file);
+    process_file(scratch);
+    remove(scratch);
+}
@@ -0,0 +1,322 @@
+/*
+ * Codex - shared part of the fuzz targets
+ *
+ * Each target includes this file, which includes codex.c, and defines
+ * fuzz_run() to lint one input.  The first byte of an input selects the
+ * validation mode and the rest is the source text.  Every input must
+ * finish within a time limit that grows with its size, so a superlinear
+ * rule is reported as a finding (abort()) rather than just running slow.
+ *
+ * Built with clang -fsanitize=fuzzer,address -DFUZZ_LIBFUZZER, libFuzzer
+ * provides main().  Otherwise the replay main() below runs the targets on
+ * saved inputs, writes the seed corpus and can run a simple mutation loop
+ * on hosts without libFuzzer.
+ *
+ * Host build only (VMakefile: make -f VMakefile fuzz, fuzz-replay).
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FUZZCOMMON_H
+#define FUZZCOMMON_H
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "../codex.c"
+#undef main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Time allowed per input: a fixed start-up part plus a part per kilobyte.
+   Normal code lints at well under 1 ms/KB even under AddressSanitizer. */
+#ifndef FUZZ_BASE_MS
+#define FUZZ_BASE_MS 100.0
+#endif
+#ifndef FUZZ_MS_PER_KB
+#define FUZZ_MS_PER_KB 10.0
+#endif
+#define FUZZ_TIME_SCALE_ENV "CODEX_FUZZ_TIME_SCALE" /* Multiplies both, for slow builds */
+
+#define FUZZ_MODE_COUNT 9
+#define FUZZ_MAX_INPUT 1048576L
+#define FUZZ_MAX_MUTATIONS 8
+#define FUZZ_MAX_PATH 512
+#define FUZZ_LAST_INPUT "last-input.fuzz" /* Each mutant is saved here before it runs */
+#define FUZZ_BYTES_PER_KB 1024.0
+#define NANOSECONDS_PER_MILLISECOND 1e6
+
+/* Each mode as main() resolves it: C89, C99, AMIGA, NDK, SASC, VBCC, DICE, MEMSAFE, ALL */
+static const char *fuzz_mode_names[FUZZ_MODE_COUNT] = {
+    "C89", "C99", "AMIGA", "NDK", "SASC", "VBCC", "DICE", "MEMSAFE", "ALL"
+};
+static const int fuzz_mode_flags[FUZZ_MODE_COUNT][8] = {
+    { 0, 0, 1, 0, 0, 0, 0, 0 },
+    { 0, 0, 0, 1, 0, 0, 0, 0 },
+    { 1, 1, 1, 0, 0, 0, 0, 0 },
+    { 0, 1, 1, 0, 0, 0, 0, 0 },
+    { 0, 1, 1, 0, 1, 0, 0, 0 },
+    { 0, 1, 0, 1, 0, 1, 0, 0 },
+    { 0, 1, 1, 0, 0, 0, 1, 0 },
+    { 0, 0, 1, 0, 0, 0, 0, 1 },
+    { 1, 1, 1, 1, 1, 1, 1, 1 }
+};
+
+static int fuzz_ready = 0;
+static double fuzz_time_scale = 1.0;
+static double fuzz_slowest_ms_per_kb = 0.0;
+
+/* Lints one input's source text; defined by each target */
+static void fuzz_run(const char *text, size_t size);
+
+int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size);
+
+static double fuzz_now_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / NANOSECONDS_PER_MILLISECOND;
+}
+
+static void fuzz_set_mode(int mode) {
+    const int *flags = fuzz_mode_flags[mode];
+
+    validate_amiga_standards = flags[0];
+    validate_ndk_standards = flags[1];
+    validate_c89_standards = flags[2];
+    validate_c99_standards = flags[3];
+    validate_sasc_standards = flags[4];
+    validate_vbcc_standards = flags[5];
+    validate_dice_standards = flags[6];
+    validate_memsafe_standards = flags[7];
+    enforce_amiga_pascalcase = flags[0];
+}
+
+/* Codex reports on stdout; the fuzzer only needs its own messages on stderr */
+static void fuzz_setup(void) {
+    const char *scale = getenv(FUZZ_TIME_SCALE_ENV);
+    int null_fd;
+
+    if (fuzz_ready) return;
+    fuzz_ready = 1;
+    if (scale && atof(scale) > 0) fuzz_time_scale = atof(scale);
+    quiet_mode = 1;
+    engine_open();
+    fflush(stdout);
+    null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) {
+        dup2(null_fd, STDOUT_FILENO);
+        close(null_fd);
+    }
+}
+
+int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size) {
+    double start;
+    double elapsed;
+    double limit;
+    int mode;
+
+    if (size < 1 || (long)size > FUZZ_MAX_INPUT) return 0;
+    fuzz_setup();
+    mode = data[0] % FUZZ_MODE_COUNT;
+    fuzz_set_mode(mode);
+    error_count = 0;
+
+    start = fuzz_now_ms();
+    fuzz_run((const char *)data + 1, size - 1);
+    elapsed = fuzz_now_ms() - start;
+
+    limit = fuzz_time_scale * (FUZZ_BASE_MS + FUZZ_MS_PER_KB * (double)size / FUZZ_BYTES_PER_KB);
+    if (elapsed * FUZZ_BYTES_PER_KB / (double)size > fuzz_slowest_ms_per_kb) {
+        fuzz_slowest_ms_per_kb = elapsed * FUZZ_BYTES_PER_KB / (double)size;
+    }
+    if (elapsed > limit) {
+        fprintf(stderr, "fuzz: %s input of %lu bytes took %.1f ms, limit %.1f ms\n",
+                fuzz_mode_names[mode], (unsigned long)size, elapsed, limit);
+        abort();
+    }
+    return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+
+static unsigned char fuzz_input[FUZZ_MAX_INPUT];
+static unsigned char fuzz_mutant[FUZZ_MAX_INPUT];
+static unsigned long fuzz_random_state = 1;
+
+static unsigned long fuzz_random(void) {
+    fuzz_random_state = fuzz_random_state * 1103515245UL + 12345UL;
+    return (fuzz_random_state >> 16) & 0x7fffUL;
+}
+
+static long fuzz_read(const char *filename, unsigned char *buffer, long size) {
+    FILE *file = fopen(filename, "rb");
+    long length;
+
+    if (!file) {
+        fprintf(stderr, "fuzz: cannot open '%s'\n", filename);
+        return -1;
+    }
+    length = (long)fread(buffer, 1, (size_t)size, file);
+    fclose(file);
+    return length;
+}
+
+static int fuzz_save(const char *filename, const unsigned char *data, long length) {
+    FILE *file = fopen(filename, "wb");
+
+    if (!file) {
+        fprintf(stderr, "fuzz: cannot write '%s'\n", filename);
+        return 0;
+    }
+    fwrite(data, 1, (size_t)length, file);
+    fclose(file);
+    return 1;
+}
+
+/* Writes one seed per mode for every file: the mode byte, then the file */
+static int fuzz_make_seeds(const char *directory, int file_count, char **files) {
+    char path[FUZZ_MAX_PATH];
+    int mode;
+    int f;
+
+    for (f = 0; f < file_count; f++) {
+        const char *base = strrchr(files[f], '/') ? strrchr(files[f], '/') + 1 : files[f];
+        long length = fuzz_read(files[f], fuzz_input + 1, FUZZ_MAX_INPUT - 1);
+
+        if (length < 0) return 1;
+        for (mode = 0; mode < FUZZ_MODE_COUNT; mode++) {
+            sprintf(path, "%.400s/%s-%.60s", directory, fuzz_mode_names[mode], base);
+            fuzz_input[0] = (unsigned char)mode;
+            if (!fuzz_save(path, fuzz_input, length + 1)) return 1;
+        }
+    }
+    fprintf(stderr, "fuzz: wrote %d seeds to %s\n", file_count * FUZZ_MODE_COUNT, directory);
+    return 0;
+}
+
+/* Flips, inserts, deletes or repeats a few bytes; returns the new length */
+static long fuzz_mutate(const unsigned char *from, long length) {
+    static const char interesting[] = "{}()[];/*\"'\\\n\r\t #<>=,";
+    int mutations = 1 + (int)(fuzz_random() % FUZZ_MAX_MUTATIONS);
+    int i;
+
+    memcpy(fuzz_mutant, from, (size_t)length);
+    for (i = 0; i < mutations; i++) {
+        long at = length > 1 ? 1 + (long)(fuzz_random() % (unsigned long)(length - 1)) : 1;
+        long span = 1 + (long)(fuzz_random() % 64);
+
+        switch (fuzz_random() % 4) {
+        case 0: /* Overwrite with a byte that matters to the lexer, or any byte */
+            if (at < length) {
+                fuzz_mutant[at] = (fuzz_random() & 1) ? (unsigned char)interesting[fuzz_random() % (sizeof(interesting) - 1)]
+                                                      : (unsigned char)fuzz_random();
+            }
+            break;
+        case 1: /* Insert one byte */
+            if (length < FUZZ_MAX_INPUT) {
+                memmove(fuzz_mutant + at + 1, fuzz_mutant + at, (size_t)(length - at));
+                fuzz_mutant[at] = (unsigned char)interesting[fuzz_random() % (sizeof(interesting) - 1)];
+                length++;
+            }
+            break;
+        case 2: /* Delete a span */
+            if (at + span <= length) {
+                memmove(fuzz_mutant + at, fuzz_mutant + at + span, (size_t)(length - at - span));
+                length -= span;
+            }
+            break;
+        default: /* Repeat a span, which grows nesting and token runs */
+            if (at + span <= length && length + span <= FUZZ_MAX_INPUT) {
+                memmove(fuzz_mutant + at + span, fuzz_mutant + at, (size_t)(length - at));
+                length += span;
+            }
+            break;
+        }
+    }
+    fuzz_mutant[0] = (unsigned char)(fuzz_random() % FUZZ_MODE_COUNT);
+    return length;
+}
+
+static void fuzz_usage(const char *name) {
+    fprintf(stderr, "Usage: %s FILES...\n", name);
+    fprintf(stderr, "       %s -make-seeds DIR FILES...\n", name);
+    fprintf(stderr, "       %s -mutate N [-seed S] FILES...\n\n", name);
+    fprintf(stderr, "  FILES         Inputs to replay: a mode byte, then the source text\n");
+    fprintf(stderr, "  -make-seeds   Write each file as a seed input for every mode\n");
+    fprintf(stderr, "  -mutate N     Run N random mutations of the inputs, each saved to %s first\n", FUZZ_LAST_INPUT);
+    fprintf(stderr, "Set %s to scale the time limit for slow builds.\n", FUZZ_TIME_SCALE_ENV);
+}
+
+int main(int argc, char **argv) {
+    long mutations = 0;
+    int first = 1;
+    int f;
+
+    if (argc > 2 && strcmp(argv[1], "-make-seeds") == 0) {
+        return fuzz_make_seeds(argv[2], argc - 3, argv + 3);
+    }
+    while (first + 1 < argc && argv[first][0] == '-') {
+        if (strcmp(argv[first], "-mutate") == 0) mutations = atol(argv[first + 1]);
+        else if (strcmp(argv[first], "-seed") == 0) fuzz_random_state = (unsigned long)atol(argv[first + 1]);
+        else break;
+        first += 2;
+    }
+    if (first >= argc || argv[first][0] == '-') {
+        fuzz_usage(argv[0]);
+        return 1;
+    }
+
+    for (f = first; f < argc; f++) {
+        long length = fuzz_read(argv[f], fuzz_input, FUZZ_MAX_INPUT);
+        if (length < 0) return 1;
+        LLVMFuzzerTestOneInput(fuzz_input, (size_t)length);
+    }
+    if (mutations > 0) {
+        long i;
+
+        for (i = 0; i < mutations; i++) {
+            const char *source = argv[first + (int)(fuzz_random() % (unsigned long)(argc - first))];
+            long length = fuzz_read(source, fuzz_input, FUZZ_MAX_INPUT);
+
+            if (length < 0) return 1;
+            length = fuzz_mutate(fuzz_input, length);
+            if (!fuzz_save(FUZZ_LAST_INPUT, fuzz_mutant, length)) return 1;
+            LLVMFuzzerTestOneInput(fuzz_mutant, (size_t)length);
+        }
+        remove(FUZZ_LAST_INPUT);
+    }
+    fprintf(stderr, "%s: %d inputs and %ld mutations passed, slowest %.2f ms/KB\n", argv[0], argc - first,
+            mutations, fuzz_slowest_ms_per_kb);
+    return 0;
+}
+
+#endif /* FUZZ_LIBFUZZER */
+
+#endif /* FUZZCOMMON_H */
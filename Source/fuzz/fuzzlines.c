@@ -0,0 +1,58 @@
+/*
+ * Codex - fuzz target for process_line() sequences
+ *
+ * Splits the input into lines the way process_file() reads them and feeds
+ * them to process_line() one by one, then runs the end-of-file checks.
+ * No file I/O is involved, so every byte of the input reaches the rules.
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "fuzzcommon.h"
+
+#define FUZZ_FILENAME "fuzz.c"
+
+static void fuzz_run(const char *text, size_t size) {
+    static char line[MAX_LINE_LENGTH];
+    const char *end = text + size;
+    int line_num = 0;
+
+    memset(&parse_state, 0, sizeof(parse_state));
+    while (text < end) {
+        const char *newline = memchr(text, '\n', (size_t)(end - text));
+        const char *stop = newline ? newline : end;
+        size_t length = (size_t)(stop - text);
+
+        /* Overlong lines are cut like FGets() into the line buffer cuts them */
+        if (length > MAX_LINE_LENGTH - 1) length = MAX_LINE_LENGTH - 1;
+        memcpy(line, text, length);
+        line[length] = '\0';
+        line[strcspn(line, "\r")] = '\0';
+        process_line(line, ++line_num, FUZZ_FILENAME);
+        text = newline ? newline + 1 : end;
+    }
+    finish_file(FUZZ_FILENAME, line_num);
+}
@@ -0,0 +1,586 @@
+/*
+ * Codex - host build support
+ *
+ * POSIX implementations of the AmigaOS calls declared in amiga_host.h.
+ * Files are stdio streams, ReadArgs() understands the subset of the
+ * template syntax Codex uses (/A /K /M /N /S) and the E-clock is backed
+ * by CLOCK_MONOTONIC at a nominal 1 MHz.  On Linux the hardware
+ * performance counters come from perf_event_open().
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#define _DEFAULT_SOURCE /* syscall() */
+
+#include "amiga_host.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <time.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define HOST_MAX_TEMPLATE_ITEMS 64
+#define HOST_MAX_ITEM_NAME 32
+#define HOST_ECLOCK_FREQ 1000000UL
+#define HOST_MEMORY_SIZE 0x40000000UL /* Notional 1 GB that AvailMem() reports against */
+#define HOST_MAXRSS_UNIT 1024UL       /* ru_maxrss is in kilobytes on Linux */
+
+/* One parsed template item, e.g. "FILES/M/A" */
+typedef struct {
+    char names[HOST_MAX_ITEM_NAME]; /* '=' separated aliases */
+    int is_switch;
+    int is_keyword;
+    int is_number;
+    int is_multi;
+    int is_required;
+    int filled;
+} HostTemplateItem;
+
+/* Everything ReadArgs() allocated, released by FreeArgs() */
+struct RDArgs {
+    char **multi;
+    LONG *numbers;
+};
+
+static int host_argc = 0;
+static char **host_argv = NULL;
+
+/* Called by the host main() before handing over to Codex */
+void host_set_args(int argc, char **argv)
+{
+    host_argc = argc;
+    host_argv = argv;
+}
+
+/* Amiga Printf() formats are C formats with 32-bit %ld; LONG is long here */
+LONG Printf(CONST_STRPTR format, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, format);
+    n = vprintf(format, ap);
+    va_end(ap);
+    return n;
+}
+
+LONG FPrintf(BPTR fh, CONST_STRPTR format, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, format);
+    n = vfprintf((FILE *)fh, format, ap);
+    va_end(ap);
+    return n;
+}
+
+static int host_name_matches(const char *names, const char *word, size_t word_len)
+{
+    const char *p = names;
+
+    while (*p) {
+        const char *end = strchr(p, '=');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        size_t i;
+
+        if (len == word_len) {
+            for (i = 0; i < len; i++) {
+                if (toupper((unsigned char)p[i]) != toupper((unsigned char)word[i])) break;
+            }
+            if (i == len) return 1;
+        }
+        if (!end) break;
+        p = end + 1;
+    }
+    return 0;
+}
+
+static int host_parse_template(CONST_STRPTR template, HostTemplateItem *items)
+{
+    int count = 0;
+    const char *p = template;
+
+    while (*p && count < HOST_MAX_TEMPLATE_ITEMS) {
+        HostTemplateItem *item = &items[count];
+        size_t n = 0;
+
+        memset(item, 0, sizeof(*item));
+        while (*p && *p != ',' && *p != '/') {
+            if (n < sizeof(item->names) - 1) item->names[n++] = *p;
+            p++;
+        }
+        item->names[n] = '\0';
+        while (*p == '/') {
+            switch (toupper((unsigned char)p[1])) {
+                case 'S': item->is_switch = 1; break;
+                case 'K': item->is_keyword = 1; break;
+                case 'N': item->is_number = 1; break;
+                case 'M': item->is_multi = 1; break;
+                case 'A': item->is_required = 1; break;
+                default: break;
+            }
+            p += 2;
+        }
+        if (*p == ',') p++;
+        count++;
+    }
+    return count;
+}
+
+static int host_store_value(struct RDArgs *rda, HostTemplateItem *item, LONG *slot, int index, char *value)
+{
+    if (item->is_number) {
+        char *end;
+        rda->numbers[index] = strtol(value, &end, 10);
+        if (*end) return 0;
+        *slot = (LONG)&rda->numbers[index];
+    } else {
+        *slot = (LONG)value;
+    }
+    item->filled = 1;
+    return 1;
+}
+
+struct RDArgs *ReadArgs(CONST_STRPTR template, LONG *array, struct RDArgs *args)
+{
+    HostTemplateItem items[HOST_MAX_TEMPLATE_ITEMS];
+    struct RDArgs *rda;
+    int item_count;
+    int multi_item = -1;
+    int multi_count = 0;
+    int i;
+    int j;
+
+    (void)args;
+    item_count = host_parse_template(template, items);
+
+    rda = calloc(1, sizeof(*rda));
+    if (!rda) return NULL;
+    rda->multi = calloc((size_t)host_argc + 1, sizeof(char *));
+    rda->numbers = calloc(HOST_MAX_TEMPLATE_ITEMS, sizeof(LONG));
+    if (!rda->multi || !rda->numbers) {
+        FreeArgs(rda);
+        return NULL;
+    }
+
+    for (j = 0; j < item_count; j++) {
+        if (items[j].is_multi) multi_item = j;
+    }
+
+    for (i = 1; i < host_argc; i++) {
+        char *arg = host_argv[i];
+        char *equals = strchr(arg, '=');
+        size_t name_len = equals ? (size_t)(equals - arg) : strlen(arg);
+        int matched = -1;
+
+        for (j = 0; j < item_count; j++) {
+            if (host_name_matches(items[j].names, arg, name_len)) {
+                matched = j;
+                break;
+            }
+        }
+
+        if (matched >= 0 && items[matched].is_switch && !equals) {
+            array[matched] = DOSTRUE;
+            items[matched].filled = 1;
+            continue;
+        }
+        if (matched >= 0 && !items[matched].is_switch && !items[matched].is_multi) {
+            char *value = equals ? equals + 1 : NULL;
+            if (!value) {
+                if (i + 1 >= host_argc) goto fail;
+                value = host_argv[++i];
+            }
+            if (!host_store_value(rda, &items[matched], &array[matched], matched, value)) goto fail;
+            continue;
+        }
+
+        /* Positional argument: first unfilled plain item, else the /M item */
+        for (j = 0; j < item_count; j++) {
+            if (!items[j].filled && !items[j].is_switch && !items[j].is_keyword && !items[j].is_multi) break;
+        }
+        if (j < item_count) {
+            if (!host_store_value(rda, &items[j], &array[j], j, arg)) goto fail;
+        } else if (multi_item >= 0) {
+            rda->multi[multi_count++] = arg;
+            items[multi_item].filled = 1;
+        } else {
+            goto fail;
+        }
+    }
+
+    if (multi_item >= 0 && multi_count > 0) {
+        array[multi_item] = (LONG)rda->multi;
+    }
+    for (j = 0; j < item_count; j++) {
+        if (items[j].is_required && !items[j].filled) goto fail;
+    }
+    return rda;
+
+fail:
+    FreeArgs(rda);
+    return NULL;
+}
+
+void FreeArgs(struct RDArgs *args)
+{
+    if (!args) return;
+    free(args->multi);
+    free(args->numbers);
+    free(args);
+}
+
+BPTR Open(CONST_STRPTR name, LONG mode)
+{
+    const char *fmode = "rb";
+
+    if (mode == MODE_NEWFILE) fmode = "wb";
+    else if (mode == MODE_READWRITE) fmode = "r+b";
+    return (BPTR)fopen(name, fmode);
+}
+
+LONG Close(BPTR fh)
+{
+    if (!fh) return DOSTRUE;
+    return fclose((FILE *)fh) == 0 ? DOSTRUE : DOSFALSE;
+}
+
+STRPTR FGets(BPTR fh, STRPTR buf, ULONG len)
+{
+    return fgets(buf, (int)len, (FILE *)fh);
+}
+
+LONG FPuts(BPTR fh, CONST_STRPTR str)
+{
+    /* Like dos.library, 0 on success and -1 on error */
+    return fputs(str, (FILE *)fh) < 0 ? -1 : 0;
+}
+
+LONG FPutC(BPTR fh, LONG ch)
+{
+    return fputc((int)ch, (FILE *)fh) == EOF ? -1 : ch;
+}
+
+LONG Read(BPTR fh, APTR buffer, LONG length)
+{
+    size_t n = fread(buffer, 1, (size_t)length, (FILE *)fh);
+    if (n == 0 && ferror((FILE *)fh)) return -1;
+    return (LONG)n;
+}
+
+LONG Write(BPTR fh, CONST APTR buffer, LONG length)
+{
+    size_t n = fwrite(buffer, 1, (size_t)length, (FILE *)fh);
+    return n == (size_t)length ? length : -1;
+}
+
+LONG Flush(BPTR fh)
+{
+    return fflush((FILE *)fh) == 0 ? DOSTRUE : DOSFALSE;
+}
+
+BPTR Output(void)
+{
+    return (BPTR)stdout;
+}
+
+LONG Rename(CONST_STRPTR old_name, CONST_STRPTR new_name)
+{
+    return rename(old_name, new_name) == 0 ? DOSTRUE : DOSFALSE;
+}
+
+LONG DeleteFile(CONST_STRPTR name)
+{
+    return remove(name) == 0 ? DOSTRUE : DOSFALSE;
+}
+
+APTR AllocVec(ULONG size, ULONG flags)
+{
+    if (flags & MEMF_CLEAR) return calloc(1, size ? size : 1);
+    return malloc(size ? size : 1);
+}
+
+void FreeVec(APTR memory)
+{
+    free(memory);
+}
+
+/* A pool keeps its blocks on a list so that DeletePool() can free them all;
+   the 16-byte link keeps the caller's block aligned as malloc() left it */
+typedef union HostPoolBlock {
+    struct {
+        union HostPoolBlock *next;
+        union HostPoolBlock *prev;
+    } link;
+    double align[2];
+} HostPoolBlock;
+
+typedef struct {
+    HostPoolBlock *blocks;
+    ULONG requirements;
+} HostPool;
+
+APTR CreatePool(ULONG requirements, ULONG puddle_size, ULONG threshold_size)
+{
+    HostPool *pool;
+
+    /* exec.library fails a threshold above the puddle size */
+    if (threshold_size > puddle_size) return NULL;
+    pool = malloc(sizeof(HostPool));
+    if (!pool) return NULL;
+    pool->blocks = NULL;
+    pool->requirements = requirements;
+    return pool;
+}
+
+void DeletePool(APTR pool)
+{
+    HostPool *host_pool = pool;
+    HostPoolBlock *block;
+
+    if (!host_pool) return;
+    while ((block = host_pool->blocks) != NULL) {
+        host_pool->blocks = block->link.next;
+        free(block);
+    }
+    free(host_pool);
+}
+
+APTR AllocPooled(APTR pool, ULONG size)
+{
+    HostPool *host_pool = pool;
+    HostPoolBlock *block;
+
+    if (host_pool->requirements & MEMF_CLEAR) block = calloc(1, sizeof(HostPoolBlock) + size);
+    else block = malloc(sizeof(HostPoolBlock) + size);
+    if (!block) return NULL;
+    block->link.prev = NULL;
+    block->link.next = host_pool->blocks;
+    if (host_pool->blocks) host_pool->blocks->link.prev = block;
+    host_pool->blocks = block;
+    return block + 1;
+}
+
+void FreePooled(APTR pool, APTR memory, ULONG size)
+{
+    HostPool *host_pool = pool;
+    HostPoolBlock *block;
+
+    (void)size;
+    if (!memory) return;
+    block = (HostPoolBlock *)memory - 1;
+    if (block->link.prev) block->link.prev->link.next = block->link.next;
+    else host_pool->blocks = block->link.next;
+    if (block->link.next) block->link.next->link.prev = block->link.prev;
+    free(block);
+}
+
+/* There is no free-memory list to walk, so report the notional memory size
+   less the peak resident set; drops in the result then track how far the
+   process has grown, which is what Codex uses it for */
+ULONG AvailMem(ULONG requirements)
+{
+    struct rusage usage;
+    ULONG resident;
+
+    (void)requirements;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return HOST_MEMORY_SIZE;
+    resident = (ULONG)usage.ru_maxrss * HOST_MAXRSS_UNIT;
+    return resident < HOST_MEMORY_SIZE ? HOST_MEMORY_SIZE - resident : 0;
+}
+
+static struct Device host_timer_device;
+
+LONG OpenDevice(CONST_STRPTR name, ULONG unit, struct IORequest *io, ULONG flags)
+{
+    (void)unit;
+    (void)flags;
+    if (strcmp(name, TIMERNAME) != 0) return -1;
+    io->io_Device = &host_timer_device;
+    return 0;
+}
+
+void CloseDevice(struct IORequest *io)
+{
+    io->io_Device = NULL;
+}
+
+ULONG ReadEClock(struct EClockVal *dest)
+{
+    struct timespec ts;
+
+    /* ULONG is 64 bits wide here, so the whole count fits in ev_lo */
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    dest->ev_hi = 0;
+    dest->ev_lo = (ULONG)ts.tv_sec * HOST_ECLOCK_FREQ + (ULONG)ts.tv_nsec / 1000UL;
+    return HOST_ECLOCK_FREQ;
+}
+
+#ifdef __linux__
+
+/* perf_event_open() type and config of each counter, in host_counters order */
+static const struct {
+    __u32 type;
+    __u64 config;
+} host_counter_events[HOST_COUNTER_COUNT] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES }
+};
+
+static int host_counter_fds[HOST_COUNTER_COUNT];
+static int host_counter_slots[HOST_COUNTER_COUNT]; /* Position in the group read, -1 if not open */
+static int host_counter_leader = -1;
+
+/* Why perf_event_open() refused a counter, in the user's terms */
+static const char *host_counter_error(int error)
+{
+    switch (error) {
+    case ENOENT:
+    case EOPNOTSUPP:
+        return "not supported by this CPU or virtual machine";
+    case EACCES:
+    case EPERM:
+        return "not permitted, see /proc/sys/kernel/perf_event_paranoid";
+    case ENOSYS:
+        return "kernel built without perf events";
+    default:
+        return strerror(error);
+    }
+}
+
+/* Opens every counter the kernel and CPU allow as one group; returns how many */
+int host_counters_open(int available[HOST_COUNTER_COUNT], const char **reason)
+{
+    struct perf_event_attr attr;
+    int opened = 0;
+    int i;
+
+    *reason = NULL;
+    for (i = 0; i < HOST_COUNTER_COUNT; i++) {
+        int fd;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = host_counter_events[i].type;
+        attr.config = host_counter_events[i].config;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = host_counter_leader < 0; /* The group starts when the leader is enabled */
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, host_counter_leader, 0);
+        host_counter_fds[i] = fd;
+        host_counter_slots[i] = -1;
+        available[i] = fd >= 0;
+        if (fd < 0) {
+            if (!*reason) *reason = host_counter_error(errno);
+            continue;
+        }
+        if (host_counter_leader < 0) host_counter_leader = fd;
+        host_counter_slots[i] = opened++;
+    }
+    if (opened > 0) {
+        ioctl(host_counter_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(host_counter_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    return opened;
+}
+
+/* Current totals; counters that are not open read as 0 */
+void host_counters_read(double values[HOST_COUNTER_COUNT])
+{
+    __u64 group[1 + HOST_COUNTER_COUNT]; /* Number of counters, then their values */
+    int valid;
+    int i;
+
+    valid = host_counter_leader >= 0 && read(host_counter_leader, group, sizeof(group)) > 0;
+    for (i = 0; i < HOST_COUNTER_COUNT; i++) {
+        values[i] = valid && host_counter_slots[i] >= 0 ? (double)group[1 + host_counter_slots[i]] : 0.0;
+    }
+}
+
+void host_counters_close(void)
+{
+    int i;
+
+    for (i = 0; i < HOST_COUNTER_COUNT; i++) {
+        if (host_counter_fds[i] >= 0) close(host_counter_fds[i]);
+        host_counter_fds[i] = -1;
+    }
+    host_counter_leader = -1;
+}
+
+#else
+
+int host_counters_open(int available[HOST_COUNTER_COUNT], const char **reason)
+{
+    int i;
+
+    for (i = 0; i < HOST_COUNTER_COUNT; i++) available[i] = 0;
+    *reason = "not supported on this host";
+    return 0;
+}
+
+void host_counters_read(double values[HOST_COUNTER_COUNT])
+{
+    int i;
+
+    for (i = 0; i < HOST_COUNTER_COUNT; i++) values[i] = 0.0;
+}
+
+void host_counters_close(void)
+{
+}
+
+#endif
+
+void host_startup_mark(const char *phase)
+{
+    static int enabled = -1; /* Not looked up yet */
+    struct timespec ts;
+
+    if (enabled < 0) enabled = getenv(HOST_STARTUP_MARKS_ENV) != NULL;
+    if (!enabled) return;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    fprintf(stderr, "startup %s %ld.%09ld\n", phase, (long)ts.tv_sec, (long)ts.tv_nsec);
+}
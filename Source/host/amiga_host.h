@@ -0,0 +1,160 @@
+/*
+ * Codex - host build support
+ *
+ * Minimal stand-ins for the AmigaOS types and the handful of exec.library,
+ * dos.library and timer.device calls Codex uses, so that codex.c can be
+ * compiled unchanged with a native compiler on Linux/POSIX for tests,
+ * benchmarks and fuzzing.  The headers next to this file shadow the NDK
+ * include names and all pull in this one.
+ *
+ * This is NOT an AmigaOS emulation: only the behaviour Codex depends on is
+ * provided.  LONG is pointer-sized so that ReadArgs() result arrays work
+ * the same way they do on the Amiga.
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CODEX_AMIGA_HOST_H
+#define CODEX_AMIGA_HOST_H
+
+#include <stddef.h>
+
+#define CODEX_HOST_BUILD 1
+
+/* codex.c keeps its own main(); host_main.c provides the real entry point */
+#define main codex_host_main
+int codex_host_main(int argc, char **argv);
+void host_set_args(int argc, char **argv);
+
+/* --- exec/types.h --- */
+typedef long            LONG;
+typedef unsigned long   ULONG;
+typedef short           WORD;
+typedef unsigned short  UWORD;
+typedef signed char     BYTE;
+typedef unsigned char   UBYTE;
+typedef short           BOOL;
+typedef char           *STRPTR;
+typedef const char     *CONST_STRPTR;
+typedef void           *APTR;
+typedef void           *BPTR;
+
+#ifndef CONST
+#define CONST const
+#endif
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+
+/* --- exec/memory.h --- */
+#define MEMF_ANY    0L
+#define MEMF_PUBLIC (1L << 0)
+#define MEMF_CHIP   (1L << 1)
+#define MEMF_FAST   (1L << 2)
+#define MEMF_CLEAR  (1L << 16)
+
+/* --- dos/dos.h --- */
+#define MODE_OLDFILE   1005
+#define MODE_NEWFILE   1006
+#define MODE_READWRITE 1004
+#define DOSTRUE  (-1L)
+#define DOSFALSE 0L
+
+struct RDArgs;
+
+/* --- exec/io.h, devices/timer.h --- */
+struct Device
+{
+    int dd_Dummy;
+};
+
+struct IORequest
+{
+    struct Device *io_Device;
+};
+
+struct EClockVal
+{
+    ULONG ev_hi;
+    ULONG ev_lo;
+};
+
+struct timerequest
+{
+    struct IORequest tr_node;
+};
+
+#define TIMERNAME   "timer.device"
+#define UNIT_ECLOCK 2
+
+/* --- dos.library --- */
+LONG Printf(CONST_STRPTR format, ...);
+LONG FPrintf(BPTR fh, CONST_STRPTR format, ...);
+struct RDArgs *ReadArgs(CONST_STRPTR template, LONG *array, struct RDArgs *args);
+void FreeArgs(struct RDArgs *args);
+BPTR Open(CONST_STRPTR name, LONG mode);
+LONG Close(BPTR fh);
+STRPTR FGets(BPTR fh, STRPTR buf, ULONG len);
+LONG FPuts(BPTR fh, CONST_STRPTR str);
+LONG FPutC(BPTR fh, LONG ch);
+LONG Read(BPTR fh, APTR buffer, LONG length);
+LONG Write(BPTR fh, CONST APTR buffer, LONG length);
+LONG Flush(BPTR fh);
+BPTR Output(void);
+LONG Rename(CONST_STRPTR old_name, CONST_STRPTR new_name);
+LONG DeleteFile(CONST_STRPTR name);
+
+/* --- exec.library --- */
+APTR AllocVec(ULONG size, ULONG flags);
+void FreeVec(APTR memory);
+APTR CreatePool(ULONG requirements, ULONG puddle_size, ULONG threshold_size);
+void DeletePool(APTR pool);
+APTR AllocPooled(APTR pool, ULONG size);
+void FreePooled(APTR pool, APTR memory, ULONG size);
+ULONG AvailMem(ULONG requirements);
+LONG OpenDevice(CONST_STRPTR name, ULONG unit, struct IORequest *io, ULONG flags);
+void CloseDevice(struct IORequest *io);
+
+/* --- timer.device --- */
+ULONG ReadEClock(struct EClockVal *dest);
+
+/* --- Host only: hardware performance counters for Codex.profile ---
+   Counters in this order: cycles, instructions, branches, branch misses,
+   L1 data cache read misses, last-level cache misses.  Counts are of this
+   process in user mode, read together as one group. */
+#define HOST_COUNTER_COUNT 6
+int host_counters_open(int available[HOST_COUNTER_COUNT], const char **reason);
+void host_counters_read(double values[HOST_COUNTER_COUNT]);
+void host_counters_close(void);
+
+/* --- Host only: startup phase marks for bench/startup.c ---
+   Writes "startup PHASE SECONDS.NANOSECONDS" to stderr, on the monotonic
+   clock, when CODEX_STARTUP_MARKS is set in the environment. */
+#define HOST_STARTUP_MARKS_ENV "CODEX_STARTUP_MARKS"
+void host_startup_mark(const char *phase);
+
+#endif /* CODEX_AMIGA_HOST_H */
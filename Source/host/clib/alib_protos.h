@@ -0,0 +1,5 @@
+/* Host build stand-in for <clib/alib_protos.h>; see amiga_host.h */
+#ifndef CODEX_HOST_CLIB_ALIB_PROTOS_H
+#define CODEX_HOST_CLIB_ALIB_PROTOS_H
+#include "../amiga_host.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host build stand-in for <dos/dos.h>; see amiga_host.h */
+#ifndef CODEX_HOST_DOS_DOS_H
+#define CODEX_HOST_DOS_DOS_H
+#include "../amiga_host.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host build stand-in for <dos/dosextens.h>; see amiga_host.h */
+#ifndef CODEX_HOST_DOS_DOSEXTENS_H
+#define CODEX_HOST_DOS_DOSEXTENS_H
+#include "../amiga_host.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host build stand-in for <exec/memory.h>; see amiga_host.h */
+#ifndef CODEX_HOST_EXEC_MEMORY_H
+#define CODEX_HOST_EXEC_MEMORY_H
+#include "../amiga_host.h"
+#endif
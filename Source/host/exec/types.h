@@ -0,0 +1,5 @@
+/* Host build stand-in for <exec/types.h>; see amiga_host.h */
+#ifndef CODEX_HOST_EXEC_TYPES_H
+#define CODEX_HOST_EXEC_TYPES_H
+#include "../amiga_host.h"
+#endif
@@ -0,0 +1,18 @@
+/*
+ * Codex - host build entry point
+ *
+ * Records argc/argv for the ReadArgs() stand-in and runs Codex's own main(),
+ * which amiga_host.h renames to codex_host_main().  The first startup mark
+ * is taken here, once the loader and C library have handed over.
+ */
+
+int codex_host_main(int argc, char **argv);
+void host_set_args(int argc, char **argv);
+void host_startup_mark(const char *phase);
+
+int main(int argc, char **argv)
+{
+    host_startup_mark("main");
+    host_set_args(argc, argv);
+    return codex_host_main(argc, argv);
+}
@@ -0,0 +1,5 @@
+/* Host build stand-in for <proto/dos.h>; see amiga_host.h */
+#ifndef CODEX_HOST_PROTO_DOS_H
+#define CODEX_HOST_PROTO_DOS_H
+#include "../amiga_host.h"
+#endif
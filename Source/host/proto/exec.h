@@ -0,0 +1,5 @@
+/* Host build stand-in for <proto/exec.h>; see amiga_host.h */
+#ifndef CODEX_HOST_PROTO_EXEC_H
+#define CODEX_HOST_PROTO_EXEC_H
+#include "../amiga_host.h"
+#endif
@@ -0,0 +1,5 @@
+/* Host build stand-in for <proto/timer.h>; see amiga_host.h */
+#ifndef CODEX_HOST_PROTO_TIMER_H
+#define CODEX_HOST_PROTO_TIMER_H
+#include "../amiga_host.h"
+#endif
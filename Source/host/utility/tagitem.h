@@ -0,0 +1,5 @@
+/* Host build stand-in for <utility/tagitem.h>; see amiga_host.h */
+#ifndef CODEX_HOST_UTILITY_TAGITEM_H
+#define CODEX_HOST_UTILITY_TAGITEM_H
+#include "../amiga_host.h"
+#endif
@@ -0,0 +1,530 @@
+/*
+ * Codex - native runner for the $CODEX: expectations
+ *
+ * Includes codex.c and lints each test file in the modes its
+ * "$CODEX: MODES ..." line names, then checks the diagnostics against
+ * the file's other $CODEX: comments:
+ *
+ *   - A comment after code expects a diagnostic on its own line; a comment
+ *     on a line of its own expects one on the next line of code.
+ *   - The diagnostic's message must contain the comment's key: a "quoted"
+ *     fragment, else the text after "warning: " or "error: ", else the
+ *     whole comment when it does not say "trigger".  A comment that
+ *     expects a diagnostic but has no key is an error in the test file.
+ *   - A comment containing "NOT trigger" expects none there.
+ *   - Every diagnostic that no comment on its line expects is unexpected.
+ *
+ * Failures print as "missing: file:line [MODES] text" or
+ * "unexpected: file:line [MODES] [TYPE] message".  Lines listed in the
+ * known-failures file are counted (and listed with -v) but do not fail
+ * the run.  Each case
+ * is linted several times and its median time is reported.  Every run
+ * after the first must lint without a heap allocation; one that does not
+ * prints as "allocations: file [MODES] count" and always fails.
+ * STACKCHECK in a MODES line also runs the stack depth analysis after
+ * the file, so its diagnostics are checked like the others.
+ *
+ * Host build only (VMakefile: make -f VMakefile check).
+ *
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "../codex.c"
+#undef main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define DEFAULT_RUNS 5
+#define MAX_CASES 16
+#define MAX_EXPECTATIONS 512
+#define MAX_KNOWN 256
+#define MAX_MODES_TEXT 80
+#define MAX_EXPECTATION_TEXT 160
+#define MAX_REPORT_LINE 640
+#define CODEX_MARKER "$CODEX:"
+#define MODES_KEYWORD "MODES"
+#define NEGATIVE_MARKER "NOT trigger"
+#define TRIGGER_WORD "trigger"
+#define NANOSECONDS_PER_MILLISECOND 1e6
+
+/* One $CODEX: expectation */
+typedef struct {
+    int line;           /* Line of the comment */
+    int target;         /* Line the expectation is about */
+    int negative;       /* No diagnostic expected there */
+    char text[MAX_EXPECTATION_TEXT];
+    char key[MAX_EXPECTATION_TEXT]; /* Text the diagnostic's message must contain */
+} Expectation;
+
+/* One run of a file in the modes of one MODES line */
+typedef struct {
+    ModeSwitches switches;
+    int stackcheck;     /* STACKCHECK: analyse the call graph after the file */
+    char modes[MAX_MODES_TEXT];
+} TestCase;
+
+static Expectation expectations[MAX_EXPECTATIONS];
+static int expectation_count;
+static TestCase cases[MAX_CASES];
+static int case_count;
+static char *known[MAX_KNOWN];
+static int known_used[MAX_KNOWN];
+static int known_count = 0;
+static int known_failures = 0;
+static int runs = DEFAULT_RUNS;
+static int verbose = 0;
+static int saved_stdout = -1;
+
+static double now_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / NANOSECONDS_PER_MILLISECOND;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* process_file() announces every file; keep that out of the report */
+static void silence_stdout(int silent) {
+    fflush(stdout);
+    if (silent) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        saved_stdout = dup(STDOUT_FILENO);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDOUT_FILENO);
+            close(null_fd);
+        }
+    } else if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+        saved_stdout = -1;
+    }
+}
+
+/* Sets the switch one command-line mode name stands for */
+static int set_switch(ModeSwitches *switches, const char *name) {
+    if (strcmp(name, "AMIGA") == 0) switches->amiga = 1;
+    else if (strcmp(name, "NDK") == 0) switches->ndk = 1;
+    else if (strcmp(name, "C89") == 0) switches->c89 = 1;
+    else if (strcmp(name, "C99") == 0) switches->c99 = 1;
+    else if (strcmp(name, "SASC") == 0) switches->sasc = 1;
+    else if (strcmp(name, "VBCC") == 0) switches->vbcc = 1;
+    else if (strcmp(name, "DICE") == 0) switches->dice = 1;
+    else if (strcmp(name, "MEMSAFE") == 0) switches->memsafe = 1;
+    else return 0;
+    return 1;
+}
+
+/* Copies the comment text after $CODEX: without the closing marker */
+static void comment_text(const char *marker, char *text, size_t size) {
+    const char *start = marker + strlen(CODEX_MARKER);
+    const char *end;
+    size_t length;
+
+    while (*start == ' ' || *start == '\t') start++;
+    end = strstr(start, "*/");
+    if (!end) end = start + strlen(start);
+    while (end > start && isspace((unsigned char)end[-1])) end--;
+    length = (size_t)(end - start);
+    if (length >= size) length = size - 1;
+    memcpy(text, start, length);
+    text[length] = '\0';
+}
+
+/* Finds the key of an expectation in its comment text; returns 0 if it has none */
+static int expectation_key(const char *text, char *key, size_t size) {
+    const char *start = strchr(text, '"');
+    const char *end = NULL;
+    size_t length;
+
+    if (start) {
+        start++;
+        end = strchr(start, '"');
+    }
+    if (!end) {
+        if ((start = strstr(text, "warning: ")) != NULL) start += strlen("warning: ");
+        else if ((start = strstr(text, "error: ")) != NULL) start += strlen("error: ");
+        else if (!strstr(text, TRIGGER_WORD)) start = text;
+        else return 0;
+        end = start + strlen(start);
+        /* Messages are quoted with or without their closing full stop */
+        if (end > start && end[-1] == '.') end--;
+    }
+    length = (size_t)(end - start);
+    if (length >= size) length = size - 1;
+    memcpy(key, start, length);
+    key[length] = '\0';
+    return length > 0;
+}
+
+static int parse_modes(const char *filename, int line_num, const char *text) {
+    const char *list = text + strlen(MODES_KEYWORD);
+    TestCase *test_case;
+    char words[MAX_MODES_TEXT];
+    char *word;
+
+    if (case_count >= MAX_CASES) {
+        fprintf(stderr, "expectrun: %s:%d: too many MODES lines\n", filename, line_num);
+        return 0;
+    }
+    test_case = &cases[case_count];
+    memset(test_case, 0, sizeof(*test_case));
+    while (*list == ' ' || *list == '\t') list++;
+    strncpy(test_case->modes, list, sizeof(test_case->modes) - 1);
+    strcpy(words, test_case->modes);
+    for (word = strtok(words, " \t"); word; word = strtok(NULL, " \t")) {
+        if (strcmp(word, "STACKCHECK") == 0) {
+            test_case->stackcheck = 1;
+        } else if (!set_switch(&test_case->switches, word)) {
+            fprintf(stderr, "expectrun: %s:%d: unknown mode '%s'\n", filename, line_num, word);
+            return 0;
+        }
+    }
+    case_count++;
+    return 1;
+}
+
+/* Reads the MODES lines and expectations of one test file */
+static int parse_file(const char *filename) {
+    static char line[MAX_LINE_LENGTH];
+    FILE *file = fopen(filename, "r");
+    int pending = 0; /* Expectations still waiting for their line of code */
+    int line_num = 0;
+
+    if (!file) {
+        fprintf(stderr, "expectrun: cannot open '%s'\n", filename);
+        return 0;
+    }
+    expectation_count = 0;
+    case_count = 0;
+    while (fgets(line, sizeof(line), file)) {
+        const char *marker = strstr(line, CODEX_MARKER);
+        const char *code = line;
+
+        line_num++;
+        if (!strchr(line, '\n')) {
+            /* Like Codex, read past the rest of an overlong line */
+            int c;
+            while ((c = fgetc(file)) != EOF && c != '\n') {}
+        }
+        while (*code == ' ' || *code == '\t') code++;
+        if (!marker) {
+            /* The first line of code after standalone comments is theirs */
+            if (pending && *code && *code != '\n' && *code != '\r') {
+                for (; pending > 0; pending--) expectations[expectation_count - pending].target = line_num;
+            }
+            continue;
+        }
+
+        if (strncmp(marker + strlen(CODEX_MARKER), " " MODES_KEYWORD " ", strlen(MODES_KEYWORD) + 2) == 0) {
+            char text[MAX_MODES_TEXT];
+            comment_text(marker, text, sizeof(text));
+            if (!parse_modes(filename, line_num, text)) {
+                fclose(file);
+                return 0;
+            }
+            continue;
+        }
+        if (expectation_count >= MAX_EXPECTATIONS) {
+            fprintf(stderr, "expectrun: %s: too many expectations\n", filename);
+            fclose(file);
+            return 0;
+        }
+
+        expectations[expectation_count].line = line_num;
+        expectations[expectation_count].target = line_num;
+        comment_text(marker, expectations[expectation_count].text, MAX_EXPECTATION_TEXT);
+        expectations[expectation_count].negative = strstr(expectations[expectation_count].text, NEGATIVE_MARKER) != NULL;
+        if (!expectations[expectation_count].negative &&
+            !expectation_key(expectations[expectation_count].text, expectations[expectation_count].key, MAX_EXPECTATION_TEXT)) {
+            fprintf(stderr, "expectrun: %s:%d: the $CODEX: comment names no message to expect\n", filename, line_num);
+            fclose(file);
+            return 0;
+        }
+        expectation_count++;
+        if (strncmp(code, "/*", 2) == 0) pending++;
+    }
+    fclose(file);
+    return 1;
+}
+
+static int is_known(const char *text) {
+    int i;
+
+    for (i = 0; i < known_count; i++) {
+        if (strcmp(known[i], text) == 0) {
+            known_used[i] = 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Prints one failure if asked to; returns 1 unless it is a known failure */
+static int report(const char *text, int print) {
+    if (is_known(text)) {
+        if (print) {
+            if (verbose) printf("  known      %s\n", text);
+            known_failures++;
+        }
+        return 0;
+    }
+    if (print) printf("  FAIL       %s\n", text);
+    return 1;
+}
+
+/* Whether an expectation asks for the diagnostic */
+static int meets(const Expectation *expectation, const LintError *error) {
+    return !expectation->negative && expectation->target == error->line_number &&
+           strstr(error->message, expectation->key) != NULL;
+}
+
+/* Checks the diagnostics of one case; returns the number of new failures */
+static int check_case(const char *name, const TestCase *test_case, int print, int *missing, int *unexpected) {
+    static const char *type_names[] = { "SYNTAX", "STYLE", "WARNING", "COMPILER", "COMMENT" };
+    char text[MAX_REPORT_LINE];
+    int count = error_count < MAX_ERRORS ? error_count : MAX_ERRORS;
+    int failures = 0;
+    int i;
+    int j;
+
+    *missing = 0;
+    *unexpected = 0;
+    for (i = 0; i < expectation_count; i++) {
+        const Expectation *expectation = &expectations[i];
+        int found = 0;
+
+        if (expectation->negative) continue;
+        for (j = 0; j < count && !found; j++) {
+            found = errors[j].type != ERROR_COMMENT && meets(expectation, &errors[j]);
+        }
+        if (!found) {
+            sprintf(text, "missing: %s:%d [%s] %s", name, expectation->target, test_case->modes, expectation->text);
+            failures += report(text, print);
+            (*missing)++;
+        }
+    }
+    for (j = 0; j < count; j++) {
+        int expected = 0;
+
+        if (errors[j].type == ERROR_COMMENT) continue;
+        for (i = 0; i < expectation_count && !expected; i++) {
+            expected = meets(&expectations[i], &errors[j]);
+        }
+        if (!expected) {
+            sprintf(text, "unexpected: %s:%d [%s] [%s] %s", name, errors[j].line_number, test_case->modes,
+                    type_names[errors[j].type], errors[j].message);
+            failures += report(text, print);
+            (*unexpected)++;
+        }
+    }
+    return failures;
+}
+
+/* Lints the file in one case's modes; returns the median time in ms, or -1,
+   and the heap allocations made after the first run in *steady_allocations */
+static double run_case(const char *filename, const TestCase *test_case, ULONG *steady_allocations) {
+    double *times = malloc((size_t)runs * sizeof(double));
+    double median;
+    ULONG warm = 0;
+    int r;
+
+    if (!times) return -1;
+    select_validation_modes(&test_case->switches);
+    stackcheck_enabled = test_case->stackcheck;
+    silence_stdout(1);
+    for (r = 0; r < runs; r++) {
+        double start = now_ms();
+        error_count = 0;
+        if (stackcheck_enabled && !stack_open()) {
+            silence_stdout(0);
+            free(times);
+            return -1;
+        }
+        if (process_file(filename) != 0) {
+            silence_stdout(0);
+            free(times);
+            return -1;
+        }
+        if (stackcheck_enabled) stack_analyse();
+        times[r] = now_ms() - start;
+        if (r == 0) warm = mem_blocks_allocated;
+    }
+    silence_stdout(0);
+    *steady_allocations = mem_blocks_allocated - warm;
+    qsort(times, (size_t)runs, sizeof(double), compare_doubles);
+    median = times[runs / 2];
+    free(times);
+    return median;
+}
+
+/* Whether a known failure belongs to one of the files that were checked */
+static int known_file_checked(const char *entry, int file_count, char **files) {
+    char pattern[MAX_REPORT_LINE];
+    int f;
+
+    for (f = 0; f < file_count; f++) {
+        const char *name = strrchr(files[f], '/') ? strrchr(files[f], '/') + 1 : files[f];
+        sprintf(pattern, ": %.200s:", name);
+        if (strstr(entry, pattern)) return 1;
+    }
+    return 0;
+}
+
+static int load_known(const char *filename) {
+    char line[MAX_REPORT_LINE];
+    FILE *file = fopen(filename, "r");
+
+    if (!file) {
+        fprintf(stderr, "expectrun: cannot open known failures '%s'\n", filename);
+        return 0;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+        if (known_count >= MAX_KNOWN) {
+            fprintf(stderr, "expectrun: too many known failures\n");
+            fclose(file);
+            return 0;
+        }
+        known[known_count] = malloc(strlen(line) + 1);
+        if (!known[known_count]) {
+            fclose(file);
+            return 0;
+        }
+        strcpy(known[known_count++], line);
+    }
+    fclose(file);
+    return 1;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: expectrun [-known FILE] [-runs N] [-v] FILES...\n\n");
+    fprintf(stderr, "  -known FILE  Failures that are expected for now, one report line each\n");
+    fprintf(stderr, "  -runs N      Times each case is linted, the median is reported (default %d)\n", DEFAULT_RUNS);
+    fprintf(stderr, "  -v           List the known failures too\n");
+}
+
+int main(int argc, char **argv) {
+    int failures = 0;
+    int case_total = 0;
+    int first = 1;
+    int f;
+    int c;
+    int i;
+
+    while (first < argc && argv[first][0] == '-') {
+        if (strcmp(argv[first], "-v") == 0) {
+            verbose = 1;
+            first++;
+            continue;
+        }
+        if (first + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (strcmp(argv[first], "-known") == 0) {
+            if (!load_known(argv[first + 1])) return 1;
+        } else if (strcmp(argv[first], "-runs") == 0) {
+            runs = atoi(argv[first + 1]);
+        } else {
+            usage();
+            return 1;
+        }
+        first += 2;
+    }
+    if (first >= argc || runs < 1) {
+        usage();
+        return 1;
+    }
+    quiet_mode = 1;
+    engine_open();
+
+    printf("%-26s %-20s %6s %6s %8s %11s %10s\n", "File", "Modes", "Found", "Expect", "Missing", "Unexpected",
+           "Median ms");
+    for (f = first; f < argc; f++) {
+        const char *name = strrchr(argv[f], '/') ? strrchr(argv[f], '/') + 1 : argv[f];
+
+        if (!parse_file(argv[f])) return 1;
+        if (case_count == 0) {
+            printf("%-26s skipped, no $CODEX: MODES line\n", name);
+            continue;
+        }
+        for (c = 0; c < case_count; c++) {
+            ULONG steady_allocations;
+            double median = run_case(argv[f], &cases[c], &steady_allocations);
+            int missing;
+            int unexpected;
+            int found = 0;
+            int expected = 0;
+
+            if (median < 0) {
+                fprintf(stderr, "expectrun: cannot lint '%s'\n", argv[f]);
+                return 1;
+            }
+            for (i = 0; i < (error_count < MAX_ERRORS ? error_count : MAX_ERRORS); i++) {
+                if (errors[i].type != ERROR_COMMENT) found++;
+            }
+            for (i = 0; i < expectation_count; i++) {
+                if (!expectations[i].negative) expected++;
+            }
+            /* Count first for the row, then list the failures under it */
+            check_case(name, &cases[c], 0, &missing, &unexpected);
+            printf("%-26s %-20s %6d %6d %8d %11d %10.3f\n", name, cases[c].modes, found, expected, missing,
+                   unexpected, median);
+            failures += check_case(name, &cases[c], 1, &missing, &unexpected);
+            if (steady_allocations != 0) {
+                printf("  FAIL       allocations: %s [%s] %ld after the first run\n", name, cases[c].modes,
+                       (LONG)steady_allocations);
+                failures++;
+            }
+            case_total++;
+        }
+    }
+    for (i = 0; i < known_count; i++) {
+        if (!known_used[i] && known_file_checked(known[i], argc - first, argv + first)) printf("  now passes, remove from the known failures: %s\n", known[i]);
+    }
+
+    if (failures > 0) {
+        printf("\nexpectations FAILED: %d new failure%s in %d case%s (%d known)\n", failures,
+               failures == 1 ? "" : "s", case_total, case_total == 1 ? "" : "s", known_failures);
+        return 1;
+    }
+    printf("\nexpectations passed: %d case%s (%d known failure%s)\n", case_total, case_total == 1 ? "" : "s",
+           known_failures, known_failures == 1 ? "" : "s");
+    return 0;
+}
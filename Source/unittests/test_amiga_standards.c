@@ -30,6 +30,8 @@
  * This should trigger warnings when checking Amiga coding standards.
  */
 
+/* $CODEX: MODES AMIGA */
+
 #include <dos/dos.h>
 #include <proto/dos.h>
 
@@ -39,13 +41,13 @@ void amiga_violation1(void)
     /* Using lowercase function names instead of PascalCase */
     printf("This should trigger a warning"); /* $CODEX: This should trigger a warning: Use PascalCase function names */
     strcpy(buffer, "string"); /* $CODEX: This should trigger a warning: Use PascalCase function names */
-    malloc(100); /* $CODEX: This should trigger a warning: Use PascalCase function names */
+    malloc(100); /* $CODEX: This should trigger a warning: Magic number found */
 }
 
 void amiga_violation2(void)
 {
     /* Using lowercase types instead of Amiga types */
-    char *ptr; /* $CODEX: This should trigger a warning: Use Amiga types (UBYTE*) instead of char* */
+    char *ptr; /* $CODEX: This should trigger a warning: Use Amiga types (UBYTE* or STRPTR) instead of char* */
     long value; /* $CODEX: This should trigger a warning: Use Amiga types (LONG) instead of long */
     int counter; /* $CODEX: This should trigger a warning: Use Amiga types (ULONG) instead of int */
     
@@ -59,7 +61,7 @@ void amiga_violation3(void)
         /* Do something */
     }
     
-    for (int i = 0; i < 10; i++) { /* $CODEX: This should trigger a warning: Opening brace should be on its own line (Allman style) */
+    for (int i = 0; i < 10; i++) { /* $CODEX: This should trigger a warning: Variable declaration in for loop not allowed in C89 */
         /* Loop body */
     }
 }
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Test file for the busy-wait loop rule in AMIGA mode.
+ * Loops that poll GetMsg(), CheckIO(), SetSignal() or the chips without
+ * ever waiting.
+ */
+
+/* $CODEX: MODES AMIGA */
+
+#include <exec/types.h>
+#include <exec/ports.h>
+#include <exec/io.h>
+#include <dos/dos.h>
+#include <hardware/cia.h>
+#include <hardware/custom.h>
+#include <intuition/intuition.h>
+#include <proto/exec.h>
+#include <proto/dos.h>
+
+#define NO_SIGNALS 0L
+#define POLL_TICKS 2
+#define RETRIES 8
+#define LAST_LINE 200
+
+extern struct CIA ciaa;
+extern struct Custom custom;
+
+VOID WaitForRequest(struct IORequest *request)
+{
+    while (!CheckIO(request)) /* $CODEX: Should trigger "polls CheckIO() without waiting" - waits for CheckIO() by spinning */
+    {
+    }
+    WaitIO(request);
+}
+
+VOID WaitForBreak(VOID)
+{
+    while (!(SetSignal(NO_SIGNALS, NO_SIGNALS) & SIGBREAKF_CTRL_C)) /* $CODEX: Should trigger "polls SetSignal() without waiting" - spins on SetSignal() */
+    {
+    }
+}
+
+VOID WaitForButton(VOID)
+{
+    while (ciaa.ciapra & CIAF_GAMEPORT0) /* $CODEX: Should trigger "polls ciaa registers without waiting" - spins on the CIA registers */
+    {
+    }
+}
+
+struct Message *NextMessage(struct MsgPort *port)
+{
+    struct Message *message;
+
+    do
+    {
+        message = GetMsg(port); /* $CODEX: Should trigger "polls GetMsg() without waiting" - polls the port until a message comes */
+    } while (message == NULL);
+    return message;
+}
+
+VOID PollForever(struct MsgPort *port)
+{
+    struct Message *message;
+
+    FOREVER
+    {
+        message = GetMsg(port); /* $CODEX: Should trigger "polls GetMsg() without waiting" - polls with nothing to wait on */
+        if (message)
+        {
+            ReplyMsg(message);
+        }
+    }
+}
+
+VOID EventLoop(struct Window *window, ULONG window_signals)
+{
+    struct IntuiMessage *message;
+    BOOL running = TRUE;
+
+    while (running)
+    {
+        Wait(window_signals);
+        while ((message = (struct IntuiMessage *)GetMsg(window->UserPort)) != NULL) /* $CODEX: Should NOT trigger - drains the port after Wait() */
+        {
+            if (message->Class == IDCMP_CLOSEWINDOW) running = FALSE;
+            ReplyMsg((struct Message *)message);
+        }
+    }
+}
+
+VOID DrainPort(struct MsgPort *port)
+{
+    struct Message *message;
+
+    while ((message = GetMsg(port)) != NULL) /* $CODEX: Should NOT trigger - empties the port once */
+    {
+        ReplyMsg(message);
+    }
+}
+
+VOID PollWithDelay(struct IORequest *request)
+{
+    while (!CheckIO(request)) /* $CODEX: Should NOT trigger - Delay() gives the CPU away */
+    {
+        Delay(POLL_TICKS);
+    }
+    WaitIO(request);
+}
+
+BOOL TryRequest(struct IORequest *request)
+{
+    LONG i;
+
+    for (i = 0; i < RETRIES; i++)
+    {
+        if (CheckIO(request)) return TRUE; /* $CODEX: Should NOT trigger - gives up after a few passes */
+    }
+    return FALSE;
+}
+
+VOID WaitForMessage(struct MsgPort *port)
+{
+    while (!(port->mp_MsgList.lh_Head->ln_Succ)) /* $CODEX: Should trigger "polls mp_MsgList without waiting" - spins until a message is queued */
+    {
+    }
+}
+
+ULONG CountNodes(struct List *list)
+{
+    struct Node *node;
+    ULONG nodes = 0;
+
+    node = list->lh_Head;
+    while (node->ln_Succ) /* $CODEX: Should NOT trigger - walks the list once */
+    {
+        nodes++;
+        node = node->ln_Succ;
+    }
+    return nodes;
+}
+
+UWORD WaitForLine(VOID)
+{
+    UWORD position;
+
+    do
+    {
+        position = custom.vhposr; /* $CODEX: Should trigger "polls custom registers without waiting" - compares a register read, not a count */
+    } while (position < LAST_LINE);
+    return position;
+}
+
+BOOL TryRequestAgain(struct IORequest *request)
+{
+    LONG tries = 0;
+
+    while (tries < RETRIES)
+    {
+        if (CheckIO(request)) return TRUE; /* $CODEX: Should NOT trigger - counts its tries */
+        tries++;
+    }
+    return FALSE;
+}
@@ -30,6 +30,8 @@
  * This should trigger warnings when checking C89 standards.
  */
 
+/* $CODEX: MODES C89 AMIGA MEMSAFE */
+
  #include <dos/dos.h>
  #include <proto/dos.h>
  #include <string.h> /* For strcpy */
@@ -43,14 +45,14 @@
      Printf("Value of x is %ld\n", x);
  
      /* $CODEX: Variable declaration after a statement is not allowed in C89. */
-     int y = 20; /* This declaration after the Printf statement is a C89 violation. */
+     const LONG y = 20; /* This declaration after the Printf statement is a C89 violation. */
  
      Printf("Value of y is %ld\n", y);
  }
  
  void test_c99_features_in_c89_mode(void)
  {
-     /* $CODEX: C++ style comments ('//') are not allowed in C89. */
+     /* $CODEX: C++ comments ('//') are not allowed in C89. */
      // This is a C99-style comment.
  
      /* $CODEX: Variable declaration in for loop not allowed in C89. */
@@ -58,9 +60,9 @@
          Printf("i = %ld\n", i);
      }
  
-     /* $CODEX: C99 designated initializer found - not available in C89. */
-     struct Point { int x, y; };
-     struct Point p = { .x = 1, .y = 2 };
+     /* Designated initializers are C99 */
+     struct Point { int x, y; }; /* $CODEX: Use Amiga types (ULONG) instead of int */
+     struct Point p = { .x = 1, .y = 2 }; /* $CODEX: C99 designated initializer found - not available in C89. */
  }
  
  
@@ -72,7 +74,7 @@
      /* $CODEX: Use Amiga types (LONG) instead of long. */
      long my_long_var = 12345L;
  
-     /* $CODEX: Use Amiga types (UWORD) instead of unsigned short. */
+     /* $CODEX: Use Amiga primitive types (ULONG, UBYTE, UWORD) instead of standard C types */
      unsigned short my_ushort = 100;
  
      Printf("Amiga style violations here.\n");
@@ -85,7 +87,7 @@
  {
      char buffer[10];
  
-     /* $CODEX: Memory-unsafe function 'strcpy' found - use 'strncpy' instead. */
+     /* $CODEX: Memory-unsafe function 'strcpy' found - consider using 'strncpy' instead */
      strcpy(buffer, "This string is definitely too long for the buffer");
  
      Printf("Buffer content: %s\n", buffer);
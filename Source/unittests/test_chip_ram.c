@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Test file for the chip RAM rule in AMIGA mode.
+ * MEMF_CHIP allocations that only the CPU uses, and ones that graphics,
+ * the blitter or other functions may need in chip RAM.
+ */
+
+/* $CODEX: MODES AMIGA */
+
+#include <exec/types.h>
+#include <exec/memory.h>
+#include <graphics/gfx.h>
+#include <hardware/custom.h>
+#include <proto/exec.h>
+#include <proto/graphics.h>
+
+#define BUFFER_SIZE 1024
+#define PUDDLE_SIZE 4096
+#define THRESHOLD 256
+#define PLANE_WIDTH 320
+#define PLANE_HEIGHT 256
+#define NO_FILL 0
+#define GLYPH_WIDTH 16
+#define GLYPH_HEIGHT 8
+#define GLYPH_MODULO 2
+
+extern struct Custom custom;
+static UBYTE *shared_buffer;
+
+VOID ClearBuffer(VOID)
+{
+    UBYTE *buffer;
+
+    buffer = AllocMem(BUFFER_SIZE, MEMF_CHIP | MEMF_CLEAR); /* $CODEX: Should trigger "buffer gets MEMF_CHIP memory from AllocMem()" - only the CPU touches it */
+    if (buffer)
+    {
+        memset(buffer, NO_FILL, BUFFER_SIZE);
+        FreeMem(buffer, BUFFER_SIZE);
+    }
+}
+
+VOID CopyTable(UBYTE *table)
+{
+    UBYTE *copy = (UBYTE *)AllocVec(BUFFER_SIZE, MEMF_CHIP); /* $CODEX: Should trigger "copy gets MEMF_CHIP memory from AllocVec()" - CopyMem() runs on the CPU */
+
+    if (copy)
+    {
+        CopyMem(table, copy, BUFFER_SIZE);
+        FreeVec(copy);
+    }
+}
+
+VOID PoolOfScratch(VOID)
+{
+    APTR pool;
+    UBYTE *scratch;
+
+    pool = CreatePool(MEMF_CHIP, PUDDLE_SIZE, THRESHOLD); /* $CODEX: Should trigger "pool gets MEMF_CHIP memory from CreatePool()" - nothing from the pool needs chip RAM */
+    if (pool)
+    {
+        scratch = AllocPooled(pool, BUFFER_SIZE);
+        if (scratch) scratch[NO_FILL] = NO_FILL;
+        DeletePool(pool);
+    }
+}
+
+VOID DrawPlane(struct RastPort *rp)
+{
+    struct BitMap bitmap;
+    PLANEPTR plane;
+
+    plane = AllocMem(RASSIZE(PLANE_WIDTH, PLANE_HEIGHT), MEMF_CHIP | MEMF_CLEAR); /* $CODEX: Should NOT trigger - a bitplane for graphics */
+    if (plane)
+    {
+        InitBitMap(&bitmap, 1, PLANE_WIDTH, PLANE_HEIGHT);
+        bitmap.Planes[NO_FILL] = plane;
+        BltBitMapRastPort(&bitmap, NO_FILL, NO_FILL, rp, NO_FILL, NO_FILL, PLANE_WIDTH, PLANE_HEIGHT, ABC | ABNC);
+        FreeMem(plane, RASSIZE(PLANE_WIDTH, PLANE_HEIGHT));
+    }
+}
+
+VOID StartBlit(VOID)
+{
+    UWORD *source;
+
+    source = AllocMem(BUFFER_SIZE, MEMF_CHIP); /* $CODEX: Should NOT trigger - goes to a blitter register */
+    if (source)
+    {
+        custom.bltapt = source;
+    }
+}
+
+VOID DrawGlyph(struct RastPort *rp)
+{
+    UWORD *glyph;
+
+    glyph = AllocMem(BUFFER_SIZE, MEMF_CHIP | MEMF_CLEAR); /* $CODEX: Should NOT trigger - the blitter reads it */
+    if (glyph)
+    {
+        BltTemplate((PLANEPTR)glyph, NO_FILL, GLYPH_MODULO, rp, NO_FILL, NO_FILL, GLYPH_WIDTH, GLYPH_HEIGHT);
+        WaitBlit();
+        FreeMem(glyph, BUFFER_SIZE);
+    }
+}
+
+static ULONG Checksum(const UBYTE *data, ULONG size)
+{
+    ULONG sum = 0;
+    ULONG i;
+
+    for (i = 0; i < size; i++) sum += data[i];
+    return sum;
+}
+
+ULONG SumBuffer(VOID)
+{
+    UBYTE *buffer;
+    ULONG sum = 0;
+
+    buffer = AllocVec(BUFFER_SIZE, MEMF_CHIP); /* $CODEX: Should trigger "buffer gets MEMF_CHIP memory from AllocVec()" - Checksum() is not a custom chip user */
+    if (buffer)
+    {
+        sum = Checksum(buffer, BUFFER_SIZE);
+        FreeVec(buffer);
+    }
+    return sum;
+}
+
+UBYTE *MakeSample(VOID)
+{
+    UBYTE *sample;
+
+    sample = AllocVec(BUFFER_SIZE, MEMF_CHIP); /* $CODEX: Should NOT trigger - returned to the caller */
+    return sample;
+}
+
+VOID KeepShared(VOID)
+{
+    shared_buffer = AllocMem(BUFFER_SIZE, MEMF_CHIP); /* $CODEX: Should NOT trigger - not a local */
+}
+
+VOID AnyMemory(VOID)
+{
+    UBYTE *buffer;
+
+    buffer = AllocMem(BUFFER_SIZE, MEMF_ANY); /* $CODEX: Should NOT trigger - not chip RAM */
+    if (buffer) FreeMem(buffer, BUFFER_SIZE);
+}
@@ -30,39 +30,41 @@
  * This demonstrates various coding standards and practices.
  */
 
+/* $CODEX: MODES NDK */
+
 #include <dos/dos.h>
 #include <proto/dos.h>
 
-/* Compiler-specific keywords that will trigger warnings */
-__saveds void test_function1(void) /* $CODEX: This should trigger a warning: Use __SAVE_DS__ for universal syntax */
+/* Compiler-specific keywords; NDK mode flags only the NDK reserved words */
+__saveds void test_function1(void) /* $CODEX: This should trigger a warning: NDK reserved word found - use universal syntax instead */
 {
     /* This will trigger a compiler compatibility warning */
-    __asm("nop"); /* $CODEX: This should trigger a warning: Use __ASM__ for universal syntax */
+    __asm("nop"); /* $CODEX: Should NOT trigger - __asm is not an NDK reserved word */
 }
 
-__save_ds void test_function2(void) /* $CODEX: This should trigger a warning: Use __SAVE_DS__ for universal syntax */
+__save_ds void test_function2(void) /* $CODEX: This should trigger a warning: NDK reserved word found - use universal syntax instead */
 {
     /* Another variant that will trigger a warning */
-    __reg("d0", int value) = 42; /* $CODEX: This should trigger a warning: Use __REG__ for universal syntax */
+    __reg("d0", int value) = 42; /* $CODEX: Should NOT trigger - __reg is not an NDK reserved word */
 }
 
-__stdargs void test_function3(void) /* $CODEX: This should trigger a warning: Use __STDARGS__ for universal syntax */
+__stdargs void test_function3(void) /* $CODEX: Should NOT trigger - __stdargs is not an NDK reserved word */
 {
     /* Function with stdargs calling convention */
-    __far char *ptr = NULL; /* $CODEX: This should trigger a warning: Use __FAR__ for universal syntax */
+    __far char *ptr = NULL; /* $CODEX: Should NOT trigger - __far is not an NDK reserved word */
 }
 
-__interrupt void test_interrupt_handler(void) /* $CODEX: This should trigger a warning: Use __INTERRUPT__ for universal syntax */
+__interrupt void test_interrupt_handler(void) /* $CODEX: Should NOT trigger - __interrupt is not an NDK reserved word */
 {
     /* Interrupt handler with compiler-specific keyword */
-    __chip char buffer[256]; /* $CODEX: This should trigger a warning: Use __CHIP__ for universal syntax */
-    __fast int counter = 0; /* $CODEX: This should trigger a warning: Use __FAST__ for universal syntax */
+    __chip char buffer[256]; /* $CODEX: Should NOT trigger - __chip is not an NDK reserved word */
+    __fast int counter = 0; /* $CODEX: Should NOT trigger - __fast is not an NDK reserved word */
 }
 
-__amigainterrupt void test_amiga_interrupt_handler(void) /* $CODEX: This should trigger a warning: Use __INTERRUPT__ for universal syntax */
+__amigainterrupt void test_amiga_interrupt_handler(void) /* $CODEX: This should trigger a warning: NDK reserved word found - use universal syntax instead */
 {
     /* VBCC Amiga-specific interrupt handler */
-    __chip char buffer[128]; /* $CODEX: This should trigger a warning: Use __CHIP__ for universal syntax */
+    __chip char buffer[128]; /* $CODEX: Should NOT trigger - __chip is not an NDK reserved word */
 }
 
 /* Universal syntax examples (these will NOT trigger warnings) */
@@ -30,6 +30,8 @@
  * This tests various header inclusion patterns and standards.
  */
 
+/* $CODEX: MODES C89 */
+
 #include <dos/dos.h>
 #include <proto/dos.h>
 
@@ -49,20 +51,20 @@
 #include <float.h>
 
 /* C99+ headers - should trigger warnings in C89 mode */
-#include <stdint.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
-#include <stdbool.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
-#include <complex.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
-#include <tgmath.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
-#include <fenv.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
-#include <inttypes.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
-#include <wchar.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
-#include <wctype.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
-#include <uchar.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
-#include <threads.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
-#include <stdatomic.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
-#include <stdnoreturn.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
-#include <stdalign.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
-#include <stdbit.h> /* $CODEX: This should trigger a warning: C99+ header not allowed in C89 mode */
+#include <stdint.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
+#include <stdbool.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
+#include <complex.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
+#include <tgmath.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
+#include <fenv.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
+#include <inttypes.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
+#include <wchar.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
+#include <wctype.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
+#include <uchar.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
+#include <threads.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
+#include <stdatomic.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
+#include <stdnoreturn.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
+#include <stdalign.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
+#include <stdbit.h> /* $CODEX: This should trigger a warning: C99+ header file found - not available in C89 */
 
 /* Function to test header usage */
 void test_headers(void)
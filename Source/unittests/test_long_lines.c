@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Test file for lines longer than Codex's 1023-character line buffer.
+ * Only the first part of such a line is checked and the line is reported,
+ * but the braces, literals and comments of the rest still count.
+ */
+
+/* $CODEX: MODES C89 */
+
+void LongLines(void)
+{
+    int total = 0;
+
+    total = 1;
+    /* $CODEX: This should trigger a warning: Line exceeds maximum length */
+    /* $CODEX: This should trigger a warning: Line is longer than 1023 characters */
+    if (total == 1 || total == 2 || total == 3 || total == 4 || total == 5 || total == 6 || total == 7 || total == 8 || total == 9 || total == 10 || total == 11 || total == 12 || total == 13 || total == 14 || total == 15 || total == 16 || total == 17 || total == 18 || total == 19 || total == 20 || total == 21 || total == 22 || total == 23 || total == 24 || total == 25 || total == 26 || total == 27 || total == 28 || total == 29 || total == 30 || total == 31 || total == 32 || total == 33 || total == 34 || total == 35 || total == 36 || total == 37 || total == 38 || total == 39 || total == 40 || total == 41 || total == 42 || total == 43 || total == 44 || total == 45 || total == 46 || total == 47 || total == 48 || total == 49 || total == 50 || total == 51 || total == 52 || total == 53 || total == 54 || total == 55 || total == 56 || total == 57 || total == 58 || total == 59 || total == 60 || total == 61 || total == 62 || total == 63 || total == 64 || total == 65 || total == 66 || total == 67 || total == 68 || total == 69 || total == 70 || total == 71 || total == 72 || total == 73 || total == 74 || total == 75 || total == 76 || total == 77 || total == 78 || total == 79 || total == 80 || total == 81 || total == 82 || total == 83 || total == 84 || total == 85 || total == 86 || total == 87 || total == 88 || total == 89) { total = 2; (void)"{"; /* The rest of this line is not checked, and this comment is still open
+       int hidden; $CODEX: Should NOT trigger - this line is inside the comment */
+        int inner = 3; /* $CODEX: Should NOT trigger - the first declaration in the block the long line opened */
+        total = inner;
+    }
+    int after = 4; /* $CODEX: This should trigger a warning: Variable declaration after a statement is not allowed in C89 */
+    total = after;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Test file for the loop rules in AMIGA mode.
+ * Costly setup and teardown calls inside for, while and do loops.
+ */
+
+/* $CODEX: MODES AMIGA */
+
+#include <exec/types.h>
+#include <dos/dos.h>
+#include <proto/exec.h>
+#include <proto/dos.h>
+
+#define LIBRARY_VERSION 37
+#define MAX_FILES 4
+
+static UBYTE *file_names[MAX_FILES];
+
+VOID OpenInLoop(VOID)
+{
+    struct Library *base;
+    LONG i;
+
+    for (i = 0; i < MAX_FILES; i++)
+    {
+        base = OpenLibrary("icon.library", LIBRARY_VERSION); /* $CODEX: Should trigger "OpenLibrary() in the loop at line 50 repeats the same costly system call" - same OpenLibrary() on every pass */
+        if (base)
+        {
+            CloseLibrary(base); /* $CODEX: Should trigger "CloseLibrary() in the loop at line 50 is a costly system call" - teardown on every pass */
+        }
+    }
+}
+
+VOID LockEachFile(VOID)
+{
+    BPTR lock;
+    LONG i;
+
+    for (i = 0; i < MAX_FILES; i++)
+    {
+        lock = Lock(file_names[i], ACCESS_READ); /* $CODEX: Should trigger "Lock() in the loop at line 65 is a costly system call" - Lock() on every pass */
+        if (lock)
+        {
+            UnLock(lock); /* $CODEX: Should trigger "UnLock() in the loop at line 65 is a costly system call" - UnLock() on every pass */
+        }
+    }
+}
+
+VOID SingleStatementBody(BPTR *locks)
+{
+    LONG i;
+
+    for (i = 0; i < MAX_FILES; i++)
+        UnLock(locks[i]); /* $CODEX: Should trigger "UnLock() in the loop at line 79 is a costly system call" - the body is a single statement */
+    UnLock(locks[0]); /* $CODEX: Should NOT trigger - after the loop */
+}
+
+VOID DoLoop(VOID)
+{
+    struct Library *base;
+
+    do
+    {
+        base = OpenLibrary("dos.library", LIBRARY_VERSION); /* $CODEX: Should trigger "OpenLibrary() in the loop at line 88 repeats the same costly system call" - inside a do loop */
+    } while (!base);
+    CloseLibrary(base); /* $CODEX: Should NOT trigger - after the do loop */
+}
+
+VOID LockEachPath(UBYTE **paths, LONG remaining)
+{
+    BPTR lock;
+    LONG n = 0;
+
+    while (remaining > 0)
+    {
+        lock = Lock(paths[n], SHARED_LOCK); /* $CODEX: Should trigger "Lock() in the loop at line 100 is a costly system call" - n only changes further down the body */
+        UnLock(lock); /* $CODEX: Should trigger "UnLock() in the loop at line 100 is a costly system call" - UnLock() on every pass */
+        n++;
+        remaining--;
+    }
+}
+
+VOID LockInDoStatement(VOID)
+{
+    BPTR lock;
+    LONG i = 0;
+
+    do lock = Lock(file_names[i++], SHARED_LOCK); while (i < MAX_FILES); /* $CODEX: Should trigger "Lock() in the loop at line 114 is a costly system call" - i changes inside the arguments */
+}
+
+VOID OpenOnce(VOID)
+{
+    struct Library *base;
+    LONG i;
+
+    base = OpenLibrary("icon.library", LIBRARY_VERSION); /* $CODEX: Should NOT trigger - outside any loop */
+    for (i = 0; i < MAX_FILES; i++)
+    {
+        Delay(TICKS_PER_SECOND);
+    }
+    if (base) CloseLibrary(base); /* $CODEX: Should NOT trigger - outside any loop */
+}
@@ -30,6 +30,8 @@
  * This should trigger warnings when checking memory safety.
  */
 
+/* $CODEX: MODES MEMSAFE */
+
  #include <dos/dos.h>
  #include <proto/dos.h>
  #include <stdio.h>  /* Required for gets, fgets, stdin, etc. */
@@ -42,11 +44,11 @@
      char buffer[256];
      char *src = "Hello World";
  
-     /* $CODEX: The next line should trigger a strcpy warning */
+     /* $CODEX: The next line should trigger a warning: Memory-unsafe function 'strcpy' found */
      strcpy(buffer, src);
-     /* $CODEX: The next line should trigger a strcat warning */
+     /* $CODEX: The next line should trigger a warning: Memory-unsafe function 'strcat' found */
      strcat(buffer, " more text");
-     /* $CODEX: The next line should trigger a sprintf warning */
+     /* $CODEX: The next line should trigger a warning: Memory-unsafe function 'sprintf' found */
      sprintf(buffer, "%s", src);
  }
  
@@ -56,11 +58,11 @@
      char *filename;
      char *path;
  
-     /* $CODEX: The next line should trigger a tmpnam warning */
+     /* $CODEX: The next line should trigger a warning: Memory-unsafe function 'tmpnam' found */
      filename = tmpnam(NULL);
-     /* $CODEX: The next line should trigger a realpath warning */
+     /* $CODEX: The next line should trigger a warning: Unsafe use of 'realpath' suspected */
      path = realpath("/tmp", NULL);
-     /* $CODEX: The next line should trigger a gets warning */
+     /* $CODEX: The next line should trigger a warning: Memory-unsafe function 'gets' found */
      gets(buffer);
  }
  
@@ -69,16 +71,16 @@
      char str[] = "hello,world,test";
      char *token;
  
-     /* $CODEX: The next line should trigger a strtok warning */
+     /* $CODEX: The next line should trigger a warning: Memory-unsafe function 'strtok' found */
      token = strtok(str, ",");
  }
  
  void memsafe_violation4(void)
  {
      int num;
-     /* $CODEX: The next line should trigger a scanf warning */
+     /* $CODEX: The next line should trigger a warning: Unsafe use of 'scanf' suspected */
      scanf("%d", &num);
-     /* $CODEX: The next line should trigger a sscanf warning */
+     /* $CODEX: The next line should trigger a warning: Unsafe use of 'sscanf' suspected */
      sscanf("12345", "%d", &num);
  }
  
@@ -123,7 +125,7 @@
      int num;
      int result;
  
-     /* $CODEX: The next line should trigger a scanf warning */
+     /* $CODEX: The next line should trigger a warning: Unsafe use of 'scanf' suspected */
      result = scanf("%10d", &num);
      if (result == 1) {
          /* Success */
@@ -30,39 +30,41 @@
  * This tests SAS/C compiler compatibility features.
  */
 
+/* $CODEX: MODES VBCC */
+
 #include <dos/dos.h>
 #include <proto/dos.h>
 
-/* SAS/C specific keywords that should trigger VBCC compatibility warnings */
-__saveds void sasc_function1(void) /* $CODEX: This should trigger a warning: Use __SAVE_DS__ for universal syntax */
+/* SAS/C specific keywords; VBCC mode flags only those VBCC does not accept */
+__saveds void sasc_function1(void) /* $CODEX: This should trigger a warning: Keyword '__saveds' is incompatible with VBCC */
 {
     /* SAS/C calling convention */
-    __asm("nop"); /* $CODEX: This should trigger a warning: Use __ASM__ for universal syntax */
+    __asm("nop"); /* $CODEX: Should NOT trigger - VBCC accepts __asm */
 }
 
-__save_ds void sasc_function2(void) /* $CODEX: This should trigger a warning: Use __SAVE_DS__ for universal syntax */
+__save_ds void sasc_function2(void) /* $CODEX: This should trigger a warning: Keyword '__save_ds' is incompatible with VBCC */
 {
     /* SAS/C data segment saving */
-    __reg("d0", int value) = 42; /* $CODEX: This should trigger a warning: Use __REG__ for universal syntax */
+    __reg("d0", int value) = 42; /* $CODEX: Should NOT trigger - VBCC accepts __reg */
 }
 
-__stdargs void sasc_function3(void) /* $CODEX: This should trigger a warning: Use __STDARGS__ for universal syntax */
+__stdargs void sasc_function3(void) /* $CODEX: Should NOT trigger - VBCC accepts __stdargs */
 {
     /* SAS/C standard argument passing */
-    __far char *ptr = NULL; /* $CODEX: This should trigger a warning: Use __FAR__ for universal syntax */
+    __far char *ptr = NULL; /* $CODEX: Should NOT trigger - VBCC accepts __far */
 }
 
-__interrupt void sasc_interrupt_handler(void) /* $CODEX: This should trigger a warning: Use __INTERRUPT__ for universal syntax */
+__interrupt void sasc_interrupt_handler(void) /* $CODEX: Should NOT trigger - VBCC accepts __interrupt */
 {
     /* SAS/C interrupt handler */
-    __chip char buffer[256]; /* $CODEX: This should trigger a warning: Use __CHIP__ for universal syntax */
-    __fast int counter = 0; /* $CODEX: This should trigger a warning: Use __FAST__ for universal syntax */
+    __chip char buffer[256]; /* $CODEX: Should NOT trigger - VBCC accepts __chip */
+    __fast int counter = 0; /* $CODEX: Should NOT trigger - VBCC accepts __fast */
 }
 
-__amigainterrupt void sasc_amiga_interrupt_handler(void) /* $CODEX: This should trigger a warning: Use __INTERRUPT__ for universal syntax */
+__amigainterrupt void sasc_amiga_interrupt_handler(void) /* $CODEX: Should NOT trigger - VBCC accepts __amigainterrupt */
 {
     /* VBCC Amiga-specific interrupt handler (should flag in SAS/C mode) */
-    __chip char buffer[128]; /* $CODEX: This should trigger a warning: Use __CHIP__ for universal syntax */
+    __chip char buffer[128]; /* $CODEX: Should NOT trigger - VBCC accepts __chip */
 }
 
 /* Universal syntax that should NOT trigger warnings */
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Test file for STACKCHECK/S
+ * A call chain from main() that outgrows the $STACK cookie, a recursive
+ * call and a function main() never reaches.
+ */
+
+/* $CODEX: MODES C89 STACKCHECK */
+
+#include <exec/types.h>
+
+#define NAME_LENGTH 64
+#define PATH_LENGTH (NAME_LENGTH * 4)
+#define ENTRY_COUNT 8
+
+static const char stack_cookie[] = "$STACK: 1024";
+
+struct Entry {
+    char name[NAME_LENGTH];
+    ULONG size;
+};
+
+static LONG SumSizes(const struct Entry *entries, LONG count);
+static LONG ScanDirectory(const char *path, LONG depth);
+static void PrintReport(void);
+
+static LONG SumSizes(const struct Entry *entries, LONG count)
+{
+    LONG total = 0;
+    LONG i;
+
+    for (i = 0; i < count; i++) {
+        total += (LONG)entries[i].size;
+    }
+    return total;
+}
+
+static LONG ScanDirectory(const char *path, LONG depth)
+{
+    struct Entry entries[ENTRY_COUNT];
+    char child[PATH_LENGTH];
+    LONG total;
+
+    child[0] = path[0];
+    child[1] = '\0';
+    total = SumSizes(entries, ENTRY_COUNT);
+    if (depth > 0) {
+        total += ScanDirectory(child, depth - 1); /* $CODEX: The next call should trigger an unbounded recursion warning: Recursive call to 'ScanDirectory' */
+    }
+    return total;
+}
+
+/* $CODEX: Should NOT trigger - main() never calls it, so its frame does not count */
+static void PrintReport(void)
+{
+    char report[PATH_LENGTH * ENTRY_COUNT];
+
+    report[0] = '\0';
+}
+
+/* $CODEX: The next line should trigger a warning that the stack depth exceeds "the 1024 byte stack set by $STACK" */
+int main(int argc, char **argv)
+{
+    char line[PATH_LENGTH];
+
+    line[0] = stack_cookie[0];
+    return (int)ScanDirectory(line, ENTRY_COUNT);
+}
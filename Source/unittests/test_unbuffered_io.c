@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2026 amigazen project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Test file for the unbuffered DOS I/O loop rule in AMIGA mode.
+ * Read() and Write() of a few bytes on every pass of a loop.
+ */
+
+/* $CODEX: MODES AMIGA */
+
+#include <exec/types.h>
+#include <dos/dos.h>
+#include <proto/dos.h>
+
+#define BLOCK_SIZE 4096
+#define RECORD_LENGTH 512
+
+static UBYTE block[BLOCK_SIZE];
+
+LONG CountLines(BPTR file)
+{
+    LONG lines = 0;
+    UBYTE c;
+
+    while (Read(file, &c, 1) == 1) /* $CODEX: Should trigger "Read() of 1 byte" - one byte per pass in the condition */
+    {
+        if (c == '\n') lines++;
+    }
+    return lines;
+}
+
+VOID CopyBytes(BPTR from, BPTR to, LONG total)
+{
+    UBYTE c;
+    LONG i;
+
+    for (i = 0; i < total; i++)
+    {
+        Read(from, &c, sizeof(UBYTE)); /* $CODEX: Should trigger "Read() of 1 byte" - sizeof(UBYTE) per pass */
+        Write(to, &c, sizeof (UBYTE)); /* $CODEX: Should trigger "Write() of 1 byte" - sizeof (UBYTE) per pass */
+    }
+}
+
+VOID CopyBlocks(BPTR from, BPTR to)
+{
+    LONG length;
+
+    while ((length = Read(from, block, BLOCK_SIZE)) > 0) /* $CODEX: Should NOT trigger - a whole block per pass */
+    {
+        Write(to, block, length); /* $CODEX: Should NOT trigger - length is not a constant */
+    }
+    Write(to, block, RECORD_LENGTH); /* $CODEX: Should NOT trigger - outside any loop */
+}
+
+VOID WriteHeader(BPTR to)
+{
+    UBYTE c = 'A';
+
+    Write(to, &c, 1); /* $CODEX: Should NOT trigger - outside any loop */
+}
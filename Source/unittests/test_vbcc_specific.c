@@ -30,39 +30,41 @@
  * This tests VBCC compiler compatibility features.
  */
 
+/* $CODEX: MODES SASC */
+
 #include <dos/dos.h>
 #include <proto/dos.h>
 
-/* VBCC specific keywords that should trigger SAS/C compatibility warnings */
-__asm void vbcc_function1(void) /* $CODEX: This should trigger a warning: Use __ASM__ for universal syntax */
+/* VBCC specific keywords; SAS/C mode flags only those SAS/C does not accept */
+__asm void vbcc_function1(void) /* $CODEX: Should NOT trigger - SAS/C accepts __asm */
 {
     /* VBCC inline assembly */
-    __reg("d0", int value) = 42; /* $CODEX: This should trigger a warning: Use __REG__ for universal syntax */
+    __reg("d0", int value) = 42; /* $CODEX: Should NOT trigger - SAS/C accepts __reg */
 }
 
-__interrupt void vbcc_interrupt_handler(void) /* $CODEX: This should trigger a warning: Use __INTERRUPT__ for universal syntax */
+__interrupt void vbcc_interrupt_handler(void) /* $CODEX: Should NOT trigger - SAS/C accepts __interrupt */
 {
     /* VBCC interrupt handler */
-    __chip char buffer[256]; /* $CODEX: This should trigger a warning: Use __CHIP__ for universal syntax */
-    __fast int counter = 0; /* $CODEX: This should trigger a warning: Use __FAST__ for universal syntax */
+    __chip char buffer[256]; /* $CODEX: Should NOT trigger - SAS/C accepts __chip */
+    __fast int counter = 0; /* $CODEX: Should NOT trigger - SAS/C accepts __fast */
 }
 
-__amigainterrupt void vbcc_amiga_interrupt_handler(void) /* $CODEX: This should trigger a warning: Use __INTERRUPT__ for universal syntax */
+__amigainterrupt void vbcc_amiga_interrupt_handler(void) /* $CODEX: This should trigger a warning: Keyword '__amigainterrupt' is incompatible with SAS/C */
 {
     /* VBCC Amiga-specific interrupt handler */
-    __chip char buffer[128]; /* $CODEX: This should trigger a warning: Use __CHIP__ for universal syntax */
+    __chip char buffer[128]; /* $CODEX: Should NOT trigger - SAS/C accepts __chip */
 }
 
-__stdargs void vbcc_function2(void) /* $CODEX: This should trigger a warning: Use __STDARGS__ for universal syntax */
+__stdargs void vbcc_function2(void) /* $CODEX: Should NOT trigger - SAS/C accepts __stdargs */
 {
     /* VBCC standard argument passing */
-    __far char *ptr = NULL; /* $CODEX: This should trigger a warning: Use __FAR__ for universal syntax */
+    __far char *ptr = NULL; /* $CODEX: Should NOT trigger - SAS/C accepts __far */
 }
 
-__saveds void vbcc_function3(void) /* $CODEX: This should trigger a warning: Use __SAVE_DS__ for universal syntax */
+__saveds void vbcc_function3(void) /* $CODEX: Should NOT trigger - SAS/C accepts __saveds */
 {
     /* VBCC calling convention */
-    __asm("nop"); /* $CODEX: This should trigger a warning: Use __ASM__ for universal syntax */
+    __asm("nop"); /* $CODEX: Should NOT trigger - SAS/C accepts __asm */
 }
 
 /* Universal syntax that should NOT trigger warnings */